@@ -35,7 +35,7 @@ public:
                     lock_.unlock();
 
                     // 喚醒接收者，並直接返回
-                    if (g_to_wake) Scheduler::get().push_ready(g_to_wake);
+                    if (g_to_wake) Scheduler::get().push_ready(g_to_wake, WakeSource::Channel);
                     return;
                 }
 
@@ -46,13 +46,22 @@ public:
                     return;
                 }
 
-                // 緩衝區滿了，記錄當前協程，準備掛起
-                send_waiters_.push(Goroutine::current());
                 lock_.unlock();
             }
 
-            // 2. 釋放自旋鎖後，執行協程切換（這才是真正的阻塞）
-            Goroutine::yield();
+            // 2. 緩衝區滿了，釋放自旋鎖後執行協程切換（這才是真正的阻塞）
+            // 切出之後才登記到等待佇列，否則接收方可能在切出之前就把本協程交給另一個 Worker
+            auto self = Goroutine::current();
+            Goroutine::park(ParkReason::Channel, [this, self]() {
+                lock_.lock();
+                if (!recv_waiters_.empty() || buffer_.size() < capacity_ || (capacity_ == 0 && buffer_.empty())) {
+                    lock_.unlock();
+                    Scheduler::get().push_ready(self, WakeSource::Channel);
+                    return;
+                }
+                send_waiters_.push(self);
+                lock_.unlock();
+            });
         }
     }
 
@@ -77,17 +86,25 @@ public:
                     }
                     lock_.unlock();
 
-                    if (g_to_wake) Scheduler::get().push_ready(g_to_wake);
+                    if (g_to_wake) Scheduler::get().push_ready(g_to_wake, WakeSource::Channel);
                     return val;
                 }
 
-                // 緩衝區空了，記錄當前接收協程，準備掛起
-                recv_waiters_.push(Goroutine::current());
                 lock_.unlock();
             }
 
-            // 釋放鎖後掛起，等待 push 操作喚醒
-            Goroutine::yield();
+            // 緩衝區空了，釋放鎖後掛起，等待 push 操作喚醒；同樣切出之後才登記
+            auto self = Goroutine::current();
+            Goroutine::park(ParkReason::Channel, [this, self]() {
+                lock_.lock();
+                if (!buffer_.empty()) {
+                    lock_.unlock();
+                    Scheduler::get().push_ready(self, WakeSource::Channel);
+                    return;
+                }
+                recv_waiters_.push(self);
+                lock_.unlock();
+            });
         }
     }
 
@@ -1,7 +1,12 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <atomic>
 #include <chrono>
+#include <functional>
+#include <utility>
+#include <vector>
 #include "data_structure/channel.h"
 
 namespace runtime {
@@ -25,12 +30,48 @@ namespace runtime {
         void cancel() {
             if (!done_flag_.exchange(true)) {
                 done_chan_->push(1); // 發送結束信號
+                std::vector<std::pair<uint64_t, std::function<void()>>> callbacks;
+                lock_.lock();
+                callbacks.swap(callbacks_);
+                lock_.unlock();
+                for (auto &cb : callbacks) cb.second();
             }
         }
 
+        // 取消時執行 fn（對標 Go 的 context.AfterFunc）；已經取消則立即執行並返回 0
+        // done() 只能被一個協程收到，多個等待方各自登記回調；fn 裡不能再登記或阻塞
+        // 返回的登記號交給 stop_after_done：不再需要回調時撤銷，不會被取消的 ctx 上也不會越積越多
+        uint64_t after_done(std::function<void()> fn) {
+            lock_.lock();
+            if (done_flag_.load()) {
+                lock_.unlock();
+                fn();
+                return 0;
+            }
+            uint64_t id = ++next_id_;
+            callbacks_.emplace_back(id, std::move(fn));
+            lock_.unlock();
+            return id;
+        }
+
+        // 撤銷 after_done 登記的回調；回調已經執行或正在執行返回 false（對標 AfterFunc 返回的 stop）
+        bool stop_after_done(uint64_t id) {
+            if (id == 0) return false;
+            lock_.lock();
+            auto it = std::find_if(callbacks_.begin(), callbacks_.end(),
+                                   [id](const auto &cb) { return cb.first == id; });
+            bool found = it != callbacks_.end();
+            if (found) callbacks_.erase(it);
+            lock_.unlock();
+            return found;
+        }
+
     private:
         std::shared_ptr<Channel<int>> done_chan_;
         std::atomic<bool> done_flag_;
+        runtime::Spinlock lock_;
+        uint64_t next_id_ = 0;
+        std::vector<std::pair<uint64_t, std::function<void()>>> callbacks_;
     };
 
 } // namespace runtime
\ No newline at end of file
@@ -0,0 +1,234 @@
+#pragma once
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "data_structure/context.h"
+#include "runtime/goroutine.h"
+#include "runtime/scheduler.h"
+#include "runtime/spinlock.h"
+#include "runtime/tracer.h"
+
+namespace runtime {
+
+    /**
+     * @brief 合并同一个 key 上的重复工作（對標 Go 的 singleflight.Group）
+     * 第一个调用方执行 fn，同时到达的其他调用方挂起，拿到同一份结果或同一个异常。
+     * ttl_ms > 0 时成功的结果再保留这么久，期间的调用直接返回；异常不缓存。
+     * 按 key 哈希分片，每个分片一把自旋锁，不同 key 之间不互相阻塞。
+     *
+     *     static runtime::SingleFlight<std::string, bool> tokens(5000);
+     *     bool ok = tokens.run(token, [&] { return verify_token(token); });
+     *
+     * 结果按值返回给每个调用方，大对象用 shared_ptr<const X> 作为 T。
+     * 对象必须比所有进行中的调用活得久（通常是 static）。
+     */
+    template<typename Key, typename T, typename Hash = std::hash<Key>>
+    class SingleFlight {
+    public:
+        explicit SingleFlight(int ttl_ms = 0, size_t shards = 16)
+            : ttl_ns_(static_cast<int64_t>(std::max(ttl_ms, 0)) * 1000000),
+              shards_(std::max<size_t>(shards, 1)) {}
+
+        SingleFlight(const SingleFlight&) = delete;
+        SingleFlight& operator=(const SingleFlight&) = delete;
+
+        /**
+         * @brief 执行或等待 key 上的 fn，返回共享的结果；fn 抛出的异常在每个调用方重新抛出
+         * 第一个调用方在自己的协程里执行 fn
+         */
+        template<typename Fn>
+        T run(const Key &key, Fn &&fn) {
+            auto [call, leader] = acquire(key);
+            if (leader) {
+                execute(key, call, fn);
+            } else if (!finished(*call)) {
+                wait(call, nullptr);
+            }
+            return result(*call);
+        }
+
+        /**
+         * @brief 带取消的版本：ctx 结束时只有这个调用方提前返回 std::nullopt
+         * fn 放到单独的协程里执行，发起者超时也不会打断它，其他调用方照常拿到结果。
+         * 因此 fn 可能比发起者的栈帧活得久：捕获必须按值或持有所有权（shared_ptr），
+         * 不能用 [&] 或捕获局部变量的引用、指针，否则发起者超时返回后 fn 读到的是已经释放的栈。
+         *
+         *     auto n = flight.run(key, ctx, [key] { return load_from_db(key); }); // key 按值捕获
+         */
+        template<typename Fn>
+        std::optional<T> run(const Key &key, const Context::Ptr &ctx, Fn &&fn) {
+            if (ctx && ctx->is_done()) return std::nullopt;
+            auto [call, leader] = acquire(key);
+            if (leader) {
+                // 拷贝或移动一份 fn 交给新协程；引用捕获在类型上看不出来，只能靠上面的约定
+                auto task = std::make_shared<std::decay_t<Fn>>(std::forward<Fn>(fn));
+                go([this, key, call, task]() { execute(key, call, *task); });
+            } else if (finished(*call)) {
+                return result(*call);
+            }
+            if (!wait(call, ctx)) return std::nullopt;
+            return result(*call);
+        }
+
+        // 丢掉 key 上缓存的结果；进行中的调用照常完成，但之后的调用会重新执行
+        void forget(const Key &key) {
+            Shard &shard = shard_for(key);
+            shard.lock.lock();
+            shard.calls.erase(key);
+            shard.lock.unlock();
+        }
+
+    private:
+        struct Waiter {
+            Goroutine::Ptr g; // 非空表示已经挂起等待
+            bool cancelled = false;
+        };
+
+        struct Call {
+            Spinlock lock;
+            bool done = false;
+            std::optional<T> value;
+            std::exception_ptr error;
+            std::vector<std::shared_ptr<Waiter>> waiters;
+            int64_t expires_ns = 0;
+        };
+
+        struct Shard {
+            Spinlock lock;
+            std::unordered_map<Key, std::shared_ptr<Call>, Hash> calls;
+            size_t sweep_at = 64; // 表长到这里时顺手清掉过期的结果
+        };
+
+        Shard &shard_for(const Key &key) {
+            return shards_[Hash{}(key) % shards_.size()];
+        }
+
+        // 返回 key 上的调用；第二项为 true 表示由调用方负责执行
+        std::pair<std::shared_ptr<Call>, bool> acquire(const Key &key) {
+            Shard &shard = shard_for(key);
+            shard.lock.lock();
+            auto it = shard.calls.find(key);
+            if (it != shard.calls.end()) {
+                std::shared_ptr<Call> call = it->second;
+                // done 只在持有分片锁时由进行中变为完成，这里读到的是确定的状态
+                if (!call->done || trace_now_ns() < call->expires_ns) {
+                    shard.lock.unlock();
+                    return {std::move(call), false};
+                }
+                shard.calls.erase(it);
+            }
+            if (ttl_ns_ > 0 && shard.calls.size() >= shard.sweep_at) sweep(shard);
+            auto call = std::make_shared<Call>();
+            shard.calls.emplace(key, call);
+            shard.lock.unlock();
+            return {std::move(call), true};
+        }
+
+        void sweep(Shard &shard) {
+            int64_t now = trace_now_ns();
+            for (auto it = shard.calls.begin(); it != shard.calls.end();) {
+                if (it->second->done && it->second->expires_ns <= now) {
+                    it = shard.calls.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            shard.sweep_at = std::max<size_t>(64, shard.calls.size() * 2);
+        }
+
+        template<typename Fn>
+        void execute(const Key &key, const std::shared_ptr<Call> &call, Fn &fn) {
+            try {
+                call->value.emplace(fn());
+            } catch (...) {
+                call->error = std::current_exception();
+            }
+
+            Shard &shard = shard_for(key);
+            shard.lock.lock();
+            auto it = shard.calls.find(key);
+            bool mine = it != shard.calls.end() && it->second == call;
+            if (ttl_ns_ > 0 && !call->error) {
+                call->expires_ns = trace_now_ns() + ttl_ns_;
+            } else if (mine) {
+                shard.calls.erase(it);
+            }
+            std::vector<std::shared_ptr<Waiter>> waiters;
+            call->lock.lock();
+            call->done = true;
+            waiters.swap(call->waiters);
+            call->lock.unlock();
+            shard.lock.unlock();
+
+            for (auto &w : waiters) {
+                // 取消回调与这里互斥地取走 g，每个等待者只被唤醒一次
+                call->lock.lock();
+                Goroutine::Ptr g = std::move(w->g);
+                call->lock.unlock();
+                if (g) Scheduler::get().push_ready(std::move(g), WakeSource::Channel);
+            }
+        }
+
+        // 挂起直到调用完成；ctx 先结束返回 false
+        bool wait(const std::shared_ptr<Call> &call, const Context::Ptr &ctx) {
+            auto w = std::make_shared<Waiter>();
+            uint64_t cancel_id = 0;
+            if (ctx) {
+                // 回调可能在任意线程、在本次等待结束之后才执行，只持有弱引用
+                std::weak_ptr<Call> weak = call;
+                cancel_id = ctx->after_done([weak, w]() {
+                    auto c = weak.lock();
+                    if (!c) return;
+                    c->lock.lock();
+                    w->cancelled = true;
+                    Goroutine::Ptr g = std::move(w->g);
+                    // 完成方可能已经把等待列表整体取走，只是还没轮到唤醒这个
+                    auto it = std::find(c->waiters.begin(), c->waiters.end(), w);
+                    if (it != c->waiters.end()) c->waiters.erase(it);
+                    c->lock.unlock();
+                    if (g) Scheduler::get().push_ready(std::move(g), WakeSource::Channel);
+                });
+            }
+
+            auto self = Goroutine::current();
+            // 切出之后再登记，完成方或取消方看到 g 才唤醒
+            Goroutine::park(ParkReason::Channel, [&call, &w, &self]() {
+                call->lock.lock();
+                if (call->done || w->cancelled) {
+                    call->lock.unlock();
+                    Scheduler::get().push_ready(self, WakeSource::Channel);
+                    return;
+                }
+                w->g = self;
+                call->waiters.push_back(w);
+                call->lock.unlock();
+            });
+
+            // 等完了就撤销回调，ctx 活得再久也不会攒下每次等待的登记
+            if (ctx) ctx->stop_after_done(cancel_id);
+            return finished(*call);
+        }
+
+        static bool finished(Call &call) {
+            call.lock.lock();
+            bool done = call.done;
+            call.lock.unlock();
+            return done;
+        }
+
+        static T result(const Call &call) {
+            if (call.error) std::rethrow_exception(call.error);
+            return *call.value;
+        }
+
+        int64_t ttl_ns_;
+        std::vector<Shard> shards_;
+    };
+
+} // namespace runtime
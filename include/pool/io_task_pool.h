@@ -8,12 +8,17 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <memory>
 #include <string>
+#include <string_view>
 
 namespace gee {
     struct IOTask {
         std::string path;
-        std::string data;
+        std::shared_ptr<const void> owner; // 持有 data 所在的内存，多个任务可以共享同一块缓冲区
+        std::string_view data;
         bool should_fsync;
     };
 
@@ -31,9 +36,16 @@ namespace gee {
 
         //  Worker 协程调用
         void addTask(std::string path, std::string &&data, bool fsync = false) {
+            auto owner = std::make_shared<std::string>(std::move(data));
+            std::string_view view(*owner);
+            addTask(std::move(path), std::move(owner), view, fsync);
+        }
+
+        // 按引用投递：data 指向 owner 持有的内存，写完之前 owner 不会释放，调用方不必拷贝
+        void addTask(std::string path, std::shared_ptr<const void> owner, std::string_view data, bool fsync = false) {
             {
                 std::lock_guard<std::mutex> lock(queue_mutex_);
-                tasks_.push({std::move(path), std::move(data), fsync});
+                tasks_.push({std::move(path), std::move(owner), data, fsync});
             }
             condition_.notify_one();
         }
@@ -80,11 +92,28 @@ namespace gee {
         }
 
         void execute_task(const IOTask &task) {
+            // 同一个文件的连续分片复用打开的文件，不再每块都解析路径、建目录、重新 open
+            if (!ofs_.is_open() || task.path != open_path_) {
+                if (!open_file(task.path)) return;
+            }
+
+            ofs_.write(task.data.data(), static_cast<std::streamsize>(task.data.size()));
+            if (task.should_fsync) {
+                // 文件的最后一块：刷出并关闭
+                ofs_.flush();
+                ofs_.close();
+                open_path_.clear();
+            }
+        }
+
+        bool open_file(const std::string &path) {
             namespace fs = std::filesystem;
             std::error_code ec;
+            if (ofs_.is_open()) ofs_.close();
+            open_path_.clear();
 
             // 1. 强制转换成绝对路径，彻底消除“相对路径”在哪里的困惑
-            fs::path abs_path = fs::absolute(task.path);
+            fs::path abs_path = fs::absolute(path);
             fs::path dir = abs_path.parent_path();
 
             // 2. 自动建目录：既然只有一个线程，这里绝对不会有冲突
@@ -92,27 +121,19 @@ namespace gee {
                 fs::create_directories(dir, ec);
                 if (ec) {
                     std::cerr << "[IO_ERROR] 无法创建目录: " << dir << " | 原因: " << ec.message() << std::endl;
-                    return;
+                    return false;
                 }
                 std::cout << "[IO_DEBUG] 成功创建目录: " << dir << std::endl;
             }
 
-            // 3. 写入逻辑
-            // 关键：观察这里打印出来的路径，那是文件在磁盘上的真实坐标！
-            std::cout << "[IO_DEBUG] 正在写入文件: " << abs_path << " | 大小: " << task.data.size() << " bytes" << std::endl;
-
-            std::ofstream ofs(abs_path, std::ios::binary | std::ios::app);
-            if (ofs.is_open()) {
-                ofs.write(task.data.data(), static_cast<std::streamsize>(task.data.size()));
-                if (task.should_fsync) {
-                    ofs.flush();
-                }
-                ofs.close();
-                std::cout << "[IO_DEBUG] 写入完成 (Success)!" << std::endl;
-            } else {
+            ofs_.open(abs_path, std::ios::binary | std::ios::app);
+            if (!ofs_.is_open()) {
                 // 如果失败，打印出系统级别的错误码
                 std::cerr << "[IO_ERROR] 无法打开文件: " << abs_path << " | 错误原因: " << strerror(errno) << std::endl;
+                return false;
             }
+            open_path_ = path;
+            return true;
         }
 
         std::vector<std::thread> workers_;
@@ -120,6 +141,10 @@ namespace gee {
         std::mutex queue_mutex_;
         std::condition_variable condition_;
         bool stop_;
+
+        // 只在 IO 线程里访问
+        std::ofstream ofs_;
+        std::string open_path_;
     };
 } // namespace gee
 
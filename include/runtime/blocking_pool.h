@@ -0,0 +1,39 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace runtime {
+    /**
+     * @brief 阻塞型系统调用（open/stat/mmap 等）的专用线程池
+     * 协程调用 run() 后挂起，任务在池线程上执行完再把协程放回就绪队列，
+     * 调度器的 Worker 不会被磁盘 IO 卡住
+     */
+    class BlockingPool {
+    public:
+        static BlockingPool &get();
+
+        BlockingPool(const BlockingPool &) = delete;
+
+        BlockingPool &operator=(const BlockingPool &) = delete;
+
+        ~BlockingPool();
+
+        // 在池线程上执行 fn 并等待完成；不在协程里调用时直接在当前线程执行
+        void run(const std::function<void()> &fn);
+
+    private:
+        explicit BlockingPool(size_t thread_count);
+
+        void submit(std::function<void()> job);
+
+        std::vector<std::thread> workers_;
+        std::queue<std::function<void()> > jobs_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        bool stop_ = false;
+    };
+}
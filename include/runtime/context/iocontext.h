@@ -7,6 +7,8 @@ namespace runtime {
         int fd;
         IOType type;
         Goroutine::Ptr waiting_g; // 核心：不管是 DB 还是 Web，都需要唤醒协程
+        // 等可写的协程单独存放：HTTP/2 连接的读协程和写协程会同时挂在同一个 fd 上
+        Goroutine::Ptr waiting_write_g;
 
         virtual ~IOContextBase() = default;
         IOContextBase(int f, IOType t) : fd(f), type(t) {}
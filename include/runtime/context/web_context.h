@@ -1,47 +1,88 @@
 #pragma once
 #include "iocontext.h"
 #include "web/protocol/request.h"
+#include "web/protocol/body_reader.h"
 #include "web/protocol/response.h"
+#include "web/protocol/output_queue.h"
+#include "web/protocol/json_writer.h"
+#include "web/protocol/json_reader.h"
+#include "web/protocol/response_stream.h"
+#include "web/protocol/websocket.h"
+#include "web/core/router.h"
+#include "web/core/admission.h"
 #include <string>
 #include <stdexcept>
 #include "../src/db/db.h"
 
 namespace gee {
-    class WebContext;
-    using HandlerFunc = std::function<void(WebContext *)>;
-
     struct WebContext : public runtime::IOContextBase {
         gee::Request req_;
+        // 流式读取请求体，状态随请求重置
+        gee::BodyReader body_;
         gee::Response res_;
-
-        std::vector<HandlerFunc> handlers_;
+        // 响应先进连接级队列，由连接循环决定何时 writev，流水线请求可以合批发送
+        gee::OutputQueue out_;
+
+        // 指向路由上预先拼好的执行链，请求之间共享，只读
+        const HandlersChain *handlers_ = nullptr;
+        // 路由参数，视图指向请求 path
+        gee::Params params_;
+        // Stream() 创建，请求结束时由连接循环收尾
+        std::unique_ptr<gee::ResponseStream> stream_;
         // 记录当前执行到了第几个 Handler，初始为 -1
         int index_;
+        // 准入控制的在途名额，请求结束时归还
+        gee::AdmissionController *admission_ = nullptr;
+        int64_t admitted_at_ns_ = 0;
+        // ClientIP() 的缓存，属于连接，reset 时不清空
+        std::string peer_ip_;
 
         WebContext(int f)
-            : runtime::IOContextBase(f, runtime::IOType::WEB), index_(-1) {
+            : runtime::IOContextBase(f, runtime::IOType::WEB), body_(req_, f, &params_), index_(-1) {
+        }
+
+        // 复用连接时重置为处理下一个请求的状态
+        void reset() {
+            req_.reset();
+            body_.reset();
+            res_ = gee::Response();
+            handlers_ = nullptr;
+            params_.clear();
+            stream_.reset();
+            index_ = -1;
+        }
+
+        void admit(gee::AdmissionController *ac) {
+            admission_ = ac;
+            admitted_at_ns_ = runtime::trace_now_ns();
+        }
+
+        // 归还在途名额；升级成长连接（WebSocket、SSE）时提前归还，sample 为 false 不计入延迟统计
+        void release_admission(bool sample) {
+            if (!admission_) return;
+            admission_->release(sample ? runtime::trace_now_ns() - admitted_at_ns_ : -1);
+            admission_ = nullptr;
         }
 
         void Next() {
             index_++;
-            int s = static_cast<int>(handlers_.size());
+            const HandlersChain &chain = *handlers_;
+            int s = static_cast<int>(chain.size());
             for (; index_ < s; index_++) {
-                handlers_[index_](this);
+                chain[index_](this);
             }
         }
 
         void Abort() {
-            index_ = static_cast<int>(handlers_.size());
+            index_ = handlers_ ? static_cast<int>(handlers_->size()) : 0;
         }
 
         bool is_aborted() const {
-            return index_ >= static_cast<int>(handlers_.size());
+            return !handlers_ || index_ >= static_cast<int>(handlers_->size());
         }
 
-        void set_params(std::unordered_map<std::string, std::string> params);
-
-        // 业务层调用：ctx->Param("userId")
-        std::string Param(const std::string &key);
+        // 业务层调用：ctx->Param("userId")，返回的视图在本请求结束前有效
+        std::string_view Param(std::string_view key) const { return params_.get(key); }
 
         std::string Query(const std::string &key);
 
@@ -63,22 +104,52 @@ namespace gee {
         typename std::enable_if<std::is_base_of<db::Model, T>::value>::type
         JSON(gee::StateCode code, const std::string &msg, const std::vector<T> &models) {
             std::string body;
-            if (models.empty()) {
-                body = "[]";
-            } else {
-                // 极致性能：预分配内存 (按你之前的 120 字节估算)
-                body.reserve(models.size() * 120 + 2);
-                body.push_back('[');
-                for (size_t i = 0; i < models.size(); ++i) {
-                    models[i].write_json(body);
-                    if (i + 1 < models.size()) body.push_back(',');
-                }
-                body.push_back(']');
-            }
+            // 极致性能：预分配内存 (按你之前的 120 字节估算)
+            body.reserve(models.size() * 120 + 2);
+            gee::JsonWriter w(body);
+            w.begin_array();
+            for (const auto &m: models) gee::write_model(w, m);
+            w.end_array();
             res_.set_raw_data(static_cast<int>(code), msg, std::move(body));
             this->send_response(static_cast<int>(code));
         }
 
+        /**
+         * @brief 开始一个分块流式响应，Header 立即入队；重复调用返回同一个流
+         * 适合大结果集：边生成边发送，内存占用只有一个 chunk
+         */
+        gee::ResponseStream &Stream(int http_code = 200,
+                                    std::string_view type_line = gee::kJsonContentType,
+                                    size_t flush_bytes = gee::ResponseStream::kDefaultFlushBytes);
+
+        /**
+         * @brief 开始一个 Server-Sent Events 响应（text/event-stream），Header 立即发出
+         * 不压缩，写入的每个事件立即发送；一对多推送用 gee::Broadcaster
+         */
+        gee::ResponseStream &SSE();
+
+        /**
+         * @brief 以 {state,message,data:[...]} 外壳流式输出一组 Model，逐条序列化、按阈值分块发送
+         * @return false 表示客户端断开或写失败，调用方可以提前停止查询
+         */
+        template<typename Range>
+        bool StreamJSON(gee::StateCode code, const std::string &msg, const Range &models) {
+            res_.state = static_cast<int>(code);
+            res_.message = msg;
+            gee::ResponseStream &s = Stream(static_cast<int>(code));
+            res_.append_envelope_prefix(s.buffer(), true);
+            // 写入器只记逗号状态，flush 清空缓冲区不影响它
+            gee::JsonWriter w(s.buffer());
+            w.begin_array();
+            for (const auto &m: models) {
+                gee::write_model(w, m);
+                if (!s.commit()) return false;
+            }
+            w.end_array();
+            s.buffer().push_back('}');
+            return s.end();
+        }
+
         /**
          * @brief 发送纯文本/HTML 响应 (例如 404)
          */
@@ -88,13 +159,56 @@ namespace gee {
         std::string_view method() const { return req_.method; }
         std::string_view path() const { return req_.path; }
 
+        // 对端 IP，每个连接只调一次 getpeername；经过反向代理时应改看 X-Forwarded-For 等 Header
+        std::string_view ClientIP();
+
 
         //post表单
         std::string PostForm(const std::string &key);
 
-        // 获取原始 Body (用于 JSON 等)
+        // 获取原始 Body (用于 JSON 等)；流式 Body 在这里一次性读进内存，超过上限返回空
         std::string_view Body();
 
+        /**
+         * @brief 流式读取请求体，分块编码边读边解码，数据未到时挂起协程
+         * 适合大上传（NDJSON、CSV 导入）：内存占用只有调用方的 buf。
+         * 客户端带 Expect: 100-continue 时，第一次调用会先回复 100 Continue。
+         */
+        gee::BodyReader &BodyReader();
+
+        /**
+         * @brief 把 JSON 请求体直接绑定到声明了 json_fields() 的结构体
+         * 按需解析，不建 DOM；Body 不是合法 UTF-8 / JSON 或类型不符时返回空，
+         * 出错原因与位置记在日志里
+         */
+        template<typename T>
+        std::optional<T> BindJSON() {
+            std::string_view body = Body();
+            if (!gee::JsonReader::valid_utf8(body)) {
+                log_bind_error("body is not valid UTF-8", 0);
+                return std::nullopt;
+            }
+            gee::JsonReader r(body);
+            T out{};
+            if (!gee::json_read(r, out) || !r.end()) {
+                log_bind_error(r.error(), r.offset());
+                return std::nullopt;
+            }
+            return out;
+        }
+
+        void log_bind_error(const char *what, size_t offset) const;
+
+        /**
+         * @brief 把当前 HTTP/1.1 连接升级为 WebSocket，握手成功后在本协程里运行 handler
+         * handler 返回后发送 Close 帧并关闭连接；握手不合法回 400（版本不对回 426）。
+         * 升级后请求头搬离读缓冲区，Param / Query 仍可在 handler 里使用。
+         */
+        void UpgradeWebSocket(const gee::WSHandler &handler, const gee::WebSocketConfig &config = {});
+
         ssize_t web_write(int fd, const char* data, size_t len);
+
+        // 把排队的响应写到 socket
+        bool flush() { return out_.flush(this->fd); }
     };
 }
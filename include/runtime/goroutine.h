@@ -3,6 +3,9 @@
 #include <atomic>
 #include <functional>
 #include <memory>
+#include <string_view>
+
+#include "runtime/tracer.h"
 
 namespace runtime {
     namespace ctx = boost::context;
@@ -17,7 +20,15 @@ namespace runtime {
 
         void resume();
 
-        static void yield();
+        // reason 仅用于追踪：记录协程为什么让出 CPU
+        static void yield(ParkReason reason = ParkReason::Yield);
+
+        /**
+         * @brief 让出 CPU，并在协程真正切出之后由所在 Worker 执行 hook
+         * 需要把自己交给别的线程唤醒时（例如重新入队），放在 hook 里做，
+         * 避免还没切出去就被另一个 Worker resume
+         */
+        static void park(ParkReason reason, std::function<void()> hook);
 
         // TLS 机制：获取当前线程正在执行的协程
         static Goroutine::Ptr current();
@@ -25,12 +36,29 @@ namespace runtime {
         bool is_finished() const { return finished_.load(); }
         uint64_t id() const { return id_; }
 
+        // 追踪标签（通常是路由 pattern），调用方保证其生命周期
+        void set_trace_tag(std::string_view tag) { trace_tag_ = tag; }
+        std::string_view trace_tag() const { return trace_tag_; }
+
+        // 进入就绪队列的时间点，供追踪与排队时间统计
+        void mark_ready() { ready_since_ns_ = trace_now_ns(); }
+
+        // 最近一次被唤醒后在就绪队列里等了多久（纳秒），过载时按它卸载请求
+        int64_t queued_ns() const { return queued_ns_; }
+
     private:
         uint64_t id_;
         ctx::fiber ctx_;
         std::atomic<bool> finished_{false};
         Task task_;
 
+        std::function<void()> after_park_;
+
+        std::string_view trace_tag_;
+        ParkReason park_reason_ = ParkReason::Yield;
+        int64_t ready_since_ns_ = 0;
+        int64_t queued_ns_ = 0;
+
         static std::atomic<uint64_t> s_id_gen;
     };
 
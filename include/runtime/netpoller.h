@@ -1,6 +1,8 @@
 #pragma once
 #include <sys/event.h>
+#include <atomic>
 #include <map>
+#include <mutex>
 #include <memory>
 #include <string>
 
@@ -27,17 +29,23 @@ namespace runtime {
 
         void poll_loop();
 
+        // 让 poll_loop 返回（EVFILT_USER 唤醒），由 Scheduler::stop 调用
+        void stop();
+
         void watch_read_web(int fd, Goroutine::Ptr g);
 
+        // fd 关闭前调用：释放它的等待上下文，编号被新连接复用时从头开始；还挂在上面的协程会被唤醒
+        void forget(int fd);
+
 
 
 
     private:
         int kq_fd_;
+        std::atomic<bool> stopping_{false};
         // 必须使用 mutex 保护 contexts_，因为 watch 可能由不同 Worker 线程调用
         std::mutex mtx_;
         std::map<int, std::unique_ptr<IOContextBase>> contexts_;
-        runtime::Spinlock lock_;
     };
 
 } // namespace runtime
\ No newline at end of file
@@ -26,19 +26,27 @@ namespace runtime {
     public:
         static Scheduler& get();
         void start(size_t thread_count = std::thread::hardware_concurrency());
-        void push_ready(Goroutine::Ptr g);
+        // source 仅用于追踪：记录是谁唤醒了协程
+        void push_ready(Goroutine::Ptr g, WakeSource source = WakeSource::Unknown);
 
         // 核心：添加定时器
         void add_timer(int ms, Goroutine::Ptr g, std::function<void()> cb = nullptr);
 
+        /**
+         * @brief 停止调度：Worker 跑完就绪队列后退出，再停掉 netpoller 线程并等它们结束
+         * 仍挂起的协程不会再被唤醒；可重复调用，析构时也会调用
+         */
+        void stop();
+
         ~Scheduler();
 
     private:
-        Scheduler() = default;
+        Scheduler();
         void worker_loop();
         void check_timers(); // 检查是否有协程该起床了
 
         std::vector<std::thread> workers_;
+        std::thread io_thread_;
         std::queue<Goroutine::Ptr> ready_queue_;
 
         // 定时器相关
@@ -52,5 +60,6 @@ namespace runtime {
 
     void go(Goroutine::Task task);
     void sleep(int ms); // 协程版 sleep 声明
+    void yield_now(); // 让出 CPU 并立即重新排队，类似 Go 的 runtime.Gosched
 
 } // namespace runtime
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace runtime {
+    class Goroutine;
+
+    // 协程生命周期事件
+    enum class TraceEvent : uint8_t {
+        Spawn,
+        Resume,
+        Park,
+        Wake,
+        Finish
+    };
+
+    // 协程让出 CPU 的原因
+    enum class ParkReason : uint8_t {
+        Yield,
+        NetRead,
+        NetWrite,
+        Database,
+        Timer,
+        Channel,
+        Mutex,
+        WaitGroup,
+        Blocking // 阻塞型系统调用交给 BlockingPool
+    };
+
+    // 协程被放回就绪队列的来源
+    enum class WakeSource : uint8_t {
+        Unknown,
+        Spawn,
+        Netpoller,
+        Timer,
+        Channel,
+        Mutex,
+        WaitGroup,
+        Blocking
+    };
+
+    // 一条记录；环形缓冲区里按字段存成 relaxed 原子量（见 Tracer::TraceSlot），导出时拷成这个结构
+    struct TraceRecord {
+        uint64_t ts_ns;
+        uint64_t gid;
+        uint64_t arg; // Resume: 在就绪队列里排队的纳秒数
+        const char *tag; // 路由 pattern，生命周期与 Engine 相同
+        uint32_t tag_len;
+        TraceEvent event;
+        uint8_t reason; // ParkReason / WakeSource
+    };
+
+    /**
+     * @brief 协程追踪器：每个线程一个环形缓冲区，按需导出 Chrome/Perfetto trace JSON
+     * 关闭状态下埋点只有一次 relaxed load + 分支
+     */
+    class Tracer {
+    public:
+        static Tracer &get();
+
+        static bool enabled() { return s_enabled_.load(std::memory_order_relaxed); }
+
+        // 开始记录，capacity 为每个线程环形缓冲区的记录条数（向上取 2 的幂，首次 start 后固定）
+        void start(size_t capacity = 1 << 16);
+
+        void stop();
+
+        // 导出为 Chrome trace-event JSON（chrome://tracing 或 ui.perfetto.dev 打开）
+        // 记录中也可以导出：正在被覆盖的槽会被跳过
+        void dump(std::ostream &out);
+
+        bool dump(const std::string &path);
+
+        // 给当前线程起个名字，导出时显示为 thread_name
+        static void name_thread(std::string name);
+
+        void record(TraceEvent event, const Goroutine *g, uint8_t reason, uint64_t arg = 0);
+
+    private:
+        // 环形缓冲区的一个槽。导出线程会和写入线程同时访问，所以字段都是原子量；
+        // 只用 relaxed 读写，在 x86/ARM 上仍是普通的 load/store
+        struct TraceSlot {
+            std::atomic<uint64_t> ts_ns{0};
+            std::atomic<uint64_t> gid{0};
+            std::atomic<uint64_t> arg{0};
+            std::atomic<const char *> tag{nullptr};
+            std::atomic<uint64_t> meta{0}; // tag_len | event << 32 | reason << 40
+        };
+
+        struct ThreadBuffer {
+            std::unique_ptr<TraceSlot[]> ring;
+            uint64_t mask = 0; // 槽数 - 1
+            std::atomic<uint64_t> head{0};
+            uint32_t tid = 0;
+            std::string name;
+        };
+
+        Tracer() = default;
+
+        ThreadBuffer *local_buffer();
+
+        // 拷出第 pos 条记录；写入方已经开始覆盖这个槽时返回 false
+        static bool snapshot(const ThreadBuffer &buf, uint64_t pos, TraceRecord &r);
+
+        static inline std::atomic<bool> s_enabled_{false};
+
+        std::mutex mtx_; // 只保护 buffers_ 的注册与导出
+        // 缓冲区只增不删：工作线程持有裸指针，停止后再次 start() 只重置游标
+        std::vector<std::unique_ptr<ThreadBuffer> > buffers_;
+        size_t capacity_ = 0;
+        int64_t base_ns_ = 0;
+    };
+
+    // 埋点入口：关闭时只剩一次分支
+    inline void trace(TraceEvent event, const Goroutine *g, uint8_t reason = 0, uint64_t arg = 0) {
+        if (__builtin_expect(Tracer::enabled(), 0)) {
+            Tracer::get().record(event, g, reason, arg);
+        }
+    }
+
+    int64_t trace_now_ns();
+} // namespace runtime
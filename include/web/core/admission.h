@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace gee {
+    struct AdmissionConfig {
+        int max_inflight = 0; // 同时处理的请求数上限，<=0 表示不限制（自适应时作为上限的上界）
+        bool adaptive = false; // 按观测到的处理延迟自动调整上限（AIMD）
+        int min_limit = 8; // 自适应下限
+        int initial_limit = 64; // 自适应起始值
+        int window_ms = 100; // 每个统计窗口调整一次
+        double tolerance = 2.0; // 窗口平均延迟超过 基线 × tolerance 视为过载
+        double backoff = 0.9; // 过载时上限乘以这个系数
+    };
+
+    /**
+     * @brief 准入控制：限制同时在处理的请求数
+     * 固定上限直接用 max_inflight；自适应模式下按窗口统计请求延迟：
+     * 平均延迟明显高于基线（历史最低的窗口平均值，缓慢上浮）时乘性减小上限，
+     * 延迟正常且上限被用满时按 sqrt(limit) 加性增大。
+     * 名额的申请与归还只有几次原子操作，统计在窗口结束时由某一个请求顺手完成。
+     */
+    class AdmissionController {
+    public:
+        void configure(const AdmissionConfig &config);
+
+        bool enabled() const { return enabled_; }
+
+        // 拿到一个在途名额返回 true；满了返回 false，调用方直接拒绝
+        bool try_acquire();
+
+        // 归还名额；latency_ns < 0 表示不计入统计（例如升级成长连接的请求）
+        void release(int64_t latency_ns);
+
+        int limit() const { return limit_.load(std::memory_order_relaxed); }
+
+        int inflight() const { return inflight_.load(std::memory_order_relaxed); }
+
+        uint64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
+    private:
+        void update_limit();
+
+        AdmissionConfig config_;
+        bool enabled_ = false;
+        int ceiling_ = 0;
+
+        std::atomic<int> limit_{0};
+        std::atomic<int> inflight_{0};
+        std::atomic<uint64_t> rejected_{0};
+
+        // 当前窗口的统计
+        std::atomic<int64_t> window_start_ns_{0};
+        std::atomic<int64_t> latency_sum_ns_{0};
+        std::atomic<int64_t> samples_{0};
+        std::atomic<bool> saturated_{false}; // 窗口内是否有请求因为满额被拒或把名额用满
+        int64_t baseline_ns_ = 0; // 只由拿到窗口的线程修改
+    };
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "runtime/goroutine.h"
+#include "runtime/spinlock.h"
+
+namespace gee {
+    class WebContext;
+
+    // 订阅者积压满了之后的处理方式
+    enum class SlowPolicy : uint8_t {
+        DropOldest, // 丢掉最早的未发送事件，连接保留
+        Disconnect // 断开这个订阅者，客户端可以带 Last-Event-ID 重连
+    };
+
+    struct BroadcasterConfig {
+        size_t queue_limit = 256; // 每个订阅者最多积压的事件数
+        SlowPolicy policy = SlowPolicy::DropOldest;
+        int heartbeat_ms = 15000; // 定期发注释行，防止代理断开空闲连接并及时发现断开的客户端；<=0 关闭
+        size_t shards = 16; // 订阅者表分片，订阅/退订与发布互不长时间阻塞
+    };
+
+    /**
+     * @brief Server-Sent Events 广播中心
+     * publish 只序列化一次，所有订阅者共享同一份字节（push_shared，不拷贝）。
+     * 每个订阅者有一个有界队列，由它自己的连接协程取走、合并成一次 writev 发出；
+     * 发布方只入队和唤醒，不写 socket，慢连接不会拖慢发布方或其他订阅者。
+     * 可以在任意线程或协程里 publish。
+     */
+    class Broadcaster {
+    public:
+        explicit Broadcaster(BroadcasterConfig config = {});
+
+        ~Broadcaster();
+
+        Broadcaster(const Broadcaster &) = delete;
+
+        Broadcaster &operator=(const Broadcaster &) = delete;
+
+        /**
+         * @brief 序列化一个事件并发给所有订阅者
+         * @return 投递到的订阅者数（不含因积压被断开的）
+         */
+        size_t publish(std::string_view data, std::string_view event = {}, std::string_view id = {});
+
+        // 已经按 text/event-stream 格式序列化好的帧
+        size_t publish_raw(std::shared_ptr<const std::string> frame);
+
+        /**
+         * @brief SSE Handler 里调用：发出响应头并订阅，一直运行到客户端断开、
+         * 因积压被断开或 Broadcaster 关闭
+         */
+        void serve(WebContext *c);
+
+        size_t subscribers() const { return state_->count.load(std::memory_order_relaxed); }
+
+        // 因积压丢弃的事件总数
+        size_t dropped() const { return state_->dropped.load(std::memory_order_relaxed); }
+
+        // 结束所有订阅，之后的 serve 立即返回
+        void close();
+
+    private:
+        struct Subscriber {
+            runtime::Spinlock lock;
+            std::deque<std::shared_ptr<const std::string> > queue;
+            runtime::Goroutine::Ptr waiter; // 队列为空时挂起的连接协程
+            bool closed = false;
+            bool evicted = false; // 因积压被断开
+            size_t shard = 0;
+            size_t pos = 0; // 在分片数组里的下标，分片锁保护
+        };
+
+        struct Shard {
+            runtime::Spinlock lock;
+            std::vector<std::shared_ptr<Subscriber> > subs;
+        };
+
+        // 心跳定时器只持有 weak_ptr，Broadcaster 析构后自然停止
+        struct State {
+            BroadcasterConfig config;
+            std::vector<Shard> shards;
+            std::atomic<bool> closed{false};
+            std::atomic<size_t> count{0};
+            std::atomic<size_t> dropped{0};
+            std::atomic<size_t> next_shard{0};
+        };
+
+        // 订阅者的连接协程只持有 State：Broadcaster 先于连接析构也不会访问已释放的内存
+        static void add(State &state, const std::shared_ptr<Subscriber> &sub);
+
+        static void remove(State &state, const Subscriber &sub);
+
+        // heartbeat 为 true 时只发给队列为空的订阅者，不挤掉真正的事件
+        static size_t fan_out(State &state, const std::shared_ptr<const std::string> &frame, bool heartbeat);
+
+        static void arm_heartbeat(const std::weak_ptr<State> &weak, int ms);
+
+        std::shared_ptr<State> state_;
+    };
+}
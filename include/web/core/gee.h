@@ -3,12 +3,102 @@
 #include <vector>
 #include <unordered_map>
 #include <functional>
-#include "node.h"
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include "runtime/spinlock.h"
+#include "router.h"
+#include "pipeline.h"
+#include "static_files.h"
+#include "broadcaster.h"
+#include "admission.h"
+#include "response_cache.h"
+#include "rate_limiter.h"
 #include "runtime/context/web_context.h"
 
 namespace gee {
-    using HandlerFunc = std::function<void(WebContext *)>;
     class Engine; // 前置声明
+    class Http2Connection;
+
+    namespace detail {
+        // 连接的空闲状态：空闲超时与排空时踢掉 keep-alive 连接都靠它
+        // 每个连接只挂一个定时器，到期时按进入空闲的时间点续期，避免每个请求都往定时器堆里塞一个节点
+        struct IdleGuard {
+            runtime::Spinlock lock;
+            bool closed = false;
+            bool idle = true;
+            int busy = 0; // HTTP/2：打开的流与正在读帧的连接协程各算一个
+            // 连接自己处理排空与空闲超时（HTTP/2 先发 GOAWAY），为空时直接 shutdown；只在持有 lock 时设置与调用
+            std::function<void()> on_drain;
+            bool drain_requested = false; // 空闲超时已经调过 on_drain
+            std::chrono::steady_clock::time_point idle_since = std::chrono::steady_clock::now();
+
+            // HTTP/1：等下一个请求时空闲，读到请求后忙
+            void set_idle(bool v) {
+                lock.lock();
+                idle = v;
+                if (v) idle_since = std::chrono::steady_clock::now();
+                lock.unlock();
+            }
+
+            // HTTP/2：多个协程同时进出，按计数归零判定空闲，先后顺序不影响结果
+            void enter() {
+                lock.lock();
+                if (++busy == 1) idle = false;
+                lock.unlock();
+            }
+
+            void leave() {
+                lock.lock();
+                if (--busy == 0) {
+                    idle = true;
+                    idle_since = std::chrono::steady_clock::now();
+                }
+                lock.unlock();
+            }
+        };
+    }
+
+    // --- 服务端连接参数 ---
+    struct EngineConfig {
+        int idle_timeout_ms = 60000; // keep-alive 连接等待下一个请求的最长时间，<=0 表示不限制
+        int max_requests_per_conn = 1000; // 单个连接最多处理的请求数，<=0 表示不限制
+        int max_pipeline_depth = 16; // 流水线请求最多攒多少个响应再 writev，防止单连接无限占用内存
+
+        // --- 监听与 socket 选项 ---
+        int backlog = 1024;
+        int acceptors = 1; // 接收协程数；>1 时需配合 reuse_port，每个协程独占一个监听 socket
+        bool reuse_port = false; // SO_REUSEPORT：由内核在多个监听 socket 之间分发新连接
+        int accept_batch = 64; // 一次唤醒最多 accept 的连接数，之后让出 CPU
+        bool tcp_nodelay = true;
+        int defer_accept_s = 0; // TCP_DEFER_ACCEPT（仅 Linux）：数据到达才唤醒 accept，0 表示关闭
+        int rcvbuf = 0; // SO_RCVBUF，0 表示系统默认
+        int sndbuf = 0; // SO_SNDBUF，0 表示系统默认
+
+        // --- 响应压缩 ---
+        bool compression = true; // 按 Accept-Encoding 协商 gzip / deflate
+        int compression_level = 6; // 1 最快，9 压缩率最高
+        size_t compression_min_bytes = 1024; // 小于这个大小的响应不压缩
+
+        // --- 请求体 ---
+        size_t max_body_drain = 256 * 1024; // Handler 没读完的流式 Body 最多丢弃这么多字节来保住连接，超过就关闭
+
+        // --- HTTP/2 明文（h2c） ---
+        bool h2c = true; // 接受先验知识的 HTTP/2 连接与 Upgrade: h2c
+        uint32_t h2_max_streams = 128; // SETTINGS_MAX_CONCURRENT_STREAMS，超过的新流被拒绝
+        uint32_t h2_stream_window = 1024 * 1024; // 每个流的接收窗口，决定上传不等 WINDOW_UPDATE 能发多少
+
+        // --- 过载保护 ---
+        AdmissionConfig admission; // 在途请求上限，可按延迟自适应；超出直接回 503
+        int queue_budget_ms = 0; // 请求就绪后在调度队列里等待超过这个时间就不再处理，直接回 503；<=0 表示不检查
+
+        // --- 平滑重启 ---
+        bool handle_signals = true; // SIGTERM/SIGINT 优雅退出，SIGUSR2 拉起新进程接管监听 socket 后退出
+        int drain_timeout_ms = 30000; // 停止接收后等待在途连接结束的最长时间，到期把剩下的连接全部断开
+        int upgrade_timeout_ms = 60000; // 等新进程就绪（完成 db::init 等预热并开始 accept）的最长时间
+    };
 
     // --- RouterGroup 声明 ---
     class RouterGroup {
@@ -29,6 +119,20 @@ namespace gee {
 
         void POST(std::string path, HandlerFunc handler);
 
+        // 静态文件：relative 下的请求映射到磁盘目录 root，例如 Static("/assets", "./public")
+        void Static(const std::string &relative, const std::string &root, StaticConfig config = {});
+
+        // WebSocket：握手走正常的中间件链（鉴权等），升级后 handler 在连接协程里收发消息
+        void WS(std::string path, WSHandler handler, WebSocketConfig config = {});
+
+        // 编译期中间件链：app.GET<mw::Recovery, Logger, Auth>("/x", handler)
+        // 类型化部分折叠成一个 Handler，排在 Use() 注册的动态中间件之后
+        template<typename... Ms, typename H, typename = std::enable_if_t<(sizeof...(Ms) > 0)> >
+        void GET(std::string path, H handler);
+
+        template<typename... Ms, typename H, typename = std::enable_if_t<(sizeof...(Ms) > 0)> >
+        void POST(std::string path, H handler);
+
     protected: // 改为 protected 方便 Engine 访问
         std::string prefix_;
         std::vector<HandlerFunc> middlewares_;
@@ -46,29 +150,97 @@ namespace gee {
 
         Engine &operator=(const Engine &) = delete;
 
+        EngineConfig &config() { return config_; }
+
+        // 当前并发上限、在途请求数与拒绝计数
+        const AdmissionController &admission() const { return admission_; }
+
         // 核心方法
         void handle_http_task(int fd);
 
+        /**
+         * @brief 开始监听并阻塞，直到收到退出信号或调用 Stop()，在途连接排空后返回
+         * 返回前会停掉调度器（Scheduler::stop）：连接协程、定时器都引用着 Engine，不能比它活得久
+         * 环境变量 GEE_LISTEN_FDS 存在时（由旧进程 exec 而来）直接接管继承的监听 socket，
+         * 不重新 bind；此时调用 Run 之前应完成 db::init 等预热，Run 开始 accept 后才通知旧进程退出
+         */
         void Run(int port);
 
-        std::vector<std::string> parse_pattern(std::string_view pattern);
+        // 从任意线程请求优雅退出，与 SIGTERM 相同
+        void Stop();
+
+        // 开始排空时调用（例如关闭 Broadcaster、通知 WebSocket 客户端），在信号处理线程里执行
+        void OnShutdown(std::function<void()> fn) { shutdown_hooks_.push_back(std::move(fn)); }
 
         // 关键：修改 add_route 签名，使其能接收中间件链
         void add_route(std::string method, std::string path, HandlerFunc handler,
                        std::vector<HandlerFunc> middlewares = {});
 
-        std::pair<Node *, std::unordered_map<std::string, std::string> >
-        get_route(const std::string &method, const std::string &path);
+        // 命中时返回路由，参数写入 params（视图指向 path）；未命中返回 nullptr
+        const Route *get_route(std::string_view method, std::string_view path, Params &params) const;
 
     private:
         friend class RouterGroup;
-        std::unordered_map<std::string, Node *> roots_;
-        // 存储 完整执行链：Key="GET-/user/:id"
-        std::unordered_map<std::string, std::vector<HandlerFunc> > route_handlers_chain_;
+        // HTTP/2 的每个流复用 serve_request 走路由与中间件链
+        friend class Http2Connection;
+        // 每条路由的完整执行链在注册时拼好，挂在叶子上
+        Router router_;
+        // 未命中时的执行链：全局中间件 + 404，Run 时拼好一次
+        HandlersChain not_found_chain_;
 
         std::vector<RouterGroup *> groups_;
 
+        EngineConfig config_;
+
+        AdmissionController admission_;
+
         int create_listen_socket(int port);
+
+        // 接收协程：监听 socket 注册到 netpoller，可读时批量 accept
+        void accept_loop(int listen_fd);
+
+        void setup_conn_socket(int fd) const;
+
+        std::mutex run_mutex_;
+        std::condition_variable run_cv_;
+
+        // --- 平滑重启（graceful.cpp） ---
+        std::vector<int> listen_fds_;
+        std::vector<std::function<void()> > shutdown_hooks_;
+        std::atomic<bool> draining_{false};
+        size_t acceptors_ = 0; // 还在运行的接收协程，run_mutex_ 保护；排空时等它们都退出才关闭监听 socket
+        runtime::Spinlock conns_lock_;
+        std::unordered_map<int, std::shared_ptr<detail::IdleGuard> > conns_; // 在途连接，conns_lock_ 保护
+
+        // 接管继承的监听 socket，或者新建；返回是否至少有一个
+        bool open_listeners(int port);
+
+        // 阻塞等待退出或升级信号；升级时先拉起新进程，确认就绪后才返回
+        void wait_for_shutdown();
+
+        // fork + exec 自身，监听 socket 通过 GEE_LISTEN_FDS 继承；新进程就绪返回 true
+        bool spawn_successor();
+
+        // 停止接收、踢掉空闲连接，等在途连接结束或超时
+        void drain(int timeout_ms);
+
+        void track_conn(int fd, const std::shared_ptr<detail::IdleGuard> &guard);
+
+        void untrack_conn(int fd);
+
+        void kick_idle_conns();
+
+        // 排空超时：不管是否空闲，所有连接一律 shutdown
+        void cut_conns();
+
+        // 处理连接上的一个请求，返回 false 表示连接不能再复用
+        bool serve_request(WebContext &ctx, bool keep_alive_allowed);
+
+        // 当前协程这次被唤醒前在就绪队列里等得太久：处理完也已经超出客户端的耐心
+        bool over_queue_budget() const;
+
+        // 过载时的快速 503，不走路由与中间件，回复后关闭连接
+        static void reject_overloaded(WebContext &ctx);
     };
 
     // --- 重点：在两个类都定义完后，再写相互调用的函数实现 ---
@@ -108,4 +280,34 @@ namespace gee {
     inline void RouterGroup::POST(std::string path, HandlerFunc handler) {
         engine_->add_route("POST", prefix_ + path, std::move(handler), middlewares_);
     }
+
+    inline void RouterGroup::Static(const std::string &relative, const std::string &root, StaticConfig config) {
+        auto files = std::make_shared<StaticFiles>(root, std::move(config));
+        HandlerFunc handler = [files](WebContext *c) { files->serve(c); };
+
+        std::string base = prefix_ + relative;
+        std::string pattern = base;
+        if (pattern.empty() || pattern.back() != '/') pattern.push_back('/');
+        pattern.append("*filepath");
+        for (const char *method: {"GET", "HEAD"}) {
+            engine_->add_route(method, base, handler, middlewares_); // 目录本身，返回 index
+            engine_->add_route(method, pattern, handler, middlewares_);
+        }
+    }
+
+    inline void RouterGroup::WS(std::string path, WSHandler handler, WebSocketConfig config) {
+        engine_->add_route("GET", prefix_ + path, [handler = std::move(handler), config](WebContext *c) {
+            c->UpgradeWebSocket(handler, config);
+        }, middlewares_);
+    }
+
+    template<typename... Ms, typename H, typename>
+    void RouterGroup::GET(std::string path, H handler) {
+        engine_->add_route("GET", prefix_ + path, compose<Ms...>(std::move(handler)), middlewares_);
+    }
+
+    template<typename... Ms, typename H, typename>
+    void RouterGroup::POST(std::string path, H handler) {
+        engine_->add_route("POST", prefix_ + path, compose<Ms...>(std::move(handler)), middlewares_);
+    }
 } // namespace gee
@@ -0,0 +1,193 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "runtime/goroutine.h"
+#include "runtime/spinlock.h"
+#include "web/protocol/hpack.h"
+
+namespace gee {
+    class Engine;
+    class ReadBuffer;
+    struct Request;
+    struct WebContext;
+
+    namespace detail {
+        struct IdleGuard;
+    }
+
+    /**
+     * @brief 一条 HTTP/2 明文连接（h2c，RFC 7540）
+     * 连接协程读帧并做 HPACK 解码；每个请求流在自己的协程里走正常的路由与中间件链，
+     * 慢 Handler 不会挡住同一连接上的其他流；所有流的帧由一个写协程合并后一次写出。
+     * Handler 仍然往 OutputQueue 里写 HTTP/1 格式的响应，流在 flush 时把它转换成
+     * HEADERS + DATA 帧并遵守对端的流量控制窗口，业务代码不需要感知协议版本。
+     * 请求体按流缓冲完整后才分发（与 HTTP/1 的普通 Body 相同，上限 10MB）。
+     */
+    class Http2Connection {
+    public:
+        static constexpr std::string_view kPreface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+        // 读到的数据是否为连接前言的开头（HTTP/1 解析器在第 16 字节处失败，至少要有这么多）
+        static bool is_preface(std::string_view data);
+
+        // HTTP/1.1 请求是否带 Upgrade: h2c 与 HTTP2-Settings，且没有 Body
+        static bool wants_upgrade(const Request &req);
+
+        // guard 是连接的空闲状态：没有打开的流、连接协程在等数据时算空闲，空闲超时照常生效
+        Http2Connection(Engine &engine, int fd, std::shared_ptr<detail::IdleGuard> guard);
+
+        Http2Connection(const Http2Connection &) = delete;
+
+        Http2Connection &operator=(const Http2Connection &) = delete;
+
+        // 先验知识（prior knowledge）：in 里是已经读到的字节，从连接前言开始；运行到连接结束
+        void serve(ReadBuffer &in);
+
+        /**
+         * @brief 从 HTTP/1.1 升级：回复 101 后原请求作为流 1 处理，运行到连接结束
+         * @return false 表示 HTTP2-Settings 不合法，没有升级，调用方按 HTTP/1.1 继续处理
+         */
+        bool serve_upgrade(WebContext &ctx);
+
+    private:
+        struct Stream {
+            uint32_t id = 0;
+            HeaderList headers;
+            std::string cookie; // 拆成多个字段的 cookie 按 "; " 拼回一个
+            std::string body;
+            int64_t send_window = 0; // 对端允许我们发送的字节数
+            int64_t recv_window = 0; // 我们还愿意接收的字节数
+            bool dispatched = false;
+            bool reset = false; // 收到或发出了 RST_STREAM
+            runtime::Goroutine::Ptr waiter; // 等窗口或写缓冲空间的流协程
+        };
+
+        struct ResponseWriter;
+
+        // 流是怎么结束的：之后再收到它的帧时据此处理（RFC 9113 §5.1、§5.4.2）
+        enum class ClosedBy : uint8_t {
+            Unknown, // 已经挤出历史，分不清
+            ResetSent, // 我们发了 RST_STREAM（包括拒绝的流）
+            ResetReceived, // 对端发了 RST_STREAM
+            Finished // 两端都发过 END_STREAM
+        };
+
+        struct ClosedStream {
+            uint32_t id = 0;
+            ClosedBy how = ClosedBy::Unknown;
+        };
+
+        static constexpr size_t kClosedHistory = 256;
+
+        // 协议错误：记下错误码，连接协程随后发 GOAWAY 并停止读取
+        bool fail(uint32_t code) {
+            error_ = code;
+            return false;
+        }
+
+        void start();
+
+        void read_loop(ReadBuffer &in);
+
+        void finish();
+
+        bool read_more(ReadBuffer &in);
+
+        bool handle_frame(uint8_t type, uint8_t flags, uint32_t sid, std::string_view payload);
+
+        bool on_headers(uint8_t flags, uint32_t sid, std::string_view payload);
+
+        bool on_header_block(uint32_t sid, bool end_stream);
+
+        bool on_data(uint8_t flags, uint32_t sid, std::string_view payload);
+
+        bool on_settings(uint8_t flags, uint32_t sid, std::string_view payload);
+
+        bool on_window_update(uint32_t sid, std::string_view payload);
+
+        bool on_rst_stream(uint32_t sid, std::string_view payload);
+
+        // HEADERS / DATA 落在不超过 last_stream_、又不在 streams_ 里的流上
+        bool on_closed_stream(uint32_t sid);
+
+        // 排空或空闲超时：发 GOAWAY，不再接受新流，已经开始的流照常完成后关闭连接；可重复调用
+        void go_away();
+
+        // SETTINGS 帧或 HTTP2-Settings 头里的参数
+        bool apply_settings(std::string_view payload);
+
+        void dispatch(const std::shared_ptr<Stream> &st);
+
+        void run_stream(const std::shared_ptr<Stream> &st);
+
+        // 以下在任意协程里调用，内部加锁
+        void send_frame(uint8_t type, uint8_t flags, uint32_t sid, std::string_view payload);
+
+        void reset_stream(uint32_t sid, uint32_t code);
+
+        bool send_headers(Stream &st, int status, const HeaderList &fields, bool end_stream);
+
+        bool send_data(Stream &st, std::string_view data, bool end_stream);
+
+        void write_loop();
+
+        // 挂起当前协程直到 ready() 成立：在 lock_ 下检查，不成立就登记到 slot 等别人唤醒
+        template<typename F>
+        void wait(runtime::Goroutine::Ptr &slot, runtime::ParkReason reason, F ready);
+
+        // 以下要求已持有 lock_
+        static void wake(runtime::Goroutine::Ptr &slot);
+
+        void wake_streams();
+
+        // 释放 lock_ 之后再唤醒：等在 finish 里的连接协程醒来就可能返回并销毁本对象
+        void wake_unlock(runtime::Goroutine::Ptr &slot);
+
+        void append_frame_header(size_t len, uint8_t type, uint8_t flags, uint32_t sid);
+
+        void remember_closed(uint32_t sid, ClosedBy how);
+
+        // 发过 GOAWAY 且没有打开的流时关闭读方向，让连接协程退出
+        void stop_reading_if_done();
+
+        Engine &engine_;
+        int fd_;
+        std::shared_ptr<detail::IdleGuard> guard_; // 不在持有 lock_ 时访问
+
+        // 只由连接协程访问
+        HpackDecoder decoder_;
+        uint32_t last_stream_ = 0; // 连接协程持有 lock_ 时修改，go_away 在锁下读
+        uint32_t error_ = 0;
+        int64_t conn_recv_window_;
+        uint32_t cont_stream_ = 0; // 正在等 CONTINUATION 的流
+        bool cont_end_stream_ = false;
+        std::string cont_block_;
+
+        // 以下由 lock_ 保护
+        runtime::Spinlock lock_;
+        std::unordered_map<uint32_t, std::shared_ptr<Stream> > streams_;
+        HpackEncoder encoder_; // 动态表依赖编码顺序，编码与入队在同一把锁下完成
+        std::string out_; // 待写出的帧，写协程整批取走
+        int64_t conn_send_window_ = 65535;
+        int64_t peer_initial_window_ = 65535;
+        size_t peer_max_frame_ = 16384;
+        size_t active_ = 0; // 还在运行的流协程
+        bool closing_ = false; // 读循环已结束，写协程写完剩余数据后退出
+        bool writer_done_ = false;
+        bool broken_ = false; // 写 socket 失败
+        bool going_away_ = false; // 已经发出 GOAWAY
+        std::atomic<bool> read_shut_{false}; // 已经关闭读方向，连接协程不再读帧
+        runtime::Goroutine::Ptr writer_waiter_;
+        runtime::Goroutine::Ptr finish_waiter_;
+        // 最近结束的流，环形覆盖；编号不超过 closed_forgotten_ 的已经可能被挤掉
+        std::array<ClosedStream, kClosedHistory> closed_{};
+        size_t closed_next_ = 0;
+        uint32_t closed_forgotten_ = 0;
+    };
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+
+#include "router.h"
+#include "runtime/context/web_context.h"
+
+namespace gee {
+    /**
+     * @brief 编译期组合的中间件链
+     * 类型化中间件是一个带静态 handle 的结构体：
+     *
+     *     struct Auth {
+     *         template<typename Next>
+     *         static void handle(WebContext *c, Next &&next) { ...; next(); ... }
+     *     };
+     *
+     * next 是具体的 lambda 类型而不是 std::function，整条链在编译期展开，
+     * 编译器可以把它内联成一个函数；注册后在动态执行链里只占一个 HandlerFunc。
+     * 不调用 next() 即拦截后续中间件与业务 Handler。
+     */
+    template<typename... Ms>
+    struct Pipeline;
+
+    template<>
+    struct Pipeline<> {
+        template<typename H>
+        static void run(WebContext *c, H &handler) { handler(c); }
+    };
+
+    template<typename M, typename... Rest>
+    struct Pipeline<M, Rest...> {
+        template<typename H>
+        static void run(WebContext *c, H &handler) {
+            M::handle(c, [c, &handler]() { Pipeline<Rest...>::run(c, handler); });
+        }
+    };
+
+    // 把类型化中间件和业务 Handler 折叠成一个 HandlerFunc，可以接在 Use() 注册的动态中间件后面
+    template<typename... Ms, typename H>
+    HandlerFunc compose(H handler) {
+        static_assert(std::is_invocable_v<H &, WebContext *>, "handler must be callable as void(WebContext *)");
+        return [handler = std::move(handler)](WebContext *c) mutable {
+            Pipeline<Ms...>::run(c, handler);
+        };
+    }
+
+    namespace mw {
+        // Recovery 的类型化版本
+        struct Recovery {
+            template<typename Next>
+            static void handle(WebContext *c, Next &&next) {
+                try {
+                    next();
+                } catch (...) {
+                    if (!c->res_.is_sent) c->JSON(StateCode::SERVER_ERROR, "Internal Server Error", "{}");
+                }
+            }
+        };
+    }
+}
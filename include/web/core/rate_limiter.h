@@ -0,0 +1,120 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "router.h"
+
+namespace gee {
+    enum class RateLimitAlgorithm : uint8_t {
+        TokenBucket, // 桶容量 burst，每秒补 rate 个令牌
+        GCRA // Generic Cell Rate Algorithm：每个键只记一个"理论到达时间"，行为与令牌桶等价，精度到微秒
+    };
+
+    // 限流键的来源
+    enum class RateLimitKey : uint8_t {
+        ClientIP, // 对端地址
+        Header, // 指定请求头的值（例如反向代理加的 X-Forwarded-For、API Key）
+        Route // 只按路由，所有客户端共享一个额度
+    };
+
+    struct RateLimiterConfig {
+        double rate = 10; // 每秒允许的请求数
+        uint32_t burst = 20; // 允许的突发（令牌桶容量）
+        RateLimitAlgorithm algorithm = RateLimitAlgorithm::TokenBucket;
+        RateLimitKey key = RateLimitKey::ClientIP;
+        std::string header; // key 为 Header 时使用；请求没有这个头时按 ClientIP
+        bool per_route = false; // 键里再带上路由，同一客户端在不同路由上各有额度
+        size_t max_keys = 1 << 20; // 表的槽数（向上取 2 的幂），内存固定为 16 字节 × 槽数
+    };
+
+    /**
+     * @brief 无锁限流中间件
+     * 键哈希到一张固定大小的开放寻址表，每个槽一个 64 位键和一个 64 位状态，
+     * 查找只看一条缓存行里的 4 个槽；状态的更新是一次 CAS，不同键之间没有任何共享的锁。
+     * 表满时优先复用已经"回满"的槽（令牌桶满 / 理论到达时间已过）：这样的键忘掉也不会改变结果，
+     * 空闲键的淘汰因此不需要后台清理。实在没有空闲槽时复用最接近回满的那个，对该键略宽松。
+     * 超限直接回预先拼好的 429，不进入后续 Handler。
+     */
+    class RateLimiter {
+    public:
+        explicit RateLimiter(RateLimiterConfig config = {});
+
+        RateLimiter(const RateLimiter &) = delete;
+
+        RateLimiter &operator=(const RateLimiter &) = delete;
+
+        // 注册用的中间件，限流器必须比 Engine 活得久
+        HandlerFunc middleware() {
+            return [this](WebContext *c) { handle(c); };
+        }
+
+        void handle(WebContext *c);
+
+        // 按键的哈希取一个令牌，允许返回 true；now_us 为限流器启动后的微秒数
+        bool allow(uint64_t key_hash, uint64_t now_us);
+
+        uint64_t now_us() const;
+
+        uint64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
+        // 因为没有空闲槽而复用了仍在限流中的槽的次数，持续增长说明 max_keys 太小
+        uint64_t evictions() const { return evictions_.load(std::memory_order_relaxed); }
+
+    private:
+        struct Slot {
+            std::atomic<uint64_t> key{0}; // 0 表示空槽
+            std::atomic<uint64_t> state{0};
+        };
+
+        static constexpr size_t kWays = 4;
+
+        // 一个键只可能落在一条缓存行的 4 个槽里，查找最多一次 cache miss
+        struct alignas(64) Line {
+            Slot ways[kWays];
+        };
+
+        uint64_t key_hash(WebContext *c) const;
+
+        // 新键的初始状态：满桶 / 理论到达时间为现在
+        uint64_t fresh_state(uint64_t now_us) const;
+
+        // 按算法更新状态，返回是否放行；next 为更新后的状态
+        bool step(uint64_t state, uint64_t now_us, uint64_t &next) const;
+
+        // 令牌桶补充到 now 之后的状态
+        uint64_t refill(uint64_t state, uint64_t now_us) const;
+
+        // 槽在 now 时是否已经回满，可以直接复用；slack 越大越接近回满
+        bool idle(uint64_t state, uint64_t now_us, uint64_t &slack) const;
+
+        // 在槽上 CAS 更新状态
+        bool take(Slot &slot, uint64_t now_us);
+
+        // 刚换成新键的槽写入初始状态；seen 是换键之前读到的状态，状态已经变了就不写
+        void claim(Slot &slot, uint64_t seen, uint64_t now_us);
+
+        void reject(WebContext *c) const;
+
+        RateLimiterConfig config_;
+        std::unique_ptr<Line[]> lines_;
+        size_t line_mask_ = 0;
+        int64_t epoch_ns_ = 0;
+
+        // 令牌桶：状态 = 高 40 位毫秒时间戳 | 低 24 位令牌数（1/256 个为单位）
+        uint64_t capacity_q8_ = 0;
+        uint64_t refill_q24_per_ms_ = 0; // 每毫秒补充的令牌，再放大 2^16 保留小数
+        uint64_t full_ms_ = 0; // 从空桶到满桶的毫秒数，超过就直接视为满桶，免得乘法溢出
+
+        // GCRA：状态 = 理论到达时间（微秒）
+        uint64_t interval_us_ = 0; // 相邻两个请求的理想间隔 T = 1 / rate
+        uint64_t tolerance_us_ = 0; // 允许提前的量 tau = T × (burst - 1)
+
+        std::string retry_after_; // 预先拼好的 "Retry-After: N\r\n"
+
+        std::atomic<uint64_t> rejected_{0};
+        std::atomic<uint64_t> evictions_{0};
+    };
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "router.h"
+#include "runtime/goroutine.h"
+#include "runtime/spinlock.h"
+
+namespace gee {
+    struct ResponseCacheConfig {
+        int ttl_ms = 1000; // 新鲜期
+        // 过期后仍可先返回旧响应的时长（stale-while-revalidate）；0 关闭。这段时间里第一个命中的请求
+        // 照常拿到旧响应，另起一个协程拿请求的副本重新执行后续 Handler，不占用当前连接
+        int stale_ms = 0;
+        size_t max_bytes = 64 * 1024 * 1024; // 所有分片合计的字节上限（键 + 响应字节 + 估算的节点开销）
+        size_t max_entry_bytes = 1024 * 1024; // 单个响应超过这个大小不缓存
+        size_t shards = 16;
+        std::vector<std::string> vary; // 参与缓存键的请求头，例如 "Authorization"、"Accept-Language"
+    };
+
+    /**
+     * @brief 进程内 HTTP 响应缓存中间件
+     * 只缓存 GET 且 HTTP 状态与业务状态都是 200 的普通响应（流式、文件、升级连接不缓存）。
+     * 键由路径、排序后的查询参数、vary 里的请求头和协商出的压缩方式组成。
+     * 缓存的是写进输出队列的原始字节（去掉 Connection 与 Date），命中时借用这块内存，
+     * 补上按请求变化的 Connection、Date、Age 后与其他响应一起 writev，不重新序列化。
+     * 同一个键同时未命中时只有一个请求执行 Handler，其余协程挂起等结果。
+     *
+     *     gee::ResponseCacheConfig cc;
+     *     cc.ttl_ms = 2000;
+     *     cc.stale_ms = 10000;
+     *     static gee::ResponseCache cache(cc);
+     *     auto cached = app.Group("/cached");
+     *     cached->Use(cache.middleware());
+     */
+    class ResponseCache {
+    public:
+        explicit ResponseCache(ResponseCacheConfig config = {});
+
+        ResponseCache(const ResponseCache &) = delete;
+
+        ResponseCache &operator=(const ResponseCache &) = delete;
+
+        // 注册用的中间件，缓存对象必须比 Engine 活得久
+        HandlerFunc middleware() {
+            return [this](WebContext *c) { handle(c); };
+        }
+
+        void handle(WebContext *c);
+
+        // 丢弃所有缓存（正在生成的响应完成后照常写入）
+        void clear();
+
+        uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+
+        uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+        // 未命中时等别人的结果而没有自己执行 Handler 的次数
+        uint64_t coalesced() const { return coalesced_.load(std::memory_order_relaxed); }
+
+        // 过期后仍返回旧响应的次数
+        uint64_t stale_hits() const { return stale_hits_.load(std::memory_order_relaxed); }
+
+        size_t bytes() const;
+
+    private:
+        struct Entry {
+            std::string wire; // 状态行 + Header（不含 Connection、Date 和结尾空行）+ body
+            size_t head_len = 0;
+            int64_t created_ns = 0;
+            int64_t fresh_until_ns = 0;
+            int64_t stale_until_ns = 0;
+        };
+
+        using EntryPtr = std::shared_ptr<const Entry>;
+
+        // 一次正在进行的生成，同一个键的其他未命中请求挂在这里
+        struct Flight {
+            std::vector<runtime::Goroutine::Ptr> waiters;
+            EntryPtr result; // 不可缓存时为空，等待者各自执行 Handler
+            bool done = false;
+        };
+
+        struct Node {
+            EntryPtr entry;
+            std::list<const std::string *>::iterator lru;
+            size_t charge = 0;
+            bool refreshing = false; // 已经有请求在重新生成
+        };
+
+        struct Shard {
+            mutable runtime::Spinlock lock;
+            std::unordered_map<std::string, Node> map;
+            std::list<const std::string *> lru; // 头部最近使用，键指向 map 里的节点（节点地址不随 rehash 变化）
+            std::unordered_map<std::string, std::shared_ptr<Flight> > flights;
+            size_t bytes = 0;
+        };
+
+        std::string make_key(WebContext *c) const;
+
+        Shard &shard_for(const std::string &key);
+
+        // 执行后续 Handler 后从输出队列取出刚写入的响应，不可缓存返回空
+        EntryPtr capture(WebContext *c, size_t first_chunk, size_t responses) const;
+
+        // 旧响应已经发出：拷一份请求，在新协程里执行 c 之后的 Handler，结果写回 key
+        void revalidate(WebContext *c, const std::string &key);
+
+        // 在没有连接的后台上下文里执行后续 Handler，响应只留在输出队列里
+        EntryPtr regenerate(WebContext *c) const;
+
+        void serve(WebContext *c, const EntryPtr &e, int64_t now) const;
+
+        // 持有分片锁调用
+        void store(Shard &shard, const std::string &key, EntryPtr e);
+
+        void erase(Shard &shard, std::unordered_map<std::string, Node>::iterator it);
+
+        void finish_flight(Shard &shard, const std::string &key, const std::shared_ptr<Flight> &flight,
+                           EntryPtr e);
+
+        ResponseCacheConfig config_;
+        size_t shard_capacity_;
+        std::vector<Shard> shards_;
+
+        std::atomic<uint64_t> hits_{0};
+        std::atomic<uint64_t> misses_{0};
+        std::atomic<uint64_t> coalesced_{0};
+        std::atomic<uint64_t> stale_hits_{0};
+    };
+}
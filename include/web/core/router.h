@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gee {
+    class WebContext;
+    using HandlerFunc = std::function<void(WebContext *)>;
+    // 注册完成后不再修改，请求之间共享，只传指针
+    using HandlersChain = std::vector<HandlerFunc>;
+
+    /**
+     * @brief 路由参数：内联小数组，key 指向路由 pattern，value 指向请求 path，不做任何拷贝
+     */
+    class Params {
+    public:
+        static constexpr size_t kMax = 8;
+
+        bool push(std::string_view key, std::string_view value) {
+            if (size_ >= kMax) return false;
+            items_[size_++] = {key, value};
+            return true;
+        }
+
+        std::string_view get(std::string_view key) const {
+            for (size_t i = 0; i < size_; ++i) {
+                if (items_[i].first == key) return items_[i].second;
+            }
+            return {};
+        }
+
+        size_t size() const { return size_; }
+        void truncate(size_t n) { if (n < size_) size_ = n; }
+        void clear() { size_ = 0; }
+
+        // path 所在的内存搬走后，把 value 视图平移到新地址
+        void rebase(const char *old_base, size_t len, const char *new_base) {
+            for (size_t i = 0; i < size_; ++i) {
+                auto &v = items_[i].second;
+                if (v.data() >= old_base && v.data() <= old_base + len) {
+                    v = std::string_view(new_base + (v.data() - old_base), v.size());
+                }
+            }
+        }
+
+    private:
+        std::array<std::pair<std::string_view, std::string_view>, kMax> items_{};
+        size_t size_ = 0;
+    };
+
+    struct Route {
+        std::string method;
+        std::string pattern; // 例如 /user/:id
+        HandlersChain chain; // 预先拼好的 中间件 + Handler
+    };
+
+    /**
+     * @brief 压缩前缀树路由
+     * 直接在 path 的 string_view 上逐字节匹配；不含参数的静态路由另有哈希表直达
+     * 匹配优先级与原 Trie 一致：静态 > :param > *catchall
+     */
+    class Router {
+    public:
+        Router();
+
+        ~Router();
+
+        const Route *add(const std::string &method, const std::string &pattern, HandlersChain chain);
+
+        const Route *find(std::string_view method, std::string_view path, Params &params) const;
+
+    private:
+        struct Node;
+
+        struct Tree {
+            std::string method;
+            std::unique_ptr<Node> root;
+            // key 指向 Route::pattern，Route 由 routes_ 持有，地址稳定
+            std::unordered_map<std::string_view, const Route *> statics;
+        };
+
+        Tree &tree_of(const std::string &method);
+
+        static void insert_static(Node *n, std::string_view pat, const Route *route);
+
+        static void insert_children(Node *n, std::string_view pat, const Route *route);
+
+        static const Route *match_children(const Node *n, std::string_view path, Params &params);
+
+        std::vector<Tree> trees_;
+        std::vector<std::unique_ptr<Route> > routes_;
+    };
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <sys/types.h>
+#include <ctime>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "runtime/spinlock.h"
+#include "web/protocol/compress.h"
+
+namespace gee {
+    class WebContext;
+
+    struct StaticConfig {
+        size_t max_cached_file = 256 * 1024; // 不超过这个大小的文件 mmap 进缓存，更大的走 sendfile
+        size_t max_cache_bytes = 64 * 1024 * 1024; // 缓存总量上限，超出按 LRU 淘汰
+        int revalidate_ms = 1000; // 缓存项多久重新 stat 一次，期间命中不做任何系统调用
+        std::string index = "index.html"; // 请求目录时返回的文件
+        int max_age_s = 0; // >0 时发送 Cache-Control: max-age
+    };
+
+    /**
+     * @brief 静态文件服务
+     * 小文件 mmap 后放进 LRU 缓存，响应直接借用映射内存；大文件用 sendfile 发送。
+     * 支持 ETag / Last-Modified 条件请求（304）与单段 Range（206 / 416）；
+     * 缓存中的文本类文件按需压缩一次，压缩结果随缓存项一起复用。
+     * open/stat/mmap 都交给 BlockingPool，不占用调度器 Worker。
+     */
+    class StaticFiles {
+    public:
+        StaticFiles(std::string root, StaticConfig config);
+
+        // 路由 Handler：相对路径取自 *filepath 参数
+        void serve(WebContext *c);
+
+    private:
+        // 一个文件的元信息，缓存项与大文件共用
+        struct FileInfo {
+            off_t size = 0;
+            time_t mtime = 0;
+            std::string etag; // "mtime-size"，与 nginx 同格式
+            std::string last_modified;
+            std::string_view type_line; // 预先渲染的 Content-Type 行
+        };
+
+        struct Mapping; // mmap 区域，析构时 munmap
+
+        struct CacheEntry {
+            FileInfo info;
+            std::shared_ptr<Mapping> map;
+            std::chrono::steady_clock::time_point checked_at;
+            std::list<std::string>::iterator lru;
+            // 预压缩结果，第一次被请求时生成，之后直接复用
+            mutable runtime::Spinlock zlock;
+            mutable std::shared_ptr<const std::string> gzip;
+            mutable std::shared_ptr<const std::string> deflate;
+        };
+
+        static std::shared_ptr<const std::string> compressed(const CacheEntry &entry, Encoding enc, int level);
+
+        std::shared_ptr<const CacheEntry> lookup(const std::string &rel);
+
+        void insert(const std::string &rel, std::shared_ptr<CacheEntry> entry);
+
+        void evict(const std::string &rel);
+
+        std::string root_;
+        StaticConfig config_;
+
+        std::mutex mutex_;
+        std::unordered_map<std::string, std::shared_ptr<CacheEntry> > cache_;
+        std::list<std::string> lru_; // 头部最近使用
+        size_t cached_bytes_ = 0;
+    };
+}
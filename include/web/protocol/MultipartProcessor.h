@@ -2,6 +2,9 @@
 #define MULTIPART_PROCESSOR_H
 
 #include <iostream>
+#include <array>
+#include <cstring>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -10,6 +13,68 @@
 #include "../../../include/pool/io_task_pool.h"
 
 namespace gee {
+    /**
+     * @brief multipart 边界查找
+     * 模式以 \r 开头：先用 memchr（libc 里是 SIMD 实现）找 \r，再比较整个模式，二进制数据里 \r 很少，基本是一遍扫描；
+     * 文本数据里到处是 \r\n，误报一多就改用 Boyer-Moore-Horspool：比较窗口的最后一个字节，按坏字符表整段跳过
+     */
+    class BoundaryMatcher {
+    public:
+        static constexpr size_t npos = std::string::npos;
+
+        explicit BoundaryMatcher(std::string pattern) : pattern_(std::move(pattern)) {
+            size_t m = pattern_.size();
+            shift_.fill(m);
+            for (size_t i = 0; i + 1 < m; ++i) {
+                shift_[static_cast<unsigned char>(pattern_[i])] = m - 1 - i;
+            }
+        }
+
+        size_t size() const { return pattern_.size(); }
+
+        // 返回模式在 [data, data + n) 中第一次出现的位置，没有返回 npos
+        size_t find(const char *data, size_t n) const {
+            size_t m = pattern_.size();
+            if (m == 0 || n < m) return npos;
+            const char *pat = pattern_.data();
+            size_t last_start = n - m;
+
+            size_t i = 0;
+            size_t misses = 0;
+            while (i <= last_start) {
+                auto *hit = static_cast<const char *>(std::memchr(data + i, pat[0], last_start - i + 1));
+                if (!hit) return npos;
+                i = static_cast<size_t>(hit - data);
+                if (std::memcmp(hit + 1, pat + 1, m - 1) == 0) return i;
+                ++i;
+                // 平均每 256 字节多于一次误报，说明是文本，memchr 每次都停下来反而更慢
+                if (++misses > 16 + (i >> 8)) return horspool(data, n, i);
+            }
+            return npos;
+        }
+
+        // 找不到时，前面这么多字节一定不是模式的开头，可以放心交出去；其余的可能是被切断的模式前缀
+        size_t safe_prefix(size_t n) const {
+            return n >= pattern_.size() ? n - (pattern_.size() - 1) : 0;
+        }
+
+    private:
+        size_t horspool(const char *data, size_t n, size_t from) const {
+            size_t m = pattern_.size();
+            const char *pat = pattern_.data();
+            const char last = pat[m - 1];
+            for (size_t i = from; i <= n - m;) {
+                char c = data[i + m - 1];
+                if (c == last && std::memcmp(data + i, pat, m - 1) == 0) return i;
+                i += shift_[static_cast<unsigned char>(c)];
+            }
+            return npos;
+        }
+
+        std::string pattern_;
+        std::array<size_t, 256> shift_{};
+    };
+
     class MultipartProcessor {
     public:
         enum class State {
@@ -42,100 +107,148 @@ namespace gee {
 
         /**
          * 核心流式处理函数：将网络数据切片并投递到 IO 线程池
+         * 数据拷进定长的块里就地解析，已处理的字节只移动下标，不从头部 erase；
+         * 文件内容以 (块的引用, 偏移, 长度) 交给 IO 线程，不再另外拷贝一份
          */
         bool feed(std::string_view chunk) {
-            buffer_.append(chunk.data(), chunk.size());
+            while (!chunk.empty()) {
+                if (!block_ || end_ == kBlockSize) {
+                    if (!next_block()) return false;
+                }
+                size_t n = std::min(chunk.size(), kBlockSize - end_);
+                std::memcpy(block_.get() + end_, chunk.data(), n);
+                end_ += n;
+                chunk.remove_prefix(n);
+                if (!process()) return false;
+            }
+            return true;
+        }
+
+        void finish() {
+            // 数据流在文件中途结束（没有收到结尾的 boundary）：把已收到的部分全部写出
+            // 同时保证之前的异步写入在 IO 线程里刷出并关闭文件
+            if (state_ == State::READ_PART_BODY) {
+                begin_ = end_;
+                flush_body(true);
+                saved_filenames_.push_back(current_path_);
+                state_ = State::FINISHED;
+            }
+        }
+
+    private:
+        // 每块 256KB：一次 IO 任务最多写这么多，读缓冲区的一次 read 也远小于它
+        static constexpr size_t kBlockSize = 256 * 1024;
+        // 攒够这么多文件内容再投递一次，避免每个网络分片都产生一个 IO 任务
+        static constexpr size_t kFlushBytes = 64 * 1024;
+        // 单个 part 的 Header 上限
+        static constexpr size_t kMaxPartHeader = 16 * 1024;
+
+        // 当前块写满：先把已确认的文件内容交出去，再把未处理的尾巴（最多一个 boundary 长度）搬到新块开头
+        bool next_block() {
+            size_t carry = end_ - begin_;
+            if (block_ && carry == kBlockSize) return false;
+            if (state_ == State::READ_PART_BODY) flush_body(false);
+
+            if (block_ && !handed_out_) {
+                // 没有切片交给过 IO 线程（例如只有 Header 和前导内容），原地复用。
+                // 交出去过就不能看 use_count：IO 线程放掉引用时没有 acquire 同步，计数降到 1 也不代表它已经读完
+                std::memmove(block_.get(), block_.get() + begin_, carry);
+            } else {
+                std::shared_ptr<char> fresh(new char[kBlockSize], std::default_delete<char[]>());
+                if (carry > 0) std::memcpy(fresh.get(), block_.get() + begin_, carry);
+                block_ = std::move(fresh);
+            }
+            begin_ = 0;
+            end_ = carry;
+            emit_from_ = 0;
+            handed_out_ = false;
+            return true;
+        }
+
+        bool process() {
+            while (begin_ < end_) {
+                const char *p = block_.get() + begin_;
+                size_t avail = end_ - begin_;
 
-            while (!buffer_.empty()) {
                 switch (state_) {
                     case State::FIND_BOUNDARY: {
-                        auto pos = buffer_.find(boundary_);
-                        size_t b_len = boundary_.size();
-                        if (pos == std::string::npos && buffer_.find(first_boundary_) == 0) {
-                            pos = 0;
-                            b_len = first_boundary_.size();
+                        if (at_start_) {
+                            // 请求体直接以 "--boundary" 开头，前面没有 \r\n
+                            size_t k = std::min(avail, first_boundary_.size());
+                            if (std::memcmp(p, first_boundary_.data(), k) == 0) {
+                                if (k < first_boundary_.size()) return true;
+                                begin_ += k;
+                                at_start_ = false;
+                                state_ = State::READ_PART_HEADER;
+                                break;
+                            }
+                            at_start_ = false;
                         }
 
-                        if (pos != std::string::npos) {
-                            buffer_.erase(0, pos + b_len);
-                            state_ = State::READ_PART_HEADER;
-                        } else {
-                            keep_tail_for_safety();
+                        size_t pos = boundary_.find(p, avail);
+                        if (pos == BoundaryMatcher::npos) {
+                            // 前导内容直接丢弃，只留下可能是被切断的 boundary 的尾巴
+                            begin_ += boundary_.safe_prefix(avail);
                             return true;
                         }
+                        begin_ += pos + boundary_.size();
+                        state_ = State::READ_PART_HEADER;
                         break;
                     }
 
                     case State::READ_PART_HEADER: {
-                        auto pos = buffer_.find("\r\n\r\n");
-                        if (pos != std::string::npos) {
-                            std::string_view header_part(buffer_.data(), pos);
-                            parse_part_header(header_part);
-                            buffer_.erase(0, pos + 4);
-
-                            state_ = State::READ_PART_BODY;
-                        } else {
+                        if (avail < 2) return true;
+                        if (p[0] == '-' && p[1] == '-') {
+                            // "--boundary--"：结束分隔符，之后的内容忽略
+                            state_ = State::FINISHED;
+                            break;
+                        }
+
+                        auto pos = std::string_view(p, avail).find("\r\n\r\n");
+                        if (pos == std::string_view::npos) {
                             // 数据不足以解析 Header，保留并等待下一块
-                            return true;
+                            return avail <= kMaxPartHeader;
                         }
+                        parse_part_header(std::string_view(p, pos));
+                        current_path_ = save_path_ + current_filename_;
+                        begin_ += pos + 4;
+                        emit_from_ = begin_;
+                        state_ = State::READ_PART_BODY;
                         break;
                     }
 
                     case State::READ_PART_BODY: {
-                        auto pos = buffer_.find(boundary_);
-                        std::string full_path = save_path_ + current_filename_;
-
-                        if (pos != std::string::npos) {
+                        size_t pos = boundary_.find(p, avail);
+                        if (pos != BoundaryMatcher::npos) {
                             // 1. 找到了下一个边界，提交该文件的最后一块数据，并触发 fsync
-                            if (pos > 0) {
-                                io_pool_->addTask(full_path, std::string(buffer_.data(), pos), true);
-                            }
-
-                            saved_filenames_.push_back(full_path);
-                            buffer_.erase(0, pos);
+                            begin_ += pos;
+                            flush_body(true);
+                            saved_filenames_.push_back(current_path_);
                             state_ = State::FIND_BOUNDARY;
-                        } else {
-                            // 2. 没找到边界，将安全长度以外的数据异步刷入线程池
-                            if (buffer_.size() > boundary_.size()) {
-                                size_t write_len = buffer_.size() - boundary_.size();
-
-                                // 这里必须进行 string 拷贝，因为 buffer_ 马上要被 erase
-                                io_pool_->addTask(full_path, std::string(buffer_.data(), write_len), false);
-
-                                buffer_.erase(0, write_len);
-                            }
-                            return true;
+                            break;
                         }
-                        break;
+                        // 2. 没找到边界，安全长度以内的数据确认是文件内容，攒够了再投递
+                        begin_ += boundary_.safe_prefix(avail);
+                        if (begin_ - emit_from_ >= kFlushBytes) flush_body(false);
+                        return true;
                     }
-                }
-            }
-            return true;
-        }
 
-        void finish() {
-            // 如果 buffer_ 中还有残留数据（通常是最后一个 boundary 之后的内容）
-            // 或者仅仅是为了确保之前的异步写入全部落盘
-            if (!current_filename_.empty()) {
-                std::string full_path = save_path_ + current_filename_;
-
-                // 投递一个空数据任务，但 should_fsync 设为 true
-                // 这样 IO 线程在写完之前的队列后，会执行一次 fsync
-                io_pool_->addTask(full_path, "", true);
-
-                // 记录文件名（如果最后一块还没记录的话）
-                if (std::find(saved_filenames_.begin(), saved_filenames_.end(), full_path) == saved_filenames_.end()) {
-                    saved_filenames_.push_back(full_path);
+                    case State::FINISHED:
+                        begin_ = end_;
+                        return true;
                 }
             }
+            return true;
         }
 
-    private:
-        // 防止边界字符串被分片切断，保留末尾一段
-        void keep_tail_for_safety() {
-            if (buffer_.size() > boundary_.size()) {
-                buffer_.erase(0, buffer_.size() - boundary_.size());
+        // 把 [emit_from_, begin_) 按引用交给 IO 线程
+        void flush_body(bool fsync) {
+            size_t n = begin_ - emit_from_;
+            if (n > 0 || fsync) {
+                io_pool_->addTask(current_path_, block_, std::string_view(block_.get() + emit_from_, n), fsync);
+                handed_out_ = true;
             }
+            emit_from_ = begin_;
         }
 
         void parse_part_header(std::string_view header) {
@@ -156,14 +269,22 @@ namespace gee {
             }
         }
 
-        std::string boundary_;
+        BoundaryMatcher boundary_;
         std::string first_boundary_;
-        std::string buffer_;
         State state_;
+        bool at_start_ = true;
         std::string save_path_;
         std::string current_filename_;
+        std::string current_path_;
         std::vector<std::string> saved_filenames_;
 
+        // 当前块：[begin_, end_) 是还没处理的数据，[emit_from_, begin_) 是已确认、还没投递的文件内容
+        std::shared_ptr<char> block_;
+        size_t begin_ = 0;
+        size_t end_ = 0;
+        size_t emit_from_ = 0;
+        bool handed_out_ = false; // 当前块已经有切片交给 IO 线程，写满后换新块
+
         // IO 线程池指针，由外部 Request 对象在 handle_multipart_streaming 中传入
         IOTaskPool *io_pool_;
     };
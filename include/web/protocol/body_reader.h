@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+
+namespace gee {
+    struct Request;
+    class Params;
+
+    /**
+     * @brief 流式请求体读取器：ctx->BodyReader().read(buf, len)
+     * 支持三种来源：已经整段缓冲好的 Body、Content-Length 定长 Body、Transfer-Encoding: chunked。
+     * 后两种直接从连接读缓冲区里取数据，交给调用方的字节马上从缓冲区删掉，
+     * 数据没到时在 Netpoller 上挂起协程，处理大上传时内存占用与 Body 大小无关。
+     */
+    class BodyReader {
+    public:
+        // params 是路由参数：视图同样指向读缓冲区里的 path，换 slab 时要一起平移
+        BodyReader(Request &req, int fd, Params *params = nullptr) : req_(req), params_(params), fd_(fd) {
+        }
+
+        /**
+         * @brief 读最多 len 字节解码后的 Body
+         * @return >0 读到的字节数；0 表示 Body 已读完；-1 表示连接断开或分块格式错误
+         */
+        ssize_t read(char *buf, size_t len);
+
+        // 读出剩余的全部 Body 追加到 out；超过 limit 返回 false
+        bool read_all(std::string &out, size_t limit);
+
+        // 丢弃剩余 Body，使连接可以继续处理下一个请求；超过 limit 或出错返回 false
+        bool drain(size_t limit);
+
+        bool started() const { return started_; }
+        bool done() const { return state_ == State::Done; }
+        bool failed() const { return state_ == State::Failed; }
+        // 已交给调用方的解码后字节数
+        size_t consumed() const { return consumed_; }
+
+        // 复用连接时回到初始状态
+        void reset();
+
+    private:
+        enum class State : uint8_t {
+            Buffered, // Body 已在 req_.body 中
+            Length, // 剩余 remaining_ 字节待读
+            ChunkSize, // 解析分块长度的十六进制数字
+            ChunkExt, // 跳过分块扩展，直到行尾
+            ChunkData, // 分块数据，剩余 remaining_ 字节
+            ChunkEnd, // 分块数据后的 CRLF
+            Trailer, // 0 长度块之后的 trailer 行
+            Done,
+            Failed,
+        };
+
+        void begin();
+
+        // 缓冲区里 Header 之后没有可处理的数据时从 socket 读一次
+        bool fill();
+
+        // 用 Header 之后的字节推进分块解码状态，解码出的数据写入 buf
+        size_t decode_chunked(char *buf, size_t len);
+
+        Request &req_;
+        Params *params_;
+        int fd_;
+        State state_ = State::Buffered;
+        bool started_ = false;
+        size_t remaining_ = 0;
+        size_t consumed_ = 0;
+        int size_digits_ = 0;
+        size_t line_len_ = 0; // 当前 trailer 行的长度
+        size_t trailer_bytes_ = 0;
+    };
+}
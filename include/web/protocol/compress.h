@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+#include <zlib.h>
+
+namespace gee {
+    enum class Encoding { Identity, Gzip, Deflate };
+
+    // Accept-Encoding 协商：按 q 值选 gzip / deflate，都不可接受时返回 Identity
+    Encoding negotiate_encoding(std::string_view accept_encoding);
+
+    // "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n" 这类预渲染 Header 行
+    std::string_view encoding_header(Encoding enc);
+
+    // 适合压缩的 Content-Type（文本类），图片、字体等已压缩格式跳过
+    bool compressible_type(std::string_view type_line);
+
+    /**
+     * @brief 流式压缩器
+     * 输入按片送入，每压完一片在协程里让出一次 CPU，大响应不会长时间占住 Worker
+     */
+    class Deflater {
+    public:
+        Deflater(Encoding enc, int level);
+
+        ~Deflater();
+
+        Deflater(const Deflater &) = delete;
+
+        Deflater &operator=(const Deflater &) = delete;
+
+        bool ok() const { return ok_; }
+
+        // 追加输入，压缩结果写到 out 末尾
+        bool write(std::string_view in, std::string &out);
+
+        // 把已送入的数据全部压出（Z_SYNC_FLUSH），流式响应每发一块调用一次
+        bool sync(std::string &out);
+
+        // 结束压缩流，写出尾部
+        bool finish(std::string &out);
+
+        static constexpr size_t kSlice = 64 * 1024;
+
+    private:
+        bool pump(int flush, std::string &out);
+
+        z_stream zs_{};
+        bool ok_ = false;
+    };
+
+    // 一次性压缩；失败时返回 false，out 内容未定义
+    bool compress_body(std::string_view in, Encoding enc, int level, std::string &out);
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace gee {
+    // 常用 Header 的预置编号，解析时识别一次，之后按编号 O(1) 查找
+    enum class HeaderId : uint8_t {
+        Host,
+        Connection,
+        ContentLength,
+        ContentType,
+        TransferEncoding,
+        AcceptEncoding,
+        Upgrade,
+        Unknown
+    };
+
+    // ASCII 大小写不敏感比较
+    inline bool iequals_ascii(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            char x = a[i], y = b[i];
+            if (x >= 'A' && x <= 'Z') x = static_cast<char>(x + 32);
+            if (y >= 'A' && y <= 'Z') y = static_cast<char>(y + 32);
+            if (x != y) return false;
+        }
+        return true;
+    }
+
+    // 逗号分隔的 Header 值里有没有 token（忽略大小写与两侧空白），例如 Connection: keep-alive, Upgrade
+    bool header_has_token(std::string_view list, std::string_view token);
+
+    /**
+     * @brief 请求头存储：指向读缓冲区的 string_view 对，常见请求全部放在内联数组里，不做堆分配
+     * 查找大小写不敏感，超过内联容量的部分才落到 vector
+     */
+    class HeaderMap {
+    public:
+        using Entry = std::pair<std::string_view, std::string_view>;
+
+        static constexpr size_t kInline = 32;
+
+        static HeaderId id_of(std::string_view name);
+
+        void add(std::string_view name, std::string_view value);
+
+        std::string_view get(HeaderId id) const {
+            uint8_t slot = known_[static_cast<size_t>(id)];
+            return slot ? at(slot - 1).second : std::string_view();
+        }
+
+        std::string_view get(std::string_view name) const;
+
+        bool contains(std::string_view name) const { return get(name).data() != nullptr; }
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        const Entry &at(size_t i) const { return i < kInline ? inline_[i] : overflow_[i - kInline]; }
+
+        template<typename F>
+        void for_each(F &&f) const {
+            for (size_t i = 0; i < size_; ++i) {
+                const Entry &e = at(i);
+                f(e.first, e.second);
+            }
+        }
+
+        void clear() {
+            size_ = 0;
+            overflow_.clear();
+            known_.fill(0);
+        }
+
+        // 底层缓冲区搬家后，把落在 [old_base, old_base + len) 内的视图平移到 new_base
+        void rebase(const char *old_base, size_t len, const char *new_base);
+
+    private:
+        Entry &at(size_t i) { return i < kInline ? inline_[i] : overflow_[i - kInline]; }
+
+        std::array<Entry, kInline> inline_{};
+        std::vector<Entry> overflow_;
+        size_t size_ = 0;
+        // 预置 Header 在数组中的位置 + 1，0 表示不存在；重复出现时保留第一个
+        std::array<uint8_t, static_cast<size_t>(HeaderId::Unknown)> known_{};
+    };
+}
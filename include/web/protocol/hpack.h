@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace gee {
+    // 解码后的一组 Header，名字都是小写；伪头（:method 等）排在前面
+    using HeaderList = std::vector<std::pair<std::string, std::string> >;
+
+    /**
+     * @brief HPACK 索引表（RFC 7541 §2.3）：下标从 1 开始，1-61 是静态表，之后是动态表
+     * 动态表新条目插在最前面，总大小（名字 + 值 + 32）超过上限时从最旧的开始淘汰
+     */
+    class HpackTable {
+    public:
+        static constexpr size_t kStaticCount = 61;
+
+        explicit HpackTable(size_t max_size = 4096) : max_size_(max_size) {
+        }
+
+        bool get(size_t index, std::string_view &name, std::string_view &value) const;
+
+        void add(std::string_view name, std::string_view value);
+
+        void set_max_size(size_t n);
+
+        size_t max_size() const { return max_size_; }
+
+        // 查找完整匹配（exact = true）或只有名字匹配的下标，0 表示没找到
+        size_t find(std::string_view name, std::string_view value, bool &exact) const;
+
+    private:
+        std::deque<std::pair<std::string, std::string> > entries_; // 头部最新
+        size_t size_ = 0;
+        size_t max_size_;
+    };
+
+    class HpackDecoder {
+    public:
+        // max_table 是我们在 SETTINGS_HEADER_TABLE_SIZE 里通告的上限
+        explicit HpackDecoder(size_t max_table = 4096, size_t max_list_bytes = 64 * 1024)
+            : table_(max_table), limit_(max_table), max_list_bytes_(max_list_bytes) {
+        }
+
+        /**
+         * @brief 解码一个完整的 header block 追加到 out
+         * @return false 表示格式错误或超过大小上限，按 COMPRESSION_ERROR 关闭连接
+         */
+        bool decode(std::string_view block, HeaderList &out);
+
+    private:
+        HpackTable table_;
+        size_t limit_;
+        size_t max_list_bytes_;
+    };
+
+    /**
+     * @brief 响应头编码器
+     * :status 和常见头优先用静态表；取值稳定的头（content-type、server 等）加入动态表，
+     * 同一连接上的后续响应只需一个字节；其余按字面量不索引发送，不做 Huffman 编码。
+     * 动态表的状态依赖编码顺序，调用方保证按发送顺序编码。
+     */
+    class HpackEncoder {
+    public:
+        // 对端 SETTINGS_HEADER_TABLE_SIZE 变化，下一个 block 开头会带上动态表大小更新
+        void set_max_table_size(size_t n);
+
+        // 开始一个新的 header block：写 :status
+        void encode_status(int code, std::string &out);
+
+        // name 必须是小写
+        void encode(std::string_view name, std::string_view value, std::string &out);
+
+    private:
+        HpackTable table_;
+        bool size_update_ = false;
+    };
+
+    // Huffman 解码（RFC 7541 附录 B），填充位不合法或出现 EOS 返回 false
+    bool hpack_huffman_decode(std::string_view in, std::string &out);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace gee {
+    /**
+     * @brief 可续传的 HTTP/1.x 请求头解析器
+     * 记住上次扫描到的位置，每个字节只扫描一次；请求行与 Header 在同一遍扫描中解析。
+     * 结果都以相对缓冲区起点的偏移保存，缓冲区搬家后依然有效。
+     */
+    class HttpParser {
+    public:
+        enum class Status { Incomplete, Done, Error };
+
+        struct Span {
+            uint32_t off = 0;
+            uint32_t len = 0;
+
+            std::string_view in(std::string_view buf) const { return buf.substr(off, len); }
+        };
+
+        struct Field {
+            Span name;
+            Span value;
+        };
+
+        static constexpr size_t kMaxFields = 100;
+
+        /**
+         * @param buf 从本请求第一个字节开始的全部已读数据，每次调用只会更长不会变短
+         */
+        Status feed(std::string_view buf);
+
+        // 复用连接时重置；fields_ 是定长数组，只需清零计数
+        void reset() {
+            state_ = State::RequestLine;
+            line_start_ = scan_ = 0;
+            method_ = target_ = version_ = Span();
+            field_count_ = 0;
+            header_size_ = content_length_ = 0;
+            has_content_length_ = chunked_ = false;
+        }
+
+        bool done() const { return state_ == State::Done; }
+
+        Span method() const { return method_; }
+        Span target() const { return target_; }
+        Span version() const { return version_; }
+        size_t field_count() const { return field_count_; }
+        const Field &field(size_t i) const { return fields_[i]; }
+
+        size_t header_size() const { return header_size_; }
+        size_t content_length() const { return content_length_; }
+        bool has_content_length() const { return has_content_length_; }
+        bool chunked() const { return chunked_; }
+
+    private:
+        enum class State { RequestLine, HeaderLine, Done, Error };
+
+        bool parse_request_line(std::string_view line, uint32_t base);
+
+        bool parse_header_line(std::string_view line, uint32_t base);
+
+        State state_ = State::RequestLine;
+        size_t line_start_ = 0; // 当前行的起点
+        size_t scan_ = 0; // 已经扫描过的位置，下次从这里继续
+
+        Span method_;
+        Span target_;
+        Span version_;
+        std::array<Field, kMaxFields> fields_; // 定长，解析过程不做堆分配
+        size_t field_count_ = 0;
+
+        size_t header_size_ = 0;
+        size_t content_length_ = 0;
+        bool has_content_length_ = false;
+        bool chunked_ = false;
+    };
+
+    // 从 p 开始查找第一个控制字符（< 0x20 或 0x7f），找不到返回 end；SIMD 实现，带标量兜底
+    const char *find_ctl(const char *p, const char *end);
+}
@@ -0,0 +1,222 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace gee {
+    /**
+     * @brief 按需（pull 式）JSON 解析器
+     * 不建 DOM：调用方按自己期望的结构一步步取值，用不到的值用 skip() 跳过，只做括号配对不分配内存。
+     * 字符串没有转义时直接返回指向原文的视图；找字符串结尾与 JsonWriter 共用 SIMD 扫描。
+     * 任何一步失败后 ok() 变为 false，之后的调用都直接返回 false。
+     *
+     *     JsonReader r(body);
+     *     std::string_view key;
+     *     if (r.begin_object()) {
+     *         while (r.next_key(key)) {
+     *             if (key == "id") r.read(id);
+     *             else r.skip();
+     *         }
+     *     }
+     */
+    class JsonReader {
+    public:
+        enum class Type : uint8_t { Null, Bool, Number, String, Array, Object, Invalid };
+
+        explicit JsonReader(std::string_view text) : s_(text) {
+        }
+
+        // 下一个值的类型，不消耗输入
+        Type peek();
+
+        bool begin_object();
+
+        // 取下一个键，自动处理逗号；遇到 '}' 返回 false。带转义的键会解码后返回
+        bool next_key(std::string_view &key);
+
+        bool begin_array();
+
+        // 数组里还有下一个元素返回 true，自动处理逗号；遇到 ']' 返回 false
+        bool next_element();
+
+        // 字符串原文（引号之间、未解码转义），零拷贝
+        bool read_raw(std::string_view &out);
+
+        // 字符串，解码转义（含 \uXXXX 与代理对）
+        bool read(std::string &out);
+
+        bool read(bool &out);
+
+        bool read(double &out);
+
+        bool read(float &out) {
+            double d;
+            if (!read(d)) return false;
+            out = static_cast<float>(d);
+            return true;
+        }
+
+        template<typename T, typename std::enable_if<std::is_integral<T>::value
+                                                     && !std::is_same<T, bool>::value, int>::type = 0>
+        bool read(T &out) {
+            std::string_view num;
+            if (!number(num)) return false;
+            auto [end, ec] = std::from_chars(num.data(), num.data() + num.size(), out);
+            if (ec != std::errc() || end != num.data() + num.size()) return fail("integer expected");
+            return true;
+        }
+
+        bool read_null();
+
+        // 跳过任意一个值（包括整个对象/数组）
+        bool skip();
+
+        // 顶层值之后只剩空白
+        bool end();
+
+        bool ok() const { return err_ == nullptr; }
+        const char *error() const { return err_ ? err_ : ""; }
+        size_t offset() const { return pos_; }
+
+        // 整段 UTF-8 是否合法：ASCII 部分 16 字节一批跳过，遇到多字节序列再逐个校验
+        static bool valid_utf8(std::string_view s);
+
+    private:
+        static constexpr int kMaxDepth = 64;
+
+        bool fail(const char *msg) {
+            if (!err_) err_ = msg;
+            return false;
+        }
+
+        void skip_ws() {
+            while (pos_ < s_.size()) {
+                char c = s_[pos_];
+                if (c != ' ' && c != '\n' && c != '\r' && c != '\t') break;
+                ++pos_;
+            }
+        }
+
+        // 跳过空白后期望字符 c
+        bool expect(char c);
+
+        bool push(bool object);
+
+        // 容器内下一个条目：处理 '}' / ']' 与逗号
+        bool next_item(char close);
+
+        // 数字原文，只按 JSON 语法校验
+        bool number(std::string_view &out);
+
+        // pos_ 指向开头引号，结束时 pos_ 在结尾引号之后；has_escape 表示原文里有反斜杠
+        bool scan_string(std::string_view &raw, bool &has_escape);
+
+        static bool unescape(std::string_view raw, std::string &out);
+
+        std::string_view s_;
+        size_t pos_ = 0;
+        const char *err_ = nullptr;
+        int depth_ = 0;
+        uint64_t object_bits_ = 0; // 每层是否为对象
+        uint64_t first_bits_ = 0; // 每层是否还没有条目
+        std::string key_buf_; // 带转义的键解码在这里
+    };
+
+    /**
+     * @brief 声明式字段绑定：类型提供 json_fields()，BindJSON 按键名把值直接写进成员
+     *
+     *     struct LoginForm {
+     *         std::string username;
+     *         int age = 0;
+     *         static auto json_fields() {
+     *             return std::make_tuple(gee::json_field("username", &LoginForm::username),
+     *                                    gee::json_field("age", &LoginForm::age));
+     *         }
+     *     };
+     *
+     * 支持字符串、数值、bool、std::vector、std::optional 与嵌套的同类结构体；未声明的键跳过。
+     */
+    template<typename C, typename M>
+    struct JsonField {
+        std::string_view name;
+        M C::*member;
+    };
+
+    template<typename C, typename M>
+    constexpr JsonField<C, M> json_field(std::string_view name, M C::*member) { return {name, member}; }
+
+    template<typename T>
+    bool json_read(JsonReader &r, T &out);
+
+    namespace detail {
+        template<typename T, typename = void>
+        struct has_json_fields : std::false_type {
+        };
+
+        template<typename T>
+        struct has_json_fields<T, std::void_t<decltype(T::json_fields())> > : std::true_type {
+        };
+
+        template<typename T>
+        struct is_vector : std::false_type {
+        };
+
+        template<typename T, typename A>
+        struct is_vector<std::vector<T, A> > : std::true_type {
+        };
+
+        template<typename T>
+        struct is_optional : std::false_type {
+        };
+
+        template<typename T>
+        struct is_optional<std::optional<T> > : std::true_type {
+        };
+
+        template<typename T>
+        bool bind_object(JsonReader &r, T &out) {
+            static const auto fields = T::json_fields();
+            if (!r.begin_object()) return false;
+            std::string_view key;
+            while (r.next_key(key)) {
+                bool matched = false;
+                bool ok = true;
+                std::apply([&](const auto &... f) {
+                    (void) ((f.name == key ? (matched = true, ok = json_read(r, out.*(f.member)), true) : false) || ...);
+                }, fields);
+                if (!matched) ok = r.skip();
+                if (!ok) return false;
+            }
+            return r.ok();
+        }
+    }
+
+    // 把下一个值读进 out，类型决定期望的 JSON 结构
+    template<typename T>
+    bool json_read(JsonReader &r, T &out) {
+        if constexpr (detail::has_json_fields<T>::value) {
+            return detail::bind_object(r, out);
+        } else if constexpr (detail::is_vector<T>::value) {
+            if (!r.begin_array()) return false;
+            out.clear();
+            while (r.next_element()) {
+                out.emplace_back();
+                if (!json_read(r, out.back())) return false;
+            }
+            return r.ok();
+        } else if constexpr (detail::is_optional<T>::value) {
+            if (r.peek() == JsonReader::Type::Null) {
+                out.reset();
+                return r.read_null();
+            }
+            return json_read(r, out.emplace());
+        } else {
+            return r.read(out);
+        }
+    }
+}
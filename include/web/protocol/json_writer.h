@@ -0,0 +1,182 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace gee {
+    /**
+     * @brief 直接往调用方缓冲区里写 JSON
+     * 逗号由写入器自己管理；字符串按 RFC 8259 转义，没有需要转义的字符时按 16 字节一批扫描后整段追加；
+     * 整数与浮点数用 std::to_chars 格式化，不产生临时 string。
+     *
+     *     JsonWriter w(buf);
+     *     w.begin_object();
+     *     w.field("id", 1).field("name", name);
+     *     w.end_object();
+     */
+    class JsonWriter {
+    public:
+        explicit JsonWriter(std::string &out) : out_(out) {
+        }
+
+        // 底层缓冲区，可以预留容量或与旧的 append 式代码混用
+        std::string &buffer() { return out_; }
+
+        JsonWriter &begin_object() {
+            sep();
+            out_.push_back('{');
+            need_comma_ = false;
+            return *this;
+        }
+
+        JsonWriter &end_object() {
+            out_.push_back('}');
+            need_comma_ = true;
+            return *this;
+        }
+
+        JsonWriter &begin_array() {
+            sep();
+            out_.push_back('[');
+            need_comma_ = false;
+            return *this;
+        }
+
+        JsonWriter &end_array() {
+            out_.push_back(']');
+            need_comma_ = true;
+            return *this;
+        }
+
+        // 对象里的键，后面必须紧跟一个值
+        JsonWriter &key(std::string_view k) {
+            put_string(k, ':');
+            need_comma_ = false;
+            return *this;
+        }
+
+        // 源码里的字面量键按约定只含普通字符，跳过转义扫描，长度在编译期已知
+        template<size_t N>
+        JsonWriter &key(const char (&k)[N]) {
+            // 字面量的长度编译器会直接折叠；普通字符数组也按实际长度处理
+            size_t n = std::char_traits<char>::length(k);
+            char buf[N + 3];
+            char *p = buf;
+            if (need_comma_) *p++ = ',';
+            *p++ = '"';
+            std::memcpy(p, k, n);
+            p += n;
+            *p++ = '"';
+            *p++ = ':';
+            out_.append(buf, static_cast<size_t>(p - buf));
+            need_comma_ = false;
+            return *this;
+        }
+
+        JsonWriter &value(std::string_view s) {
+            put_string(s, 0);
+            need_comma_ = true;
+            return *this;
+        }
+
+        JsonWriter &value(const char *s) { return value(std::string_view(s)); }
+        JsonWriter &value(const std::string &s) { return value(std::string_view(s)); }
+
+        JsonWriter &value(bool b) {
+            sep();
+            out_.append(b ? "true" : "false");
+            need_comma_ = true;
+            return *this;
+        }
+
+        template<typename T, typename std::enable_if<std::is_integral<T>::value
+                                                     && !std::is_same<T, bool>::value, int>::type = 0>
+        JsonWriter &value(T n) {
+            // 逗号和数字拼在栈上一次追加；digits10 + 1 位数字，再加符号和逗号（__int128 也放得下）
+            char buf[std::numeric_limits<T>::digits10 + 3];
+            char *p = buf;
+            if (need_comma_) *p++ = ',';
+            auto [end, ec] = std::to_chars(p, buf + sizeof(buf), n);
+            if (ec != std::errc()) return null();
+            out_.append(buf, end);
+            need_comma_ = true;
+            return *this;
+        }
+
+        // NaN / Inf 在 JSON 里没有表示，写成 null
+        JsonWriter &value(double d);
+
+        JsonWriter &value(float f) { return value(static_cast<double>(f)); }
+
+        JsonWriter &null() {
+            sep();
+            out_.append("null");
+            need_comma_ = true;
+            return *this;
+        }
+
+        // 追加一段已经是合法 JSON 的文本
+        JsonWriter &raw(std::string_view json) {
+            sep();
+            out_.append(json);
+            need_comma_ = true;
+            return *this;
+        }
+
+        template<typename T>
+        JsonWriter &field(std::string_view k, T &&v) {
+            key(k);
+            return value(std::forward<T>(v));
+        }
+
+        template<size_t N, typename T>
+        JsonWriter &field(const char (&k)[N], T &&v) {
+            key(k);
+            return value(std::forward<T>(v));
+        }
+
+        // 把 s 加上引号并转义后追加到 out
+        static void escape(std::string &out, std::string_view s);
+
+    private:
+        void sep() {
+            if (need_comma_) out_.push_back(',');
+        }
+
+        // 写一个带引号的字符串，suffix 非 0 时紧跟在后面（键后面的冒号）
+        void put_string(std::string_view s, char suffix);
+
+        std::string &out_;
+        bool need_comma_ = false;
+    };
+
+    namespace detail {
+        // 返回 [i, n) 中第一个 '"'、'\\' 或控制字符的位置，没有则返回 n；JsonReader 找字符串结尾也用它
+        size_t find_escape(const char *s, size_t i, size_t n);
+
+        template<typename T, typename = void>
+        struct has_writer_json : std::false_type {
+        };
+
+        template<typename T>
+        struct has_writer_json<T, std::void_t<decltype(std::declval<const T &>().write_json(
+            std::declval<JsonWriter &>()))> > : std::true_type {
+        };
+    }
+
+    // 序列化一个对象：优先用 write_json(JsonWriter&)，只有旧的 write_json(std::string&) 时退回旧接口
+    template<typename T>
+    void write_model(JsonWriter &w, const T &m) {
+        if constexpr (detail::has_writer_json<T>::value) {
+            m.write_json(w);
+        } else {
+            w.raw({}); // 先补上逗号并记下已写入一个值
+            m.write_json(w.buffer());
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <sys/types.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gee {
+    /**
+     * @brief 连接级输出队列
+     * 流水线请求的响应按顺序排队，攒够一批后用一次 writev 发出。
+     * 每个响应由若干块组成：自有的 string（按移动接管，不拷贝）、借用的内存片段，
+     * 或文件区间（走 sendfile，不经过用户态）。
+     */
+    class OutputQueue {
+    public:
+        void push(std::string &&data) {
+            if (data.empty()) return;
+            bytes_ += data.size();
+            chunks_.push_back({std::move(data), nullptr, 0, nullptr, -1, 0});
+        }
+
+        // 借用外部内存，调用方保证其在 flush 之前有效（通常是静态预渲染片段）
+        void push_static(std::string_view data) {
+            if (data.empty()) return;
+            bytes_ += data.size();
+            chunks_.push_back({std::string(), data.data(), data.size(), nullptr, -1, 0});
+        }
+
+        // 借用由 owner 持有的内存（例如 mmap 缓存），写完之前 owner 不会释放
+        void push_shared(std::string_view data, std::shared_ptr<const void> owner) {
+            if (data.empty()) return;
+            bytes_ += data.size();
+            chunks_.push_back({std::string(), data.data(), data.size(), std::move(owner), -1, 0});
+        }
+
+        // 文件区间 [offset, offset + len)，owner 负责在写完之后关闭 file_fd
+        void push_file(int file_fd, off_t offset, size_t len, std::shared_ptr<const void> owner) {
+            if (len == 0) return;
+            bytes_ += len;
+            chunks_.push_back({std::string(), nullptr, len, std::move(owner), file_fd, offset});
+        }
+
+        // 一个完整响应入队完毕
+        void end_response() { ++responses_; }
+
+        bool empty() const { return chunks_.empty(); }
+
+        size_t size() const { return chunks_.size(); }
+
+        // 已排队、尚未写出的响应数
+        size_t responses() const { return responses_; }
+
+        size_t bytes() const { return bytes_; }
+
+        /**
+         * @brief 把队列里的数据全部写出，内核缓冲区满时挂到 netpoller 等待可写
+         * @return false 表示 socket 出错或对端关闭
+         */
+        bool flush(int fd);
+
+        // 不写 socket，flush 时把队列交给 sink 处理（HTTP/2 流把 HTTP/1 格式的响应转换成帧）
+        using Sink = std::function<bool(OutputQueue &)>;
+
+        void redirect(Sink sink) { sink_ = std::move(sink); }
+
+        /**
+         * @brief 按顺序把每一块数据交给 fn 并清空队列，文件区间分段 pread 出来
+         * @return fn 返回 false 或读文件失败时返回 false
+         */
+        bool drain(const std::function<bool(std::string_view)> &fn);
+
+        /**
+         * @brief 把第 first 块及之后排队的字节追加到 dst，不出队（响应缓存取刚写入的完整响应）
+         * @return 其中有文件区间时返回 false
+         */
+        bool copy_since(size_t first, std::string &dst) const;
+
+    private:
+        struct Chunk {
+            std::string owned;
+            const char *ext; // 非空表示借用的片段
+            size_t ext_len; // 借用片段或文件区间的长度
+            std::shared_ptr<const void> keep;
+            int file_fd; // >= 0 表示文件区间
+            off_t file_off;
+
+            bool is_file() const { return file_fd >= 0; }
+            const char *data() const { return ext ? ext : owned.data(); }
+            size_t size() const { return (ext || is_file()) ? ext_len : owned.size(); }
+        };
+
+        // 从 offset 开始把文件区间写完
+        static bool send_file(int fd, const Chunk &c, size_t offset);
+
+        std::vector<Chunk> chunks_;
+        size_t bytes_ = 0;
+        size_t responses_ = 0;
+        Sink sink_;
+    };
+}
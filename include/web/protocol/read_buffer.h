@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <sys/types.h>
+
+namespace gee {
+    // 一块连续内存，头部之后紧跟 cap 字节数据
+    struct Slab {
+        size_t cap;
+        Slab *next; // 空闲链表指针
+
+        char *data() { return reinterpret_cast<char *>(this + 1); }
+        const char *data() const { return reinterpret_cast<const char *>(this + 1); }
+    };
+
+    /**
+     * @brief 每个 worker 线程一个的 slab 池，按规格分级缓存
+     * 协程可能在线程间迁移，归还时进入当前线程的池子即可
+     */
+    class SlabPool {
+    public:
+        static SlabPool &local();
+
+        Slab *acquire(size_t min_cap);
+
+        void release(Slab *slab);
+
+        ~SlabPool();
+
+    private:
+        static constexpr int kClassCount = 6;
+        static const size_t kClassSize[kClassCount];
+        static const size_t kClassKeep[kClassCount];
+
+        static int class_of(size_t cap);
+
+        Slab *free_[kClassCount] = {};
+        size_t count_[kClassCount] = {};
+    };
+
+    /**
+     * @brief 连接读缓冲区：socket 直接读进池化 slab，不再经过栈上临时数组
+     * 可读区 [rpos, wpos) 始终连续，method/path/body 等视图直接指向这里
+     */
+    class ReadBuffer {
+    public:
+        ReadBuffer() = default;
+
+        ~ReadBuffer() { release(); }
+
+        ReadBuffer(const ReadBuffer &) = delete;
+
+        ReadBuffer &operator=(const ReadBuffer &) = delete;
+
+        const char *data() const { return slab_ ? slab_->data() + rpos_ : ""; }
+        size_t size() const { return wpos_ - rpos_; }
+        bool empty() const { return wpos_ == rpos_; }
+        std::string_view view() const { return {data(), size()}; }
+
+        // 保证可读区能连续容纳 n 字节；放不下时把未读数据一次性搬到更大规格的 slab
+        void reserve(size_t n);
+
+        // 直接 read 进 slab 空闲区，返回值与 errno 同 ::read
+        ssize_t read_from(int fd);
+
+        // 丢弃前 n 字节；读空时把 slab 还给池子，空闲的 keep-alive 连接不占缓冲区
+        void consume(size_t n);
+
+        // 只保留前 n 字节，丢弃其后的数据（流式读取时复用 Header 之后的空间）
+        void truncate(size_t n) {
+            if (n < size()) wpos_ = rpos_ + n;
+        }
+
+        // 删除 [off, off + n) 这段，后面的字节前移（流式读 Body 时丢弃已交给调用方的数据）
+        void erase(size_t off, size_t n);
+
+        void release();
+
+    private:
+        Slab *slab_ = nullptr;
+        size_t rpos_ = 0;
+        size_t wpos_ = 0;
+    };
+}
@@ -1,13 +1,19 @@
 #pragma once
+#include <string>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include "web/protocol/header_map.h"
+#include "web/protocol/http_parser.h"
+#include "web/protocol/read_buffer.h"
+
 namespace gee {
     struct Request {
         std::string_view method;
         std::string_view path;
-        std::unordered_map<std::string, std::string> headers;
+        std::string_view version; // HTTP/1.1 或 HTTP/1.0
+        HeaderMap headers; // 指向 raw_data_ 的视图，大小写不敏感
         std::string_view body;
 
         size_t content_length = 0; // Body 长度
@@ -15,21 +21,38 @@ namespace gee {
 
         std::unordered_map<std::string, std::string> post_form_; // 存放 POST 表单数据 (application/x-www-form-urlencoded)
 
-        std::unordered_map<std::string, std::string> params_; //存放user/:name/:age后面的参数
         std::unordered_map<std::string, std::string> query_params_; //存放？name=xx&age=18 后面的参数
 
-        std::vector<char> raw_data_ = {}; //io拷贝时的数组
+        ReadBuffer raw_data_; // 连接读缓冲区，socket 直接读进池化 slab
+        HttpParser parser_; // 可续传的请求头解析器
 
-        // 存放 JSON 对象 (建议集成 nlohmann/json，或者先存为原始 string)
+        // 流式 Body 被 WebContext::Body() 整段读入时的存放处，body 视图指向这里
         std::string json_body_;
 
         bool parse(int client_fd);
 
-        size_t peek_content_length();
+        // parse 拆成两步：keep-alive 连接只对等待 Header 的阶段计空闲超时
+        bool read_header(int client_fd);
+
+        bool read_body(int client_fd);
+
+        // 根据 HTTP 版本与 Connection 头判断客户端是否希望复用连接
+        bool keep_alive() const;
+
+        // 连接可否继续复用：multipart 流式读取可能越界读到下一个请求，读完后只能关闭
+        bool reusable_ = true;
+
+        // Body 没有预先读进来（分块编码或超过缓冲上限），由 BodyReader 按需从连接读取
+        bool body_deferred_ = false;
+
+        // 缓冲区里是否已经有一个完整的请求（流水线），有的话不必等待 socket
+        bool buffered_request_ready();
 
-        size_t find_header_end();
+        // 复用连接时清理上一个请求的状态，raw_data_ 中多读到的字节保留给下一个请求
+        void reset();
 
-        bool do_parse_header(size_t total_header_size);
+        // 解析完成后，按解析器记录的偏移生成 method/path/headers 等视图
+        void apply_header();
 
         void parse_query_string(std::string_view query);
 
@@ -44,10 +67,26 @@ namespace gee {
 
         std::string extract_boundary(std::string_view content_type);
 
-        std::string_view get_header(const std::string &key) const;
+        std::string_view get_header(std::string_view key) const { return headers.get(key); }
+
+        std::string_view get_header(HeaderId id) const { return headers.get(id); }
+
+
+        // raw_data_ 搬到新 slab 后，把指向旧地址的视图平移过去
+        void rebase_views(const char *old_base);
+
+        void rebase_views(const char *old_base, const char *new_base);
+
+        // 把请求头搬进 storage 并从 raw_data_ 移除：连接转去跑长连接协议（WebSocket）后，
+        // 视图仍然有效，读缓冲区读空即可归还 slab
+        void detach_header(std::string &storage);
 
+        // 把 src 的请求行、Header 与查询参数拷过来，视图指向 storage：交给后台协程的请求副本
+        // 不依赖连接的读缓冲区（HTTP/2 流的 HeaderList 也一样），原请求结束后仍然有效
+        void clone_header(const Request &src, std::string &storage);
 
-        ssize_t web_read(int fd, std::vector<char>& buffer);
+        // 读进 raw_data_，数据未到时挂起协程
+        ssize_t web_read(int fd);
 
 
         const std::vector<std::string> &get_uploaded_files() const {
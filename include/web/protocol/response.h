@@ -1,5 +1,12 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include <ctime>
+#include <initializer_list>
+#include <memory>
+
+#include "web/protocol/output_queue.h"
+#include "web/protocol/compress.h"
 
 namespace gee {
     // --- 1. 业务状态码枚举 ---
@@ -29,12 +36,30 @@ namespace gee {
         }
     }
 
+    // 形如 "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"，每线程每秒最多格式化一次
+    std::string_view http_date_header();
+
+    // IMF-fixdate 格式，用于 Last-Modified 等
+    std::string format_http_date(time_t t);
+
+    // 预渲染的 Content-Type 行
+    inline constexpr std::string_view kJsonContentType = "Content-Type: application/json; charset=utf-8\r\n";
+    inline constexpr std::string_view kTextContentType = "Content-Type: text/plain; charset=utf-8\r\n";
+
     // --- 4. 响应实体类 ---
     struct Response {
         int state = 200; // 业务状态码
         std::string message; // 业务描述信息
         std::string body_buffer; // 存储业务 JSON 数据
         bool is_sent = false; // 状态锁：确保一个请求只发送一次
+        bool keep_alive = false; // 由连接循环决定，发送后是否继续复用连接
+        // 压缩参数：由连接循环按配置与 Accept-Encoding 协商后填入
+        Encoding encoding = Encoding::Identity;
+        int compress_level = 6;
+        size_t compress_min = 1024;
+        // 这次请求做过压缩协商：可压缩的响应即使没压缩也要带 Vary: Accept-Encoding，
+        // 否则共享缓存会把原文版本存下来发给支持 gzip 的客户端
+        bool vary_encoding = false;
 
         // 填充业务数据逻辑
         void set_raw_data(int s, const std::string &m, std::string &&raw_json) {
@@ -43,49 +68,40 @@ namespace gee {
             body_buffer = std::move(raw_json); // 移动语义，零拷贝
         }
 
-        // 内部逻辑：将业务字段序列化为 JSON 字符串
-        std::string serialize_json_body() const {
-            std::string root;
-            // 预分配内存：body内容 + message长度 + 基础JSON结构字符
-            root.reserve(body_buffer.size() + message.size() + 64);
-
-            root.append("{\"state\":").append(std::to_string(state));
-            root.append(",\"message\":\"").append(message).append("\"");
-
-            if (!body_buffer.empty()) {
-                root.append(",\"data\":").append(body_buffer);
-            }
-
-            root.append("}");
-            return root;
-        }
-
-        std::string build_http_packet(int http_code, const std::string &text = "") const {
-            // 确定 Body 内容
-            std::string content = text.empty() ? serialize_json_body() : text;
-
-            // 构造完整的 HTTP 报文
-            std::string packet;
-            packet.reserve(content.size() + 128); // 预分配 Header 空间
-
-            // 1. 状态行
-            packet.append("HTTP/1.1 ").append(std::to_string(http_code)).append(" OK\r\n");
-
-            // 2. 头部信息
-            if (text.empty()) {
-                packet.append("Content-Type: application/json; charset=utf-8\r\n");
-            } else {
-                packet.append("Content-Type: text/plain; charset=utf-8\r\n");
-            }
-
-            packet.append("Content-Length: ").append(std::to_string(content.size())).append("\r\n");
-            packet.append("Connection: close\r\n");
-            packet.append("\r\n"); // Header 和 Body 的分界线
-
-            // 3. 报文体
-            packet.append(content);
-
-            return packet;
-        }
+        /**
+         * @brief 把响应按 iovec 片段放进输出队列，连接循环用一次 writev 发出
+         * 状态行、Header 行是预渲染的静态片段；JSON 外壳的前缀和 Header 拼进同一小块，
+         * 业务 body 以移动方式接管，不做拷贝
+         * @param text 非空时按纯文本发送，忽略 JSON 外壳
+         */
+        void write_to(OutputQueue &out, int http_code, std::string_view text = {});
+
+        // JSON 外壳开头：{"state":200,"message":"..." 以及可选的 ,"data":
+        void append_envelope_prefix(std::string &out, bool with_data) const;
+
+        static constexpr size_t kNoLength = static_cast<size_t>(-1);
+
+        /**
+         * @brief 只写状态行与 Header，body 由调用方随后入队（文件、缓存等）
+         * @param type_line 完整的 "Content-Type: ...\r\n"，必须是静态存储
+         * @param content_length 为 kNoLength 时不发送 Content-Length（例如 304）
+         * @param extra 额外的 Header 行，每行以 \r\n 结尾
+         * @param body_prefix 紧跟空行之后、与 Header 同块发送的 body 开头
+         */
+        void write_head(OutputQueue &out, int http_code, std::string_view type_line, size_t content_length,
+                        std::string_view extra = {}, std::string_view body_prefix = {}) const;
+
+        /**
+         * @brief 发送缓存下来的响应，按 iovec 片段入队：head 与 body 借用 owner 持有的内存，不拷贝
+         * @param head 状态行与 Header（不含 Connection、Date 和结尾空行），每行以 \r\n 结尾
+         * @param extra 按本次请求追加的 Header 行（例如 Age）
+         */
+        void write_cached(OutputQueue &out, std::string_view head, std::string_view body, std::string_view extra,
+                          std::shared_ptr<const void> owner) const;
+
+    private:
+        // 协商出压缩方式且超过阈值时，把 parts 依次压缩后整体入队；返回 false 表示应按原样发送
+        bool write_compressed(OutputQueue &out, int http_code, std::string_view type_line,
+                              std::initializer_list<std::string_view> parts, size_t total);
     };
 }
@@ -0,0 +1,78 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "web/protocol/compress.h"
+#include "web/protocol/output_queue.h"
+#include "web/protocol/response.h"
+
+namespace gee {
+    /**
+     * @brief 分块流式响应
+     * 数据先攒在缓冲区，超过阈值就以一个 chunk 写到 socket；内核缓冲区满时挂在 netpoller 上，
+     * 内存占用与结果集大小无关。HTTP/1.0 客户端没有 chunked，改为写完关闭连接来界定 body。
+     */
+    class ResponseStream {
+    public:
+        static constexpr size_t kDefaultFlushBytes = 32 * 1024;
+
+        ResponseStream(OutputQueue &out, int fd, Response &res, int http_code, std::string_view type_line,
+                       bool chunked, bool head_only, size_t flush_bytes = kDefaultFlushBytes);
+
+        ResponseStream(const ResponseStream &) = delete;
+
+        ResponseStream &operator=(const ResponseStream &) = delete;
+
+        bool write(std::string_view data) {
+            buf_.append(data);
+            return commit();
+        }
+
+        // 直接往缓冲区追加（例如 Model::write_json），追加完调用 commit
+        std::string &buffer() { return buf_; }
+
+        // 缓冲区超过阈值时发出一块
+        bool commit() { return buf_.size() < flush_bytes_ || flush(); }
+
+        /**
+         * @brief 共享的一段数据（例如广播事件）不拷贝，作为一块排进输出队列，下一次 flush 时写出
+         * 压缩流或缓冲区里还有数据时退回普通写入，保持顺序
+         */
+        void write_shared(std::shared_ptr<const std::string> data);
+
+        // 立即把缓冲区作为一块写到 socket
+        bool flush();
+
+        // 发送结束标记；之后的写入无效
+        bool end();
+
+        bool ok() const { return ok_; }
+        bool ended() const { return ended_; }
+
+    private:
+        bool emit(bool final);
+
+        void push_chunk_head(size_t n);
+
+        OutputQueue &out_;
+        int fd_;
+        std::string buf_;
+        std::unique_ptr<Deflater> z_;
+        size_t flush_bytes_;
+        bool chunked_;
+        bool head_only_;
+        bool ended_ = false;
+        bool ok_ = true;
+    };
+
+    // Server-Sent Events 响应头：作为 Stream() 的 type_line 传入，必须是静态存储
+    inline constexpr std::string_view kEventStreamHeaders =
+            "Content-Type: text/event-stream\r\nCache-Control: no-cache\r\nX-Accel-Buffering: no\r\n";
+
+    /**
+     * @brief 按 text/event-stream 格式序列化一个事件
+     * data 中的换行拆成多行 data:；event、id 为空时省略，不能包含换行
+     */
+    std::string sse_format(std::string_view data, std::string_view event = {}, std::string_view id = {});
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "data_structure/co_mutex.h"
+
+namespace gee {
+    struct Request;
+    struct WebContext;
+    class OutputQueue;
+    class WebSocket;
+
+    enum class WSOpcode : uint8_t {
+        Continuation = 0x0,
+        Text = 0x1,
+        Binary = 0x2,
+        Close = 0x8,
+        Ping = 0x9,
+        Pong = 0xA
+    };
+
+    struct WSMessage {
+        WSOpcode type = WSOpcode::Text; // Text 或 Binary
+        std::string data;
+
+        bool is_text() const { return type == WSOpcode::Text; }
+    };
+
+    struct WebSocketConfig {
+        size_t max_message = 1024 * 1024; // 单条消息（含所有分片）的上限，超过按 1009 关闭
+    };
+
+    // 握手成功后在连接协程里调用，返回即关闭连接
+    using WSHandler = std::function<void(WebContext *, WebSocket &)>;
+
+    /**
+     * @brief 服务端 WebSocket 连接（RFC 6455）
+     * 读写都直接挂在 netpoller 上：read_message 在数据未到时挂起当前协程，
+     * 空闲连接除协程栈外不占读缓冲区（读空即把 slab 还给池子）。
+     * Ping 自动回 Pong，分片消息拼成一条再返回；文本消息校验 UTF-8。
+     * read_message 只能由一个协程调用；write_message 可以从任意协程并发调用。
+     */
+    class WebSocket {
+    public:
+        WebSocket(Request &req, OutputQueue &out, int fd, const WebSocketConfig &config)
+            : req_(req), out_(out), fd_(fd), config_(config) {
+        }
+
+        WebSocket(const WebSocket &) = delete;
+
+        WebSocket &operator=(const WebSocket &) = delete;
+
+        // 握手请求是否合法：GET、HTTP/1.1、Upgrade: websocket、Connection: upgrade、版本 13 与 Key
+        static bool is_upgrade_request(const Request &req);
+
+        // Sec-WebSocket-Accept = base64(SHA-1(key + GUID))
+        static std::string accept_key(std::string_view client_key);
+
+        /**
+         * @brief 读一条完整消息，数据未到时挂起协程
+         * @return false 表示连接已关闭（对端发了 Close、协议错误或 socket 断开），close_code() 给出原因
+         */
+        bool read_message(WSMessage &msg);
+
+        bool write_message(std::string_view data, WSOpcode type = WSOpcode::Text);
+
+        bool ping(std::string_view payload = {});
+
+        // 发送 Close 帧，之后不能再写；重复调用无效
+        void close(uint16_t code = 1000, std::string_view reason = {});
+
+        bool is_closed() const { return closed_; }
+
+        uint16_t close_code() const { return close_code_; }
+
+    private:
+        struct Frame {
+            bool fin;
+            WSOpcode opcode;
+            uint8_t mask[4];
+            uint64_t len;
+        };
+
+        bool read_frame_header(Frame &f);
+
+        // 把载荷追加到 dst 并去掉掩码
+        bool read_payload(const Frame &f, std::string &dst);
+
+        bool fill();
+
+        bool send_frame(WSOpcode op, std::string_view payload);
+
+        // 协议错误：回一个 Close 帧后放弃连接
+        bool fail(uint16_t code);
+
+        Request &req_; // 读缓冲区沿用 HTTP 请求的 raw_data_
+        OutputQueue &out_;
+        int fd_;
+        WebSocketConfig config_;
+        runtime::CoMutex write_mu_; // 写可能挂起等 socket 可写，用协程锁
+        bool close_sent_ = false; // write_mu_ 保护
+        bool closed_ = false; // 读方向已结束
+        uint16_t close_code_ = 1005; // 1005：没有收到状态码
+    };
+
+    namespace detail {
+        // data[i] ^= mask[i % 4]，按 16 字节一批异或
+        void ws_unmask(char *data, size_t n, const uint8_t mask[4]);
+    }
+}
@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <iostream>
 
 #include "data_structure/channel.h"
 #include "data_structure/context.h"
+#include "data_structure/single_flight.h"
 #include "data_structure/wait_group.h"
 #include"src/test/web.h"
 #include "src/util/logger.h"
@@ -31,6 +33,16 @@ void AuthMiddleware(gee::WebContext *c) {
     }
 }
 
+// 这两个接口一直把 age、password 原样写进 JSON：是 JSON 数字的照旧输出数字，其余的按字符串转义写出
+void WriteNumberOrString(gee::JsonWriter &w, std::string_view key, std::string_view v) {
+    gee::JsonReader r(v);
+    if (r.peek() == gee::JsonReader::Type::Number && r.skip() && r.end()) {
+        w.key(key).raw(v);
+    } else {
+        w.key(key).value(v);
+    }
+}
+
 auto TimeoutMiddleware(int timeout_ms) {
     return [timeout_ms](gee::WebContext *c) {
         auto winner_ch = std::make_shared<runtime::Channel<int>>(1);
@@ -54,6 +66,42 @@ auto TimeoutMiddleware(int timeout_ms) {
     };
 }
 
+// 类型化中间件：用于 GET<...> 编译期组合
+struct Logger {
+    template<typename Next>
+    static void handle(gee::WebContext *c, Next &&next) {
+        auto start = std::chrono::high_resolution_clock::now();
+        next();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - start).count();
+        spdlog::info("<-- [Typed] Done: {}  {} us", c->path(), duration);
+    }
+};
+
+struct Auth {
+    template<typename Next>
+    static void handle(gee::WebContext *c, Next &&next) {
+        if (c->Query("token") == "zhaixing") {
+            c->JSON(gee::StateCode::PARAM_ERROR, "Invalid Token", "{\"error\": \"Unauthenticated\"}");
+            return; // 不调用 next 即拦截
+        }
+        next();
+    }
+};
+
+// JSON 请求体绑定：声明字段表后由 BindJSON 直接写进成员
+struct LoginForm {
+    std::string username;
+    std::string password;
+    std::vector<std::string> roles;
+
+    static auto json_fields() {
+        return std::make_tuple(gee::json_field("username", &LoginForm::username),
+                               gee::json_field("password", &LoginForm::password),
+                               gee::json_field("roles", &LoginForm::roles));
+    }
+};
+
 int main() {
     init_logging();
     runtime::Scheduler::get().start(8);
@@ -65,7 +113,20 @@ int main() {
 
     auto api_group = app.Group("/api");
     api_group->Use(AuthMiddleware);
-    app.GET("/getUser", [](gee::WebContext *ctx) {
+    // 每个客户端 IP 每秒 100 个请求，允许突发 200，超出直接回 429
+    gee::RateLimiterConfig limit_config;
+    limit_config.rate = 100;
+    limit_config.burst = 200;
+    static gee::RateLimiter api_limiter(limit_config);
+    api_group->Use(api_limiter.middleware());
+    // 热点读接口：缓存 1 秒，之后 10 秒内先返回旧结果再后台刷新；并发未命中只查一次库
+    gee::ResponseCacheConfig cache_config;
+    cache_config.ttl_ms = 1000;
+    cache_config.stale_ms = 10000;
+    static gee::ResponseCache user_cache(cache_config);
+    auto cached = app.Group("");
+    cached->Use(user_cache.middleware());
+    cached->GET("/getUser", [](gee::WebContext *ctx) {
         auto results = db::table<Employee>("employees")
                 .where("salary", ">", "8344")
                 .model();
@@ -73,21 +134,69 @@ int main() {
         ctx->JSON(gee::StateCode::OK, gee::statusToString(gee::Message::success), results);
     });
 
+    // 同一时刻的重复统计只查一次库，结果共享 500ms；单个请求等超过 200ms 先返回，不影响其他请求
+    static runtime::SingleFlight<std::string, size_t> count_flight(500);
+    app.GET("/getUser/count", [](gee::WebContext *ctx) {
+        auto timeout = runtime::Context::WithTimeout(200);
+        auto n = count_flight.run("employees", timeout, [] {
+            return db::table<Employee>("employees").where("salary", ">", "8344").model().size();
+        });
+        if (!n) {
+            ctx->JSON(gee::StateCode::TIMEOUT, "Timeout", "{}");
+            return;
+        }
+        ctx->JSON(gee::StateCode::OK, gee::statusToString(gee::Message::success),
+                  "{\"count\":" + std::to_string(*n) + "}");
+    });
+
+    // 大结果集：分块流式输出，不在内存里拼完整个数组
+    app.GET("/getUser/stream", [](gee::WebContext *ctx) {
+        auto results = db::table<Employee>("employees")
+                .where("salary", ">", "8344")
+                .model();
+
+        ctx->StreamJSON(gee::StateCode::OK, gee::statusToString(gee::Message::success), results);
+    });
+
+    // 大上传：边收边处理（支持 chunked），只统计 NDJSON 行数，内存占用与 Body 大小无关
+    app.POST("/ingest/ndjson", [](gee::WebContext *ctx) {
+        char buf[8192];
+        size_t lines = 0, bytes = 0;
+        ssize_t n;
+        while ((n = ctx->BodyReader().read(buf, sizeof(buf))) > 0) {
+            bytes += static_cast<size_t>(n);
+            lines += std::count(buf, buf + n, '\n');
+        }
+        if (n < 0) {
+            ctx->JSON(gee::StateCode::PARAM_ERROR, "bad body", "{}");
+            return;
+        }
+        ctx->JSON(gee::StateCode::OK, gee::statusToString(gee::Message::success),
+                  "{\"lines\":" + std::to_string(lines) + ",\"bytes\":" + std::to_string(bytes) + "}");
+    });
+
     api_group->GET("/user/:name", [](gee::WebContext *ctx) {
         auto name = ctx->Param("name");
         auto age = ctx->Param("age");
 
-        //   手动构造一个 JSON 对象字符串
+        // 路由参数来自客户端，经 JsonWriter 转义后再写进 JSON
         std::string body;
         body.reserve(64);
-        body.append("{\"name\":\"").append(name)
-                .append("\",\"age\":").append(age).append("}");
+        gee::JsonWriter w(body);
+        w.begin_object().field("name", name);
+        WriteNumberOrString(w, "age", age);
+        w.end_object();
         ctx->JSON(gee::StateCode::OK, "success", std::move(body));
     });
 
+    app.GET<gee::mw::Recovery, Logger, Auth>("/typed/ping", [](gee::WebContext *ctx) {
+        ctx->JSON(gee::StateCode::OK, "pong", "{}");
+    });
+
     app.GET("/user/info", [](gee::WebContext *ctx) {
         auto name = ctx->Query("name");
-        std::string body = "\"" + name + "\"";
+        std::string body;
+        gee::JsonWriter(body).value(name);
         ctx->JSON(gee::StateCode::OK, "success", std::move(body));
     });
 
@@ -97,8 +206,10 @@ int main() {
         std::string password = c->PostForm("password");
         std::string body;
         body.reserve(64);
-        body.append("{\"username\":\"").append(username)
-                .append("\",\"password\":").append(password).append("}");
+        gee::JsonWriter w(body);
+        w.begin_object().field("username", username);
+        WriteNumberOrString(w, "password", password);
+        w.end_object();
         if (username == "zhaixing" && password == "123") {
             c->JSON(gee::StateCode::OK, gee::statusToString(gee::Message::success), std::move(body));
         } else {
@@ -106,6 +217,39 @@ int main() {
         }
     });
 
+    app.POST("/login/json", [](gee::WebContext *c) {
+        auto form = c->BindJSON<LoginForm>();
+        if (!form) {
+            c->JSON(gee::StateCode::PARAM_ERROR, "invalid json", "{}");
+            return;
+        }
+        std::string body;
+        gee::JsonWriter w(body);
+        w.begin_object().field("username", form->username).key("roles").begin_array();
+        for (const auto &r: form->roles) w.value(r);
+        w.end_array().end_object();
+        c->JSON(gee::StateCode::OK, gee::statusToString(gee::Message::success), std::move(body));
+    });
+
+    // SSE 广播：GET /events 订阅，POST /events/publish 把 Body 推给所有订阅者
+    static gee::Broadcaster hub;
+    // 订阅连接一直挂在 serve 里，不关掉的话排空要等到超时
+    app.OnShutdown([]() { hub.close(); });
+    app.GET("/events", [](gee::WebContext *c) { hub.serve(c); });
+    app.POST("/events/publish", [](gee::WebContext *c) {
+        size_t n = hub.publish(c->Body(), "message");
+        c->JSON(gee::StateCode::OK, gee::statusToString(gee::Message::success),
+                "{\"delivered\":" + std::to_string(n) + "}");
+    });
+
+    // WebSocket 回显：每个连接一个协程，read_message 在没有数据时挂起
+    app.WS("/ws/echo", [](gee::WebContext *, gee::WebSocket &ws) {
+        gee::WSMessage msg;
+        while (ws.read_message(msg)) {
+            if (!ws.write_message(msg.data, msg.type)) break;
+        }
+    });
+
     app.GET("/user/print_test", [](gee::WebContext *ctx) {
         auto wg = std::make_shared<runtime::WaitGroup>();
         auto chan1 = std::make_shared<runtime::Channel<int> >(0);
@@ -10,17 +10,21 @@ namespace runtime {
 
 
         auto current_g = Goroutine::current();
-        {
+        // 切出之后再入队：先入队再 yield 时，unlock 可能在本协程还没停下前就把它放回就绪队列。
+        // 入队前在队列锁下再抢一次，避免 unlock 恰好在 try_lock 失败后放掉锁而没人唤醒
+        Goroutine::park(ParkReason::Mutex, [this, current_g]() {
             wait_queue_lock_.lock();
+            if (try_lock()) {
+                wait_queue_lock_.unlock();
+                Scheduler::get().push_ready(current_g, WakeSource::Mutex);
+                return;
+            }
             waiting_gs_.push(current_g);
             wait_queue_lock_.unlock();
-        }
-
-        // 让出 CPU 权限，协程在此暂停
-        Goroutine::yield();
+        });
 
         // --- 协程被唤醒后从这里继续执行 ---
-        // 注意：这里的唤醒机制通常保证了唤醒即持锁，或者需要再次尝试
+        // unlock 把锁直接交给队首，唤醒即持锁
     }
 
     void CoMutex::unlock() {
@@ -38,7 +42,7 @@ namespace runtime {
         }
 
         if (next_g) {
-            Scheduler::get().push_ready(next_g);
+            Scheduler::get().push_ready(next_g, WakeSource::Mutex);
         }
     }
 
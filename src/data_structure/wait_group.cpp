@@ -20,7 +20,7 @@ namespace runtime {
             }
 
             for (auto& g : to_wake) {
-                Scheduler::get().push_ready(std::move(g));
+                Scheduler::get().push_ready(std::move(g), WakeSource::WaitGroup);
             }
         }
     }
@@ -34,20 +34,21 @@ namespace runtime {
             return;
         }
 
-        {
+        // 核心：让出 CPU，直到被 Add(val==0) 时唤醒
+        // 切出之后再登记：先登记的话，add 可能在切出之前就把它交给另一个 Worker resume
+        auto self = runtime::Goroutine::current();
+        runtime::Goroutine::park(runtime::ParkReason::WaitGroup, [this, self]() {
             lock_.lock();
-            // Double check: 拿锁后再检查一遍，防止在拿锁期间 counter 归零了
+            // Double check: 拿锁后再检查一遍，防止在切出期间 counter 归零了
             if (counter_.load() == 0) {
                 lock_.unlock();
+                Scheduler::get().push_ready(self, WakeSource::WaitGroup);
                 return;
             }
             // 将当前协程加入等待列表
-            waiting_gs_.push_back(runtime::Goroutine::current());
+            waiting_gs_.push_back(self);
             lock_.unlock();
-        }
-
-        // 核心：让出 CPU，直到被 Add(val==0) 时唤醒
-        runtime::Goroutine::yield();
+        });
     }
 
 } // namespace runtime
\ No newline at end of file
@@ -38,12 +38,14 @@ namespace db {
         int fd = mysql_get_socket(mysql_);
         auto current_g = runtime::Goroutine::current();
         if (current_g) {
-            if (status & MYSQL_WAIT_READ) {
-                runtime::Netpoller::get().watch(fd, runtime::IOEvent::Read, current_g);
-            } else if (status & MYSQL_WAIT_WRITE) {
-                runtime::Netpoller::get().watch(fd, runtime::IOEvent::Write, current_g);
-            }
-            runtime::Goroutine::yield();
+            // 切出之后再注册，防止事件先到、被另一个 Worker 在切出前 resume
+            runtime::Goroutine::park(runtime::ParkReason::Database, [fd, status, current_g]() {
+                if (status & MYSQL_WAIT_READ) {
+                    runtime::Netpoller::get().watch(fd, runtime::IOEvent::Read, current_g);
+                } else if (status & MYSQL_WAIT_WRITE) {
+                    runtime::Netpoller::get().watch(fd, runtime::IOEvent::Write, current_g);
+                }
+            });
         }
     }
 
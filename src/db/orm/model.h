@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 #include "../core/mysql_driver.h"
+#include "web/protocol/json_writer.h"
 
 namespace db {
 
@@ -14,8 +15,13 @@ namespace db {
         virtual FieldMap to_row() const = 0;
         virtual std::string table_name() const = 0;
 
-        // 序列化接口
-        virtual void write_json(std::string &out) const = 0;
+        // 序列化接口：子类实现 JsonWriter 版本；字符串版本保留给旧调用方，转发到 JsonWriter 版本
+        virtual void write_json(gee::JsonWriter &w) const = 0;
+
+        virtual void write_json(std::string &out) const {
+            gee::JsonWriter w(out);
+            write_json(w);
+        }
     };
 
 } // namespace db
\ No newline at end of file
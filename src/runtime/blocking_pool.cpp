@@ -0,0 +1,73 @@
+#include "runtime/blocking_pool.h"
+
+#include <exception>
+
+#include "runtime/goroutine.h"
+#include "runtime/scheduler.h"
+
+namespace runtime {
+    BlockingPool &BlockingPool::get() {
+        static BlockingPool instance(4);
+        return instance;
+    }
+
+    BlockingPool::BlockingPool(size_t thread_count) {
+        for (size_t i = 0; i < thread_count; ++i) {
+            workers_.emplace_back([this, i]() {
+                Tracer::name_thread("blocking-" + std::to_string(i));
+                while (true) {
+                    std::function<void()> job;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        cv_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+                        if (stop_ && jobs_.empty()) return;
+                        job = std::move(jobs_.front());
+                        jobs_.pop();
+                    }
+                    job();
+                }
+            });
+        }
+    }
+
+    BlockingPool::~BlockingPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto &t: workers_) {
+            if (t.joinable()) t.join();
+        }
+    }
+
+    void BlockingPool::submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push(std::move(job));
+        }
+        cv_.notify_one();
+    }
+
+    void BlockingPool::run(const std::function<void()> &fn) {
+        auto g = Goroutine::current();
+        if (!g) {
+            fn();
+            return;
+        }
+        // 协程切出之后才投递任务，任务完成时的 push_ready 不会和切换竞争；
+        // fn 与 err 在协程栈上，协程挂起期间一直有效
+        std::exception_ptr err;
+        Goroutine::park(ParkReason::Blocking, [this, g, &fn, &err]() {
+            submit([g, &fn, &err]() {
+                try {
+                    fn();
+                } catch (...) {
+                    err = std::current_exception();
+                }
+                Scheduler::get().push_ready(g, WakeSource::Blocking);
+            });
+        });
+        if (err) std::rethrow_exception(err);
+    }
+}
@@ -4,36 +4,70 @@
 
 
 #include <string_view>
+#include <strings.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
 
 #include "runtime/netpoller.h"
+#include <spdlog/spdlog.h>
 
 namespace gee {
-    void WebContext::set_params(std::unordered_map<std::string, std::string> params) {
-        req_.params_ = std::move(params);
-    }
-
-    // 业务层调用：ctx->Param("userId")
-    std::string WebContext::Param(const std::string &key) {
-        auto it = req_.params_.find(key);
-        return it != req_.params_.end() ? it->second : "";
-    }
-
     std::string WebContext::Query(const std::string &key) {
         auto it = req_.query_params_.find(key);
         return (it != req_.query_params_.end()) ? it->second : "";
     }
 
 
+    std::string_view WebContext::ClientIP() {
+        if (peer_ip_.empty()) {
+            sockaddr_storage addr{};
+            socklen_t len = sizeof(addr);
+            char buf[INET6_ADDRSTRLEN] = {0};
+            if (::getpeername(this->fd, reinterpret_cast<sockaddr *>(&addr), &len) == 0) {
+                if (addr.ss_family == AF_INET) {
+                    inet_ntop(AF_INET, &reinterpret_cast<sockaddr_in *>(&addr)->sin_addr, buf, sizeof(buf));
+                } else if (addr.ss_family == AF_INET6) {
+                    inet_ntop(AF_INET6, &reinterpret_cast<sockaddr_in6 *>(&addr)->sin6_addr, buf, sizeof(buf));
+                }
+            }
+            peer_ip_ = buf[0] ? buf : "unknown";
+        }
+        return peer_ip_;
+    }
+
     void WebContext::send_response(int http_code, const std::string &text) {
         if (res_.is_sent) return; // 状态锁，防止重复发送
 
-        // 1. 让 Response 构造完整的 HTTP 报文流
-        std::string http_packet = res_.build_http_packet(http_code, text);
-        web_write(this->fd, http_packet.data(), http_packet.size());
+        // 1. Response 按片段放进输出队列，body 直接移交，由连接循环统一 writev
+        res_.write_to(out_, http_code, text);
         res_.is_sent = true;
     }
 
 
+    gee::ResponseStream &WebContext::Stream(int http_code, std::string_view type_line, size_t flush_bytes) {
+        if (!stream_) {
+            bool chunked = req_.version == "HTTP/1.1";
+            bool head_only = req_.method == "HEAD";
+            stream_ = std::make_unique<gee::ResponseStream>(out_, this->fd, res_, http_code, type_line,
+                                                            chunked, head_only, flush_bytes);
+        }
+        return *stream_;
+    }
+
+    gee::ResponseStream &WebContext::SSE() {
+        if (!stream_) {
+            // 广播事件要原样共享给所有订阅者，压缩流做不到；flush_bytes 为 0：每次写入都立即发出
+            res_.encoding = gee::Encoding::Identity;
+            res_.vary_encoding = false;
+            // 订阅可能持续数小时，不占在途名额
+            release_admission(false);
+            Stream(200, gee::kEventStreamHeaders, 0);
+            stream_->flush();
+        }
+        return *stream_;
+    }
+
     void WebContext::JSON(gee::StateCode code, const std::string &msg, std::string &&raw_json) {
         if (!raw_json.empty()) {
             char first = raw_json.front();
@@ -63,7 +97,8 @@ namespace gee {
     void WebContext::JSON(gee::StateCode code, const std::string &msg, const db::Model &model) {
         std::string body;
         body.reserve(128);
-        model.write_json(body);
+        gee::JsonWriter w(body);
+        model.write_json(w);
         res_.set_raw_data(static_cast<int>(code), msg, std::move(body));
         this->send_response(static_cast<int>(code));
     }
@@ -83,9 +118,73 @@ namespace gee {
 
     // 获取原始 Body (用于 JSON 等)
     std::string_view WebContext::Body() {
+        // 流式 Body 只在 Handler 还没开始自己读的时候整段读入，与缓冲 Body 同一个上限
+        constexpr size_t kMaxBufferedBody = 10 * 1024 * 1024;
+        if (req_.body_deferred_ && !body_.started()) {
+            if (BodyReader().read_all(req_.json_body_, kMaxBufferedBody)) {
+                req_.body = req_.json_body_;
+            }
+        }
         return req_.body;
     }
 
+    void WebContext::log_bind_error(const char *what, size_t offset) const {
+        spdlog::debug("BindJSON {}: {} at offset {}", req_.path, what, offset);
+    }
+
+    void WebContext::UpgradeWebSocket(const gee::WSHandler &handler, const gee::WebSocketConfig &config) {
+        if (res_.is_sent) return;
+        if (!gee::WebSocket::is_upgrade_request(req_)) {
+            std::string_view version = req_.get_header("Sec-WebSocket-Version");
+            if (!version.empty() && version != "13") {
+                static constexpr std::string_view kBody = "Upgrade Required";
+                res_.write_head(out_, 426, gee::kTextContentType, kBody.size(), "Sec-WebSocket-Version: 13\r\n", kBody);
+                res_.is_sent = true;
+            } else {
+                String(400, "Bad WebSocket Handshake");
+            }
+            return;
+        }
+
+        std::string head = "HTTP/1.1 101 Switching Protocols\r\n"
+                "Upgrade: websocket\r\n"
+                "Connection: Upgrade\r\n"
+                "Sec-WebSocket-Accept: ";
+        head += gee::WebSocket::accept_key(req_.get_header("Sec-WebSocket-Key"));
+        head += "\r\n\r\n";
+        out_.push(std::move(head));
+        res_.is_sent = true;
+        // 连接交给 WebSocket，handler 返回后不再复用
+        res_.keep_alive = false;
+        req_.reusable_ = false;
+        if (!flush()) return;
+        release_admission(false);
+
+        // 请求头搬出读缓冲区：空闲连接不再占着 slab，参数视图跟着平移
+        std::string handshake;
+        const char *old_base = req_.raw_data_.data();
+        size_t header_size = req_.header_size;
+        req_.detach_header(handshake);
+        params_.rebase(old_base, header_size, handshake.data());
+
+        gee::WebSocket ws(req_, out_, this->fd, config);
+        handler(this, ws);
+        ws.close();
+    }
+
+    gee::BodyReader &WebContext::BodyReader() {
+        if (req_.body_deferred_ && !body_.started()) {
+            std::string_view expect = req_.get_header("Expect");
+            if (req_.version == "HTTP/1.1" && expect.size() == 12
+                && strncasecmp(expect.data(), "100-continue", 12) == 0) {
+                // 客户端在等许可才发 Body；之前排队的流水线响应一起先发出去
+                out_.push_static("HTTP/1.1 100 Continue\r\n\r\n");
+                flush();
+            }
+        }
+        return body_;
+    }
+
     ssize_t WebContext::web_write(int fd, const char* data, size_t len) {
         size_t total_sent = 0;
 
@@ -98,10 +197,10 @@ namespace gee {
                 if (errno == EAGAIN || errno == EWOULDBLOCK) {
                     // 内核发送缓冲区满了，注册可写事件并挂起
                     auto g = runtime::Goroutine::current();
-                    // 注意这里使用的是 IOEvent::Write
-                    runtime::Netpoller::get().watch(fd, runtime::IOEvent::Write, g);
-
-                    runtime::Goroutine::yield();
+                    // 注意这里使用的是 IOEvent::Write；切出之后再注册，事件不会赶在切出之前唤醒
+                    runtime::Goroutine::park(runtime::ParkReason::NetWrite, [fd, g]() {
+                        runtime::Netpoller::get().watch(fd, runtime::IOEvent::Write, g);
+                    });
                     // 被唤醒后，说明现在可以继续写了，回到 while 循环
                     continue;
                 }
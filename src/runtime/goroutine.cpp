@@ -37,16 +37,46 @@ namespace runtime {
 
     void Goroutine::resume() {
         if (!finished_ && ctx_) {
+            // 只读一次开关，保证 B/E 事件成对
+            const bool tracing = Tracer::enabled();
+            queued_ns_ = ready_since_ns_ ? trace_now_ns() - ready_since_ns_ : 0;
+            ready_since_ns_ = 0;
+            if (tracing) {
+                Tracer::get().record(TraceEvent::Resume, this, 0, static_cast<uint64_t>(queued_ns_));
+            }
             // 进入协程前设置 TLS
             t_current_g = this;
             ctx_ = std::move(ctx_).resume();
             // 从协程出来后（可能是 yield 或结束），清除 TLS
             t_current_g = nullptr;
+            if (tracing) {
+                if (finished_) {
+                    Tracer::get().record(TraceEvent::Finish, this, 0);
+                } else {
+                    Tracer::get().record(TraceEvent::Park, this, static_cast<uint8_t>(park_reason_));
+                }
+            }
+            // 已经切回 Worker 栈，此时别的线程 resume 本协程是安全的；hook 之后不能再碰 this
+            if (after_park_) {
+                auto hook = std::move(after_park_);
+                after_park_ = nullptr;
+                hook();
+            }
         }
     }
 
-    void Goroutine::yield() {
+    void Goroutine::yield(ParkReason reason) {
+        if (t_current_g) t_current_g->park_reason_ = reason;
         t_top_ctx = std::move(t_top_ctx).resume();
     }
 
+    void Goroutine::park(ParkReason reason, std::function<void()> hook) {
+        if (!t_current_g) {
+            if (hook) hook();
+            return;
+        }
+        t_current_g->after_park_ = std::move(hook);
+        yield(reason);
+    }
+
 } // namespace runtime
\ No newline at end of file
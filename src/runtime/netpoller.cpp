@@ -3,7 +3,6 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include "runtime/context/db_context.h"
-#include "runtime/context/web_context.h"
 
 namespace runtime {
     Netpoller &Netpoller::get() {
@@ -11,8 +10,16 @@ namespace runtime {
         return instance;
     }
 
+    namespace {
+        // stop() 用来唤醒 kevent 的用户事件
+        constexpr uintptr_t kWakeIdent = 1;
+    }
+
     Netpoller::Netpoller() {
         kq_fd_ = kqueue();
+        struct kevent ev;
+        EV_SET(&ev, kWakeIdent, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+        kevent(kq_fd_, &ev, 1, nullptr, 0, nullptr);
     }
 
     Netpoller::~Netpoller() {
@@ -22,43 +29,68 @@ namespace runtime {
 
     void Netpoller::poll_loop() {
         struct kevent events[1024];
-        while (true) {
+        while (!stopping_.load(std::memory_order_acquire)) {
             int n = kevent(kq_fd_, nullptr, 0, events, 1024, nullptr);
             if (n <= 0) continue;
             for (int i = 0; i < n; ++i) {
-                auto *ctx = static_cast<runtime::IOContextBase *>(events[i].udata);
-                if (!ctx) continue;
+                if (events[i].filter == EVFILT_USER) continue;
                 runtime::Goroutine::Ptr g_to_wake;
                 {
+                    // 按 fd 查表而不是用 udata：forget 之后上下文已经释放，迟到的事件直接丢掉
                     std::lock_guard<std::mutex> lock(mtx_);
-                    if (ctx->waiting_g) {
-                        g_to_wake = std::move(ctx->waiting_g);
-                        ctx->waiting_g = nullptr;
+                    auto it = contexts_.find(static_cast<int>(events[i].ident));
+                    if (it == contexts_.end()) continue;
+                    auto &slot = events[i].filter == EVFILT_WRITE ? it->second->waiting_write_g : it->second->waiting_g;
+                    if (slot) {
+                        g_to_wake = std::move(slot);
+                        slot = nullptr;
                     }
                 }
                 if (g_to_wake) {
-                    Scheduler::get().push_ready(std::move(g_to_wake));
+                    Scheduler::get().push_ready(std::move(g_to_wake), WakeSource::Netpoller);
                 }
             }
         }
     }
 
 
+    void Netpoller::stop() {
+        stopping_.store(true, std::memory_order_release);
+        struct kevent ev;
+        EV_SET(&ev, kWakeIdent, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
+        kevent(kq_fd_, &ev, 1, nullptr, 0, nullptr);
+    }
+
     void Netpoller::watch_read_web(int fd, Goroutine::Ptr g) {
         {
             std::lock_guard<std::mutex> lock(mtx_);
-            if (contexts_.find(fd) == contexts_.end()) {
-                contexts_[fd] = std::make_unique<gee::WebContext>(fd);
-            }
-            contexts_[fd]->type = IOType::WEB; // 核心：打上 WEB 标签
-            contexts_[fd]->waiting_g = std::move(g);
+            auto &ctx = contexts_[fd];
+            // 只用来挂等待的协程，不需要完整的 WebContext（连接自己的那个在连接协程栈上）
+            if (!ctx) ctx = std::make_unique<IOContextBase>(fd, IOType::WEB);
+            ctx->type = IOType::WEB; // 核心：打上 WEB 标签
+            ctx->waiting_g = std::move(g);
         }
 
         struct kevent ev;
-        EV_SET(&ev, fd, EVFILT_READ, EV_ADD | EV_ENABLE | EV_ONESHOT, 0, 0, contexts_[fd].get());
+        EV_SET(&ev, fd, EVFILT_READ, EV_ADD | EV_ENABLE | EV_ONESHOT, 0, 0, nullptr);
         kevent(kq_fd_, &ev, 1, nullptr, 0, nullptr);
     }
 
+    void Netpoller::forget(int fd) {
+        Goroutine::Ptr read_g, write_g;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            auto it = contexts_.find(fd);
+            if (it == contexts_.end()) return;
+            read_g = std::move(it->second->waiting_g);
+            write_g = std::move(it->second->waiting_write_g);
+            contexts_.erase(it);
+        }
+        // 还挂着的协程不会再等到事件（kqueue 关闭 fd 时静默删除事件），叫醒它们自己发现 fd 已经不能用
+        if (read_g) Scheduler::get().push_ready(std::move(read_g), WakeSource::Netpoller);
+        if (write_g) Scheduler::get().push_ready(std::move(write_g), WakeSource::Netpoller);
+    }
+
 
 
     //数据库io时向
@@ -70,17 +102,16 @@ namespace runtime {
         }
 
         {
-            lock_.lock();
-            if (contexts_.find(fd) == contexts_.end()) {
-                contexts_[fd] = std::make_unique<DBContext>(fd);
-            }
-            contexts_[fd]->waiting_g = std::move(g);
-            lock_.unlock();
+            // 与 poll_loop、forget 用同一把锁
+            std::lock_guard<std::mutex> lock(mtx_);
+            auto &ctx = contexts_[fd];
+            if (!ctx) ctx = std::make_unique<DBContext>(fd);
+            (event == IOEvent::Write ? ctx->waiting_write_g : ctx->waiting_g) = std::move(g);
         }
 
         // 3. 注册 kqueue 事件
         struct kevent ev;
-        EV_SET(&ev, fd, static_cast<int16_t>(event), EV_ADD | EV_ENABLE | EV_ONESHOT, 0, 0, contexts_[fd].get());
+        EV_SET(&ev, fd, static_cast<int16_t>(event), EV_ADD | EV_ENABLE | EV_ONESHOT, 0, 0, nullptr);
 
         if (kevent(kq_fd_, &ev, 1, nullptr, 0, nullptr) == -1) {
             perror("kevent watch failed");
@@ -9,7 +9,30 @@ Scheduler& Scheduler::get() {
     return instance;
 }
 
+Scheduler::Scheduler() {
+    // 先于调度器构造完成，静态析构时就晚于调度器销毁：stop() 里还要用它
+    Netpoller::get();
+}
+
 Scheduler::~Scheduler() {
+    stop();
+}
+
+void Scheduler::start(size_t thread_count) {
+    io_thread_ = std::thread([]() {
+        Tracer::name_thread("netpoller");
+        Netpoller::get().poll_loop();
+    });
+
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back([this, i]() {
+            Tracer::name_thread("worker-" + std::to_string(i));
+            worker_loop();
+        });
+    }
+}
+
+void Scheduler::stop() {
     {
         std::lock_guard<std::mutex> lock(mutex_);
         stop_ = true;
@@ -18,20 +41,21 @@ Scheduler::~Scheduler() {
     for (auto& t : workers_) {
         if (t.joinable()) t.join();
     }
-}
-
-void Scheduler::start(size_t thread_count) {
-    std::thread io_thread([]() {
-        Netpoller::get().poll_loop();
-    });
-    io_thread.detach();
-
-    for (size_t i = 0; i < thread_count; ++i) {
-        workers_.emplace_back(&Scheduler::worker_loop, this);
+    workers_.clear();
+    // Worker 都退出后不会再有人 watch，poll 线程可以安全结束
+    if (io_thread_.joinable()) {
+        Netpoller::get().stop();
+        io_thread_.join();
     }
 }
 
-void Scheduler::push_ready(Goroutine::Ptr g) {
+void Scheduler::push_ready(Goroutine::Ptr g, WakeSource source) {
+    // 排队时间一直统计：准入控制靠它判断过载，代价只是一次读时钟
+    g->mark_ready();
+    if (Tracer::enabled()) {
+        auto event = source == WakeSource::Spawn ? TraceEvent::Spawn : TraceEvent::Wake;
+        Tracer::get().record(event, g.get(), static_cast<uint8_t>(source));
+    }
     {
         std::lock_guard<std::mutex> lock(mutex_);
         ready_queue_.push(std::move(g));
@@ -51,14 +75,20 @@ void Scheduler::add_timer(int ms, Goroutine::Ptr g, std::function<void()> cb) {
 
 // 核心：检查并唤醒到期协程
 void Scheduler::check_timers() {
-    std::lock_guard<std::mutex> lock(timer_mutex_);
-    auto now = std::chrono::steady_clock::now();
-    while (!timers_.empty() && timers_.top().expires_at <= now) {
-        Timer t = std::move(const_cast<Timer&>(timers_.top()));
-        timers_.pop();
+    std::vector<Timer> expired;
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        auto now = std::chrono::steady_clock::now();
+        while (!timers_.empty() && timers_.top().expires_at <= now) {
+            expired.push_back(std::move(const_cast<Timer&>(timers_.top())));
+            timers_.pop();
+        }
+    }
 
+    // 回调放到锁外执行：回调里可能再次 add_timer（例如连接空闲检测的续期）
+    for (auto &t : expired) {
         if (t.callback) t.callback(); // 如果有回调（如 Context 取消）则执行
-        if (t.g) push_ready(t.g);     // 重新放入就绪队列
+        if (t.g) push_ready(t.g, WakeSource::Timer); // 重新放入就绪队列
     }
 }
 
@@ -92,14 +122,24 @@ void Scheduler::worker_loop() {
 void sleep(int ms) {
     auto g = Goroutine::current();
     if (!g) return;
-    Scheduler::get().add_timer(ms, g);
-    // 立即让出 CPU
-    Goroutine::yield();
+    // 立即让出 CPU；切出之后再注册定时器，0ms 的定时器不会在切出前被另一个 Worker resume
+    Goroutine::park(ParkReason::Timer, [ms, g]() {
+        Scheduler::get().add_timer(ms, g);
+    });
+}
+
+void yield_now() {
+    auto g = Goroutine::current();
+    if (!g) return;
+    // 切出之后再入队，避免另一个 Worker 抢先 resume 还在运行的协程
+    Goroutine::park(ParkReason::Yield, [g]() {
+        Scheduler::get().push_ready(g, WakeSource::Unknown);
+    });
 }
 
 void go(Goroutine::Task task) {
     auto g = std::make_shared<Goroutine>(std::move(task));
-    Scheduler::get().push_ready(g);
+    Scheduler::get().push_ready(g, WakeSource::Spawn);
 }
 
 } // namespace runtime
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include "runtime/tracer.h"
+#include "runtime/goroutine.h"
+
+#include <chrono>
+#include <fstream>
+
+namespace runtime {
+    static thread_local std::string t_thread_name;
+
+    int64_t trace_now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    Tracer &Tracer::get() {
+        static Tracer instance;
+        return instance;
+    }
+
+    void Tracer::name_thread(std::string name) {
+        t_thread_name = std::move(name);
+    }
+
+    void Tracer::start(size_t capacity) {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (capacity_ == 0) {
+                size_t cap = 1;
+                while (cap < capacity) cap <<= 1;
+                capacity_ = cap;
+            }
+            // 重新开始：已注册的缓冲区只需清零游标
+            for (auto &buf: buffers_) {
+                buf->head.store(0, std::memory_order_relaxed);
+            }
+            base_ns_ = trace_now_ns();
+        }
+        s_enabled_.store(true, std::memory_order_release);
+    }
+
+    void Tracer::stop() {
+        s_enabled_.store(false, std::memory_order_release);
+    }
+
+    Tracer::ThreadBuffer *Tracer::local_buffer() {
+        static thread_local ThreadBuffer *t_buffer = nullptr;
+        if (t_buffer) return t_buffer;
+
+        auto buf = std::make_unique<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(mtx_);
+        buf->ring = std::make_unique<TraceSlot[]>(capacity_);
+        buf->mask = capacity_ - 1;
+        buf->tid = static_cast<uint32_t>(buffers_.size() + 1);
+        buf->name = t_thread_name.empty() ? "thread-" + std::to_string(buf->tid) : t_thread_name;
+        t_buffer = buf.get();
+        buffers_.push_back(std::move(buf));
+        return t_buffer;
+    }
+
+    void Tracer::record(TraceEvent event, const Goroutine *g, uint8_t reason, uint64_t arg) {
+        ThreadBuffer *buf = local_buffer();
+        // 单写者：只有本线程推进 head
+        uint64_t pos = buf->head.load(std::memory_order_relaxed);
+        TraceSlot &s = buf->ring[pos & buf->mask];
+        std::string_view tag = g ? g->trace_tag() : std::string_view();
+        // 槽内容的写入不能排到 head 走到 pos 之前：导出线程读到新内容时，一定也能看到 head 已经到了 pos
+        std::atomic_thread_fence(std::memory_order_release);
+        s.ts_ns.store(static_cast<uint64_t>(trace_now_ns()), std::memory_order_relaxed);
+        s.gid.store(g ? g->id() : 0, std::memory_order_relaxed);
+        s.arg.store(arg, std::memory_order_relaxed);
+        s.tag.store(tag.data(), std::memory_order_relaxed);
+        s.meta.store(tag.size() | static_cast<uint64_t>(event) << 32 | static_cast<uint64_t>(reason) << 40,
+                     std::memory_order_relaxed);
+        buf->head.store(pos + 1, std::memory_order_release);
+    }
+
+    bool Tracer::snapshot(const ThreadBuffer &buf, uint64_t pos, TraceRecord &r) {
+        const TraceSlot &s = buf.ring[pos & buf.mask];
+        r.ts_ns = s.ts_ns.load(std::memory_order_relaxed);
+        r.gid = s.gid.load(std::memory_order_relaxed);
+        r.arg = s.arg.load(std::memory_order_relaxed);
+        r.tag = s.tag.load(std::memory_order_relaxed);
+        uint64_t meta = s.meta.load(std::memory_order_relaxed);
+        r.tag_len = static_cast<uint32_t>(meta);
+        r.event = static_cast<TraceEvent>(meta >> 32);
+        r.reason = static_cast<uint8_t>(meta >> 40);
+        // 类似 seqlock 的复查：拷贝期间写入方已经走到 pos + 容量，说明这个槽正在（或已经）被下一圈覆盖，
+        // 拷出来的字段可能新旧混杂
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return buf.head.load(std::memory_order_relaxed) <= pos + buf.mask;
+    }
+
+    static const char *park_reason_name(uint8_t r) {
+        switch (static_cast<ParkReason>(r)) {
+            case ParkReason::Yield: return "yield";
+            case ParkReason::NetRead: return "net_read";
+            case ParkReason::NetWrite: return "net_write";
+            case ParkReason::Database: return "database";
+            case ParkReason::Timer: return "timer";
+            case ParkReason::Channel: return "channel";
+            case ParkReason::Mutex: return "mutex";
+            case ParkReason::WaitGroup: return "wait_group";
+            case ParkReason::Blocking: return "blocking";
+        }
+        return "unknown";
+    }
+
+    static const char *wake_source_name(uint8_t s) {
+        switch (static_cast<WakeSource>(s)) {
+            case WakeSource::Unknown: return "unknown";
+            case WakeSource::Spawn: return "spawn";
+            case WakeSource::Netpoller: return "netpoller";
+            case WakeSource::Timer: return "timer";
+            case WakeSource::Channel: return "channel";
+            case WakeSource::Mutex: return "mutex";
+            case WakeSource::WaitGroup: return "wait_group";
+            case WakeSource::Blocking: return "blocking";
+        }
+        return "unknown";
+    }
+
+    static void write_json_string(std::ostream &out, std::string_view s) {
+        out << '"';
+        for (char c: s) {
+            if (c == '"' || c == '\\') out << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+            else out << c;
+        }
+        out << '"';
+    }
+
+    void Tracer::dump(std::ostream &out) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        bool first = true;
+        auto sep = [&]() {
+            if (!first) out << ",\n";
+            first = false;
+        };
+
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        for (auto &buf: buffers_) {
+            sep();
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buf->tid
+                    << ",\"args\":{\"name\":";
+            write_json_string(out, buf->name);
+            out << "}}";
+
+            // 缓冲区已经回绕时只导出最近的 capacity 条
+            uint64_t head = buf->head.load(std::memory_order_acquire);
+            uint64_t cap = buf->mask + 1;
+            uint64_t begin = head > cap ? head - cap : 0;
+            for (uint64_t i = begin; i < head; ++i) {
+                TraceRecord r;
+                if (!snapshot(*buf, i, r)) continue; // 导出期间被覆盖了
+                double ts_us = static_cast<double>(static_cast<int64_t>(r.ts_ns) - base_ns_) / 1000.0;
+                if (ts_us < 0) continue; // 上一轮 start 之前的残留
+                std::string_view tag(r.tag ? r.tag : "", r.tag_len);
+
+                sep();
+                out << "{\"pid\":1,\"tid\":" << buf->tid << ",\"ts\":" << std::fixed << ts_us;
+                switch (r.event) {
+                    case TraceEvent::Resume:
+                        out << ",\"ph\":\"B\",\"cat\":\"goroutine\",\"name\":";
+                        write_json_string(out, tag.empty() ? std::string_view("goroutine") : tag);
+                        out << ",\"args\":{\"gid\":" << r.gid << ",\"queued_us\":" << r.arg / 1000.0;
+                        if (!tag.empty()) {
+                            out << ",\"route\":";
+                            write_json_string(out, tag);
+                        }
+                        out << "}}";
+                        break;
+                    case TraceEvent::Park:
+                        out << ",\"ph\":\"E\",\"args\":{\"gid\":" << r.gid << ",\"park\":\""
+                                << park_reason_name(r.reason) << "\"}}";
+                        break;
+                    case TraceEvent::Finish:
+                        out << ",\"ph\":\"E\",\"args\":{\"gid\":" << r.gid << ",\"finish\":true}}";
+                        break;
+                    case TraceEvent::Spawn:
+                        out << ",\"ph\":\"i\",\"s\":\"t\",\"name\":\"spawn\",\"args\":{\"gid\":" << r.gid << "}}";
+                        break;
+                    case TraceEvent::Wake:
+                        out << ",\"ph\":\"i\",\"s\":\"t\",\"name\":\"wake\",\"args\":{\"gid\":" << r.gid
+                                << ",\"source\":\"" << wake_source_name(r.reason) << "\"}}";
+                        break;
+                }
+            }
+        }
+        out << "\n]}\n";
+    }
+
+    bool Tracer::dump(const std::string &path) {
+        std::ofstream ofs(path, std::ios::trunc);
+        if (!ofs.is_open()) return false;
+        dump(ofs);
+        return ofs.good();
+    }
+} // namespace runtime
@@ -57,6 +57,17 @@ struct Employee : public db::Model {
             {"salary", std::to_string(salary)}
         };
     }
+
+    using db::Model::write_json;
+
+    void write_json(gee::JsonWriter &w) const override {
+        w.begin_object()
+                .field("id", id)
+                .field("name", name)
+                .field("department", department)
+                .field("salary", salary)
+                .end_object();
+    }
 };
 
 int mysql_test() {
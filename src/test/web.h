@@ -38,12 +38,15 @@ struct Employee : public db::Model {
         };
     }
 
-    void write_json(std::string &out) const {
-        out.append("{\"id\":").append(std::to_string(id))
-                .append(",\"name\":\"").append(name)
-                .append("\",\"department\":\"").append(department)
-                .append("\",\"salary\":").append(std::to_string(salary))
-                .append("}");
+    using db::Model::write_json;
+
+    void write_json(gee::JsonWriter &w) const override {
+        w.begin_object()
+                .field("id", id)
+                .field("name", name)
+                .field("department", department)
+                .field("salary", salary)
+                .end_object();
     }
 };
 
@@ -0,0 +1,73 @@
+#include "web/core/admission.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "runtime/tracer.h"
+
+namespace gee {
+    namespace {
+        // 不设上界的自适应模式也不能无限增长
+        constexpr int kMaxLimit = 1 << 20;
+    }
+
+    void AdmissionController::configure(const AdmissionConfig &config) {
+        config_ = config;
+        enabled_ = config.adaptive || config.max_inflight > 0;
+        ceiling_ = config.max_inflight > 0 ? config.max_inflight : kMaxLimit;
+        if (config_.min_limit < 1) config_.min_limit = 1;
+        int start = config.adaptive ? std::clamp(config.initial_limit, config_.min_limit, ceiling_) : ceiling_;
+        limit_.store(start);
+        window_start_ns_.store(runtime::trace_now_ns());
+    }
+
+    bool AdmissionController::try_acquire() {
+        int limit = limit_.load(std::memory_order_relaxed);
+        int cur = inflight_.load(std::memory_order_relaxed);
+        while (true) {
+            if (cur >= limit) {
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                saturated_.store(true, std::memory_order_relaxed);
+                return false;
+            }
+            if (inflight_.compare_exchange_weak(cur, cur + 1, std::memory_order_acq_rel)) break;
+        }
+        if (cur + 1 >= limit) saturated_.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    void AdmissionController::release(int64_t latency_ns) {
+        inflight_.fetch_sub(1, std::memory_order_acq_rel);
+        if (!config_.adaptive || latency_ns < 0) return;
+
+        latency_sum_ns_.fetch_add(latency_ns, std::memory_order_relaxed);
+        samples_.fetch_add(1, std::memory_order_relaxed);
+
+        int64_t now = runtime::trace_now_ns();
+        int64_t start = window_start_ns_.load(std::memory_order_relaxed);
+        if (now - start < static_cast<int64_t>(config_.window_ms) * 1000000) return;
+        // 只有一个请求负责结算这个窗口
+        if (!window_start_ns_.compare_exchange_strong(start, now, std::memory_order_acq_rel)) return;
+        update_limit();
+    }
+
+    void AdmissionController::update_limit() {
+        int64_t n = samples_.exchange(0, std::memory_order_relaxed);
+        int64_t sum = latency_sum_ns_.exchange(0, std::memory_order_relaxed);
+        bool saturated = saturated_.exchange(false, std::memory_order_relaxed);
+        if (n == 0) return;
+
+        int64_t avg = sum / n;
+        // 基线每个窗口上浮 1%，负载特征变化（例如换了一批更慢的接口）后能重新学习
+        baseline_ns_ = baseline_ns_ == 0 ? avg : std::min(avg, baseline_ns_ + baseline_ns_ / 100 + 1);
+
+        int limit = limit_.load(std::memory_order_relaxed);
+        int next = limit;
+        if (static_cast<double>(avg) > static_cast<double>(baseline_ns_) * config_.tolerance) {
+            next = static_cast<int>(limit * config_.backoff);
+        } else if (saturated) {
+            next = limit + std::max(1, static_cast<int>(std::sqrt(static_cast<double>(limit))));
+        }
+        limit_.store(std::clamp(next, config_.min_limit, ceiling_), std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,172 @@
+#include "web/core/broadcaster.h"
+
+#include <iterator>
+
+#include "runtime/context/web_context.h"
+#include "runtime/scheduler.h"
+#include "web/protocol/response_stream.h"
+
+namespace gee {
+    Broadcaster::Broadcaster(BroadcasterConfig config) : state_(std::make_shared<State>()) {
+        if (config.shards == 0) config.shards = 1;
+        if (config.queue_limit == 0) config.queue_limit = 1;
+        state_->shards = std::vector<Shard>(config.shards);
+        state_->config = config;
+        if (config.heartbeat_ms > 0) arm_heartbeat(state_, config.heartbeat_ms);
+    }
+
+    Broadcaster::~Broadcaster() {
+        close();
+    }
+
+    size_t Broadcaster::publish(std::string_view data, std::string_view event, std::string_view id) {
+        return publish_raw(std::make_shared<const std::string>(sse_format(data, event, id)));
+    }
+
+    size_t Broadcaster::publish_raw(std::shared_ptr<const std::string> frame) {
+        if (state_->closed.load() || !frame || frame->empty()) return 0;
+        return fan_out(*state_, frame, false);
+    }
+
+    size_t Broadcaster::fan_out(State &state, const std::shared_ptr<const std::string> &frame, bool heartbeat) {
+        const size_t limit = state.config.queue_limit;
+        const bool disconnect = state.config.policy == SlowPolicy::Disconnect;
+        size_t delivered = 0;
+        std::vector<runtime::Goroutine::Ptr> wake;
+        for (Shard &shard: state.shards) {
+            shard.lock.lock();
+            for (const auto &sub: shard.subs) {
+                sub->lock.lock();
+                if (sub->closed || (heartbeat && !sub->queue.empty())) {
+                    sub->lock.unlock();
+                    continue;
+                }
+                if (sub->queue.size() >= limit) {
+                    state.dropped.fetch_add(1, std::memory_order_relaxed);
+                    if (disconnect) {
+                        sub->closed = true;
+                        sub->evicted = true;
+                        sub->queue.clear();
+                        if (sub->waiter) wake.push_back(std::move(sub->waiter));
+                        sub->lock.unlock();
+                        continue;
+                    }
+                    sub->queue.pop_front();
+                }
+                sub->queue.push_back(frame);
+                ++delivered;
+                if (sub->waiter) wake.push_back(std::move(sub->waiter));
+                sub->lock.unlock();
+            }
+            shard.lock.unlock();
+            // 分片锁外唤醒，订阅/退订不用等调度器的锁
+            for (auto &g: wake) runtime::Scheduler::get().push_ready(std::move(g), runtime::WakeSource::Channel);
+            wake.clear();
+        }
+        return delivered;
+    }
+
+    void Broadcaster::add(State &state, const std::shared_ptr<Subscriber> &sub) {
+        size_t idx = state.next_shard.fetch_add(1, std::memory_order_relaxed) % state.shards.size();
+        Shard &shard = state.shards[idx];
+        shard.lock.lock();
+        sub->shard = idx;
+        sub->pos = shard.subs.size();
+        shard.subs.push_back(sub);
+        shard.lock.unlock();
+        state.count.fetch_add(1, std::memory_order_relaxed);
+        // close() 可能在入表之前已经扫过这个分片
+        if (state.closed.load()) {
+            sub->lock.lock();
+            sub->closed = true;
+            sub->lock.unlock();
+        }
+    }
+
+    void Broadcaster::remove(State &state, const Subscriber &sub) {
+        Shard &shard = state.shards[sub.shard];
+        shard.lock.lock();
+        // 与末尾交换后删除，O(1)
+        size_t pos = sub.pos;
+        if (pos + 1 != shard.subs.size()) {
+            shard.subs[pos] = std::move(shard.subs.back());
+            shard.subs[pos]->pos = pos;
+        }
+        shard.subs.pop_back();
+        shard.lock.unlock();
+        state.count.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void Broadcaster::serve(WebContext *c) {
+        std::shared_ptr<State> state = state_;
+        ResponseStream &stream = c->SSE();
+        if (!stream.ok()) return;
+
+        auto sub = std::make_shared<Subscriber>();
+        add(*state, sub);
+
+        auto self = runtime::Goroutine::current();
+        std::vector<std::shared_ptr<const std::string> > batch;
+        bool evicted = false;
+        while (true) {
+            sub->lock.lock();
+            if (sub->queue.empty() && !sub->closed) {
+                sub->lock.unlock();
+                // 切出之后再登记：发布方入队时看到 waiter 才唤醒
+                runtime::Goroutine::park(runtime::ParkReason::Channel, [&sub, &self]() {
+                    sub->lock.lock();
+                    if (!sub->queue.empty() || sub->closed) {
+                        sub->lock.unlock();
+                        runtime::Scheduler::get().push_ready(self, runtime::WakeSource::Channel);
+                        return;
+                    }
+                    sub->waiter = self;
+                    sub->lock.unlock();
+                });
+                sub->lock.lock();
+            }
+            // 积压的事件一次取走，合并成一次 writev
+            batch.assign(std::make_move_iterator(sub->queue.begin()), std::make_move_iterator(sub->queue.end()));
+            sub->queue.clear();
+            bool closed = sub->closed;
+            evicted = sub->evicted;
+            sub->lock.unlock();
+
+            for (auto &frame: batch) stream.write_shared(std::move(frame));
+            batch.clear();
+            if (!stream.flush() || closed) break;
+        }
+
+        remove(*state, *sub);
+        // 被断开的慢客户端不复用连接；正常关闭时由连接循环补上结束块
+        if (evicted || !stream.ok()) c->res_.keep_alive = false;
+    }
+
+    void Broadcaster::close() {
+        State &state = *state_;
+        if (state.closed.exchange(true)) return;
+        std::vector<runtime::Goroutine::Ptr> wake;
+        for (Shard &shard: state.shards) {
+            shard.lock.lock();
+            for (const auto &sub: shard.subs) {
+                sub->lock.lock();
+                sub->closed = true;
+                if (sub->waiter) wake.push_back(std::move(sub->waiter));
+                sub->lock.unlock();
+            }
+            shard.lock.unlock();
+        }
+        for (auto &g: wake) runtime::Scheduler::get().push_ready(std::move(g), runtime::WakeSource::Channel);
+    }
+
+    void Broadcaster::arm_heartbeat(const std::weak_ptr<State> &weak, int ms) {
+        runtime::Scheduler::get().add_timer(ms, nullptr, [weak, ms]() {
+            auto state = weak.lock();
+            if (!state || state->closed.load()) return;
+            // 注释行，EventSource 会忽略；写失败的订阅者借此退出
+            static const auto kPing = std::make_shared<const std::string>(":\n\n");
+            fan_out(*state, kPing, true);
+            arm_heartbeat(weak, ms);
+        });
+    }
+}
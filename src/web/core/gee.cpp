@@ -1,8 +1,16 @@
 #include "web/core/gee.h"
+#include "web/core/http2.h"
 #include "runtime/goroutine.h"
+#include "runtime/scheduler.h"
+#include "runtime/spinlock.h"
+#include "runtime/netpoller.h"
 #include <iostream>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
 #include <fcntl.h>
 #include <unistd.h>
 #include <spdlog/spdlog.h>
@@ -11,74 +19,347 @@
 
 namespace gee {
     void Engine::Run(int port) {
-        int listen_fd = create_listen_socket(port);
+        not_found_chain_ = this->middlewares_;
+        not_found_chain_.push_back([](WebContext *c) {
+            c->JSON(gee::StateCode::NOT_FOUND, "404 Not Found", "{}");
+        });
+
+        admission_.configure(config_.admission);
+
+        // 往已断开的连接写（SSE、WebSocket 推送时很常见）按 EPIPE 处理，不能让 SIGPIPE 杀掉进程
+        std::signal(SIGPIPE, SIG_IGN);
+
+        if (!open_listeners(port)) {
+            spdlog::error("No listener on port {}", port);
+            return;
+        }
+        acceptors_ = listen_fds_.size();
+        for (int listen_fd: listen_fds_) {
+            runtime::go([this, listen_fd]() {
+                accept_loop(listen_fd);
+                std::lock_guard<std::mutex> lock(run_mutex_);
+                --acceptors_;
+                run_cv_.notify_all();
+            });
+        }
+        spdlog::info("Listening on :{} with {} acceptor(s)", port, listen_fds_.size());
+
+        // accept 全在协程里完成，主线程等退出或升级信号，之后排空在途连接
+        wait_for_shutdown();
+        drain(config_.drain_timeout_ms);
+        // 还挂着的协程（没在期限内结束的 Handler、定时器）都捕获了 this，Engine 析构前让它们全部停下
+        runtime::Scheduler::get().stop();
+    }
+
+    namespace {
+        int accept_conn(int listen_fd) {
+#ifdef __linux__
+            return ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+            // BSD/macOS 没有 accept4；新连接会继承监听 socket 的 O_NONBLOCK，只需补上 CLOEXEC
+            int fd = ::accept(listen_fd, nullptr, nullptr);
+            if (fd >= 0) fcntl(fd, F_SETFD, FD_CLOEXEC);
+            return fd;
+#endif
+        }
+    }
+
+    void Engine::accept_loop(int listen_fd) {
+        auto self = runtime::Goroutine::current();
+        int batch = config_.accept_batch > 0 ? config_.accept_batch : 1;
         while (true) {
-            struct sockaddr_in client_addr;
-            socklen_t client_len = sizeof(client_addr);
-            int client_fd = accept(listen_fd, (struct sockaddr *) &client_addr, &client_len);
-
-            if (client_fd < 0) {
-                if (errno == EAGAIN || errno == EINTR) continue;
-                spdlog::error("client_fd appear panic");
-                break;
+            // 排空开始后不再接收：backlog 里的连接升级时留给新进程
+            if (draining_.load()) return;
+            int accepted = 0;
+            bool backoff = false;
+            while (accepted < batch) {
+                int fd = accept_conn(listen_fd);
+                if (fd >= 0) {
+                    setup_conn_socket(fd);
+                    handle_http_task(fd);
+                    ++accepted;
+                    continue;
+                }
+                if (draining_.load()) return; // 监听 socket 已经关闭或交给了新进程
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                    // fd 或内存耗尽：连接留在 backlog 里，稍后再试
+                    spdlog::error("accept failed: {}, backing off", strerror(errno));
+                    backoff = true;
+                    break;
+                }
+                spdlog::error("accept failed: {}, acceptor exits", strerror(errno));
+                ::close(listen_fd);
+                return;
             }
 
-            // 設置非阻塞，這是協程 IO 能正常運作的前提
-            fcntl(client_fd, F_SETFL, fcntl(client_fd, F_GETFL) | O_NONBLOCK);
-            handle_http_task(client_fd);
+            if (backoff) {
+                runtime::sleep(10);
+            } else if (accepted >= batch) {
+                // 还可能有积压，让其他协程先跑一轮再继续
+                runtime::yield_now();
+            } else {
+                // 切出之后再注册可读事件，防止事件先到、被另一个 Worker 在切出前 resume
+                runtime::Goroutine::park(runtime::ParkReason::NetRead, [this, listen_fd, self]() {
+                    runtime::Netpoller::get().watch(listen_fd, runtime::IOEvent::Read, self);
+                    // drain 在注册之前就 forget 过了：自己再 forget 一次，把刚挂上的自己叫醒
+                    if (draining_.load()) runtime::Netpoller::get().forget(listen_fd);
+                });
+            }
         }
     }
 
-    void Engine::handle_http_task(int client_fd) {
-        runtime::go([this, client_fd]() {
-            gee::WebContext ctx(client_fd);
-            try {
-                if (ctx.req_.parse(client_fd)) {
-                    auto [node, params] = get_route(std::string(ctx.method()), std::string(ctx.path()));
-
-                    if (node) {
-                        ctx.set_params(std::move(params));
-                        std::string key = std::string(ctx.method()) + "-" + node->pattern;
-
-                        if (route_handlers_chain_.count(key)) {
-                            ctx.handlers_ = route_handlers_chain_[key];
-                        } else {
-                            throw std::runtime_error("Route exists but handler chain is missing");
-                        }
+    void Engine::setup_conn_socket(int fd) const {
+        if (config_.tcp_nodelay) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+    }
+
+    namespace {
+        using detail::IdleGuard;
+
+        // 流水线合批的字节上限，超过就先写出去
+        constexpr size_t kMaxPipelineBytes = 256 * 1024;
+
+        void arm_idle_timer(std::shared_ptr<IdleGuard> guard, int fd, int timeout_ms, int delay_ms) {
+            runtime::Scheduler::get().add_timer(delay_ms, nullptr, [guard, fd, timeout_ms]() {
+                guard->lock.lock();
+                if (guard->closed) {
+                    guard->lock.unlock();
+                    return;
+                }
+                int next = timeout_ms;
+                if (guard->idle) {
+                    auto idle_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - guard->idle_since).count();
+                    if (idle_ms >= timeout_ms && guard->on_drain && !guard->drain_requested) {
+                        // HTTP/2 先发 GOAWAY；再过一个周期还没关掉（对端不读，写不出去）就直接断开
+                        guard->drain_requested = true;
+                        guard->on_drain();
+                    } else if (idle_ms >= timeout_ms) {
+                        // 只 shutdown 不 close：挂在 netpoller 上的读协程被唤醒后读到 EOF，由它自己关闭 fd
+                        ::shutdown(fd, SHUT_RDWR);
+                        guard->lock.unlock();
+                        return;
                     } else {
-                        ctx.handlers_ = this->middlewares_;
-                        ctx.handlers_.push_back([](WebContext *c) {
-                            c->JSON(gee::StateCode::NOT_FOUND, "404 Not Found", "{}");
-                        });
+                        next = timeout_ms - static_cast<int>(idle_ms);
                     }
-                    ctx.Next();
+                }
+                guard->lock.unlock();
+                arm_idle_timer(guard, fd, timeout_ms, next);
+            });
+        }
+    }
 
-                    if (!ctx.res_.is_sent) {
-                        ctx.JSON(gee::StateCode::OK, "OK", "{}");
+    void Engine::handle_http_task(int client_fd) {
+        runtime::go([this, client_fd]() {
+            auto guard = std::make_shared<IdleGuard>();
+            track_conn(client_fd, guard);
+            if (config_.idle_timeout_ms > 0) {
+                arm_idle_timer(guard, client_fd, config_.idle_timeout_ms, config_.idle_timeout_ms);
+            }
+
+            // 同一个连接上的请求复用一个 WebContext
+            gee::WebContext ctx(client_fd);
+            int served = 0;
+            while (true) {
+                guard->set_idle(true);
+                // 先标记空闲再检查：排空要么看到空闲把它踢掉，要么这里看到标志自己退出
+                if (draining_.load()) break;
+                bool ok = ctx.req_.read_header(client_fd);
+                guard->set_idle(false);
+                if (!ok) {
+                    // HTTP/2 连接前言过不了 HTTP/1 请求行解析：按先验知识的 h2c 接管整个连接
+                    if (served == 0 && config_.h2c && Http2Connection::is_preface(ctx.req_.raw_data_.view())) {
+                        Http2Connection(*this, client_fd, guard).serve(ctx.req_.raw_data_);
                     }
+                    break;
                 }
-            } catch (const std::exception &e) {
-                spdlog::error("Critical Request Error: {}", e.what());
-                if (!ctx.res_.is_sent) {
-                    ctx.JSON(gee::StateCode::SERVER_ERROR, "Critical Server Error", "{}");
+                // 排队太久的请求在读 Body、路由之前就拒绝，省下的 CPU 留给还来得及的请求
+                if (over_queue_budget()) {
+                    reject_overloaded(ctx);
+                    break;
                 }
+                if (!ctx.req_.read_body(client_fd)) break;
+
+                if (config_.h2c && Http2Connection::wants_upgrade(ctx.req_)
+                    && Http2Connection(*this, client_fd, guard).serve_upgrade(ctx)) {
+                    break;
+                }
+
+                ++served;
+                bool allowed = config_.max_requests_per_conn <= 0 || served < config_.max_requests_per_conn;
+                if (!serve_request(ctx, allowed)) break;
+                ctx.reset();
+
+                // 流水线：缓冲区里还有完整请求就先不写，攒一批响应一次 writev；
+                // 接下来要等 socket 时必须先把响应发出去，否则客户端会一直等
+                bool pipelined = ctx.req_.buffered_request_ready()
+                                 && static_cast<int>(ctx.out_.responses()) < config_.max_pipeline_depth
+                                 && ctx.out_.bytes() < kMaxPipelineBytes;
+                if (!pipelined && !ctx.flush()) break;
             }
+
+            ctx.flush();
+            // fd 关闭之前出表，编号被新连接复用时不会认错
+            untrack_conn(client_fd);
+            runtime::Netpoller::get().forget(client_fd);
+            guard->lock.lock();
+            guard->closed = true;
             ::close(client_fd);
+            guard->lock.unlock();
         });
     }
 
+    void Engine::track_conn(int fd, const std::shared_ptr<IdleGuard> &guard) {
+        conns_lock_.lock();
+        conns_[fd] = guard;
+        conns_lock_.unlock();
+    }
+
+    void Engine::untrack_conn(int fd) {
+        conns_lock_.lock();
+        conns_.erase(fd);
+        bool last = conns_.empty();
+        conns_lock_.unlock();
+        if (last && draining_.load()) {
+            // 持锁通知，drain 不会在检查与等待之间错过
+            std::lock_guard<std::mutex> lock(run_mutex_);
+            run_cv_.notify_all();
+        }
+    }
+
+    void Engine::kick_idle_conns() {
+        conns_lock_.lock();
+        for (auto &[fd, guard]: conns_) {
+            guard->lock.lock();
+            if (!guard->closed) {
+                if (guard->on_drain) {
+                    // HTTP/2：发 GOAWAY，正在处理的流照常完成（重复调用无副作用）
+                    guard->on_drain();
+                } else if (guard->idle) {
+                    // 与空闲超时相同：只 shutdown，等在 read 上的协程读到 EOF 后自己关闭 fd
+                    ::shutdown(fd, SHUT_RDWR);
+                }
+            }
+            guard->lock.unlock();
+        }
+        conns_lock_.unlock();
+    }
+
+    void Engine::cut_conns() {
+        conns_lock_.lock();
+        for (auto &[fd, guard]: conns_) {
+            guard->lock.lock();
+            // 同样只 shutdown：读写都会失败，连接协程退出时自己关闭 fd
+            if (!guard->closed) ::shutdown(fd, SHUT_RDWR);
+            guard->lock.unlock();
+        }
+        conns_lock_.unlock();
+    }
+
+    bool Engine::over_queue_budget() const {
+        if (config_.queue_budget_ms <= 0) return false;
+        auto g = runtime::Goroutine::current();
+        return g && g->queued_ns() > static_cast<int64_t>(config_.queue_budget_ms) * 1000000;
+    }
+
+    void Engine::reject_overloaded(WebContext &ctx) {
+        static constexpr std::string_view kBody = R"({"state":503,"message":"Server Overloaded","data":{}})";
+        ctx.res_.keep_alive = false;
+        ctx.res_.write_head(ctx.out_, 503, gee::kJsonContentType, kBody.size(), "Retry-After: 1\r\n", kBody);
+        ctx.out_.end_response();
+        ctx.res_.is_sent = true;
+    }
+
+    bool Engine::serve_request(WebContext &ctx, bool keep_alive_allowed) {
+        // 排空期间处理完这个请求就关闭连接
+        ctx.res_.keep_alive = keep_alive_allowed && ctx.req_.reusable_ && ctx.req_.keep_alive() && !draining_.load();
+        if (admission_.enabled()) {
+            if (!admission_.try_acquire()) {
+                reject_overloaded(ctx);
+                return false;
+            }
+            ctx.admit(&admission_);
+        }
+        if (config_.compression) {
+            ctx.res_.encoding = negotiate_encoding(ctx.req_.get_header(HeaderId::AcceptEncoding));
+            ctx.res_.compress_level = config_.compression_level;
+            ctx.res_.compress_min = config_.compression_min_bytes;
+            ctx.res_.vary_encoding = true;
+        }
+        try {
+            // 只挂指针，不拷贝执行链
+            const Route *route = get_route(ctx.method(), ctx.path(), ctx.params_);
+            if (route) {
+                runtime::Goroutine::current()->set_trace_tag(route->pattern);
+                ctx.handlers_ = &route->chain;
+            } else {
+                runtime::Goroutine::current()->set_trace_tag({});
+                ctx.handlers_ = &not_found_chain_;
+            }
+            ctx.Next();
+
+            // Handler 没有显式结束的流在这里补上结束块
+            if (ctx.stream_) {
+                if (!ctx.stream_->end()) ctx.res_.keep_alive = false;
+            }
+            if (!ctx.res_.is_sent) {
+                ctx.JSON(gee::StateCode::OK, "OK", "{}");
+            }
+        } catch (const std::exception &e) {
+            spdlog::error("Critical Request Error: {}", e.what());
+            // Header 已经发出的流没法改成 500，直接断开，让客户端看到不完整的响应
+            if (ctx.stream_) ctx.res_.keep_alive = false;
+            if (!ctx.res_.is_sent) {
+                ctx.JSON(gee::StateCode::SERVER_ERROR, "Critical Server Error", "{}");
+            }
+        }
+        ctx.release_admission(true);
+        // 流式 Body 必须读到结尾，下一个请求才能从正确的位置开始解析
+        if (ctx.res_.keep_alive && !ctx.body_.drain(config_.max_body_drain)) {
+            ctx.res_.keep_alive = false;
+        }
+        return ctx.res_.keep_alive;
+    }
+
     int Engine::create_listen_socket(int port) {
         int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            spdlog::error("socket failed: {}", strerror(errno));
+            return -1;
+        }
+        // 监听 socket 本身非阻塞，由 netpoller 通知可读
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+
         int opt = 1;
         setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        if (config_.reuse_port) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
+        }
+        // 缓冲区大小要在 listen 之前设置，已接收的连接会继承
+        if (config_.rcvbuf > 0) setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &config_.rcvbuf, sizeof(int));
+        if (config_.sndbuf > 0) setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &config_.sndbuf, sizeof(int));
+#ifdef TCP_DEFER_ACCEPT
+        if (config_.defer_accept_s > 0) {
+            setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &config_.defer_accept_s, sizeof(int));
+        }
+#endif
 
         struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
         addr.sin_family = AF_INET;
         addr.sin_port = htons(port);
         addr.sin_addr.s_addr = INADDR_ANY;
 
-        bind(fd, (struct sockaddr *) &addr, sizeof(addr));
-        listen(fd, 1024);
+        if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 || listen(fd, config_.backlog) < 0) {
+            spdlog::error("bind/listen on port {} failed: {}", port, strerror(errno));
+            ::close(fd);
+            return -1;
+        }
         return fd;
     }
 }
@@ -0,0 +1,332 @@
+#include "web/core/gee.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <spdlog/spdlog.h>
+
+#include "runtime/netpoller.h"
+
+#ifdef __APPLE__
+#include <crt_externs.h>
+#include <mach-o/dyld.h>
+#define environ (*_NSGetEnviron())
+#else
+extern char **environ;
+#endif
+
+namespace gee {
+    namespace {
+        // 继承给新进程的监听 socket，逗号分隔，例如 "3,4"
+        constexpr const char *kListenFdsEnv = "GEE_LISTEN_FDS";
+        // 新进程开始 accept 后往这个 fd 写一个字节，旧进程收到才开始排空
+        constexpr const char *kReadyFdEnv = "GEE_READY_FD";
+
+        // 排空期间每隔这么久再踢一次刚变空闲的连接
+        constexpr int kDrainTickMs = 100;
+        // 超时断开之后再等连接协程退出的时间；还卡在 Handler 里的协程随调度器一起停掉
+        constexpr int kCutGraceMs = 1000;
+
+        // self-pipe：信号处理函数只写一个字节，真正的处理在 wait_for_shutdown 所在的线程里
+        int *signal_pipe() {
+            static int fds[2] = {-1, -1};
+            static bool init = [] {
+                if (::pipe(fds) < 0) return false;
+                for (int fd: fds) fcntl(fd, F_SETFD, FD_CLOEXEC);
+                fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+                return true;
+            }();
+            (void) init;
+            return fds;
+        }
+
+        int g_signal_write_fd = -1;
+
+        void on_signal(int sig) {
+            int saved = errno;
+            char b = static_cast<char>(sig);
+            if (g_signal_write_fd >= 0) (void) !::write(g_signal_write_fd, &b, 1);
+            errno = saved;
+        }
+
+        bool is_listening_socket(int fd) {
+            int v = 0;
+            socklen_t len = sizeof(v);
+            return getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &v, &len) == 0 && v != 0;
+        }
+
+        // 新进程就绪：通知拉起它的旧进程
+        void notify_ready() {
+            const char *env = std::getenv(kReadyFdEnv);
+            if (!env) return;
+            int fd = std::atoi(env);
+            unsetenv(kReadyFdEnv);
+            if (fd <= 2) return;
+            char b = 1;
+            (void) !::write(fd, &b, 1);
+            ::close(fd);
+        }
+
+        // 可执行文件路径：部署时二进制通常已被替换，要 exec 的是同一路径上的新文件
+        std::string self_exe() {
+#ifdef __APPLE__
+            char buf[4096];
+            uint32_t size = sizeof(buf);
+            if (_NSGetExecutablePath(buf, &size) != 0) return {};
+            return buf;
+#else
+            char buf[4096];
+            ssize_t n = ::readlink("/proc/self/exe", buf, sizeof(buf) - 1);
+            if (n <= 0) return {};
+            std::string path(buf, n);
+            // 原文件被覆盖或删除后内核会加上这个后缀
+            constexpr std::string_view kDeleted = " (deleted)";
+            if (path.size() > kDeleted.size() && path.compare(path.size() - kDeleted.size(), kDeleted.size(),
+                                                               kDeleted) == 0) {
+                path.resize(path.size() - kDeleted.size());
+            }
+            return path;
+#endif
+        }
+
+        std::vector<std::string> self_args() {
+            std::vector<std::string> args;
+#ifdef __APPLE__
+            int argc = *_NSGetArgc();
+            char **argv = *_NSGetArgv();
+            for (int i = 0; i < argc; ++i) args.emplace_back(argv[i]);
+#else
+            std::ifstream in("/proc/self/cmdline", std::ios::binary);
+            std::string all((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            size_t start = 0;
+            while (start < all.size()) {
+                size_t end = all.find('\0', start);
+                if (end == std::string::npos) end = all.size();
+                args.emplace_back(all, start, end - start);
+                start = end + 1;
+            }
+#endif
+            return args;
+        }
+    }
+
+    bool Engine::open_listeners(int port) {
+        if (const char *env = std::getenv(kListenFdsEnv)) {
+            // 由旧进程 exec 而来：监听 socket 已经 bind 好，连接一直在 backlog 里排队，不会被拒绝
+            std::string list = env;
+            unsetenv(kListenFdsEnv);
+            size_t pos = 0;
+            while (pos < list.size()) {
+                size_t comma = list.find(',', pos);
+                if (comma == std::string::npos) comma = list.size();
+                int fd = std::atoi(list.substr(pos, comma - pos).c_str());
+                pos = comma + 1;
+                if (fd <= 2 || !is_listening_socket(fd)) {
+                    spdlog::warn("{}: fd {} is not a listening socket, ignored", kListenFdsEnv, fd);
+                    continue;
+                }
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                listen_fds_.push_back(fd);
+            }
+            if (!listen_fds_.empty()) {
+                spdlog::info("Adopted {} inherited listener(s)", listen_fds_.size());
+                return true;
+            }
+        }
+
+        // 多个接收协程必须各自持有一个 SO_REUSEPORT 监听 socket，共用一个 fd 时 netpoller 只能挂一个等待者
+        int n = 1;
+        if (config_.acceptors > 1) {
+            if (config_.reuse_port) {
+                n = config_.acceptors;
+            } else {
+                spdlog::warn("acceptors > 1 requires reuse_port, falling back to a single acceptor");
+            }
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = create_listen_socket(port);
+            if (fd >= 0) listen_fds_.push_back(fd);
+        }
+        return !listen_fds_.empty();
+    }
+
+    void Engine::Stop() {
+        char b = SIGTERM;
+        (void) !::write(signal_pipe()[1], &b, 1);
+    }
+
+    void Engine::wait_for_shutdown() {
+        int *fds = signal_pipe();
+        if (config_.handle_signals) {
+            g_signal_write_fd = fds[1];
+            struct sigaction sa;
+            memset(&sa, 0, sizeof(sa));
+            sa.sa_handler = on_signal;
+            sigemptyset(&sa.sa_mask);
+            sa.sa_flags = SA_RESTART;
+            for (int sig: {SIGTERM, SIGINT, SIGUSR2}) sigaction(sig, &sa, nullptr);
+        }
+        notify_ready();
+
+        while (true) {
+            char sig = 0;
+            ssize_t n = ::read(fds[0], &sig, 1);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            if (sig != SIGUSR2) {
+                spdlog::info("Received signal {}, shutting down", static_cast<int>(sig));
+                break;
+            }
+            if (spawn_successor()) {
+                spdlog::info("Successor is ready, handing over");
+                break;
+            }
+            // 新进程没起来（编译错了、端口配置变了……），旧进程继续服务
+            spdlog::error("Upgrade failed, keep serving");
+        }
+
+        // 排空期间再按一次 Ctrl-C 直接退出
+        if (config_.handle_signals) {
+            std::signal(SIGINT, SIG_DFL);
+            std::signal(SIGTERM, SIG_DFL);
+        }
+    }
+
+    bool Engine::spawn_successor() {
+        std::string exe = self_exe();
+        std::vector<std::string> args = self_args();
+        if (exe.empty() || args.empty()) {
+            spdlog::error("Upgrade: cannot determine own executable");
+            return false;
+        }
+
+        int ready[2];
+        if (::pipe(ready) < 0) {
+            spdlog::error("Upgrade: pipe failed: {}", strerror(errno));
+            return false;
+        }
+        fcntl(ready[0], F_SETFD, FD_CLOEXEC);
+        fcntl(ready[1], F_SETFD, FD_CLOEXEC);
+
+        // fork 之后的子进程只能调用 async-signal-safe 的函数，参数全部提前准备好
+        std::string fd_list;
+        for (int fd: listen_fds_) {
+            if (!fd_list.empty()) fd_list += ',';
+            fd_list += std::to_string(fd);
+        }
+        std::vector<std::string> env;
+        for (char **e = environ; e && *e; ++e) {
+            std::string_view kv = *e;
+            if (kv.rfind(kListenFdsEnv, 0) == 0 || kv.rfind(kReadyFdEnv, 0) == 0) continue;
+            env.emplace_back(kv);
+        }
+        env.push_back(std::string(kListenFdsEnv) + "=" + fd_list);
+        env.push_back(std::string(kReadyFdEnv) + "=" + std::to_string(ready[1]));
+
+        std::vector<char *> argv, envp;
+        for (auto &a: args) argv.push_back(a.data());
+        argv.push_back(nullptr);
+        for (auto &e: env) envp.push_back(e.data());
+        envp.push_back(nullptr);
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            spdlog::error("Upgrade: fork failed: {}", strerror(errno));
+            ::close(ready[0]);
+            ::close(ready[1]);
+            return false;
+        }
+        if (pid == 0) {
+            for (int fd: listen_fds_) fcntl(fd, F_SETFD, 0);
+            fcntl(ready[1], F_SETFD, 0);
+            // 信号处置会被 exec 继承（忽略的保持忽略），恢复默认，由新进程自己安装
+            signal(SIGPIPE, SIG_DFL);
+            execve(exe.c_str(), argv.data(), envp.data());
+            _exit(127);
+        }
+
+        ::close(ready[1]);
+        spdlog::info("Upgrade: started pid {}, waiting for it to become ready", pid);
+        struct pollfd pfd{ready[0], POLLIN, 0};
+        int timeout = config_.upgrade_timeout_ms > 0 ? config_.upgrade_timeout_ms : -1;
+        int rc;
+        do {
+            rc = ::poll(&pfd, 1, timeout);
+        } while (rc < 0 && errno == EINTR);
+        char b = 0;
+        bool ok = rc > 0 && ::read(ready[0], &b, 1) == 1;
+        ::close(ready[0]);
+        if (!ok) {
+            // 超时或者新进程在就绪前退出了（EOF）
+            ::kill(pid, SIGKILL);
+            ::waitpid(pid, nullptr, 0);
+        }
+        return ok;
+    }
+
+    void Engine::drain(int timeout_ms) {
+        draining_.store(true);
+        // 接收协程挂在 netpoller 上：kqueue 关闭 fd 时静默删除事件，不先叫醒它们就永远醒不过来。
+        // forget 唤醒等待者，接收协程看到 draining_ 退出；都退出之后再关，不会有人还在用这些 fd
+        for (int fd: listen_fds_) runtime::Netpoller::get().forget(fd);
+        {
+            std::unique_lock<std::mutex> lock(run_mutex_);
+            run_cv_.wait(lock, [this] { return acceptors_ == 0; });
+        }
+        // 升级时新进程仍持有同一批 socket，backlog 里的连接由它接收
+        for (int fd: listen_fds_) ::close(fd);
+        listen_fds_.clear();
+
+        for (auto &fn: shutdown_hooks_) {
+            try {
+                fn();
+            } catch (const std::exception &e) {
+                spdlog::error("shutdown hook threw: {}", e.what());
+            }
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeout_ms, 0));
+        bool cut = false;
+        std::unique_lock<std::mutex> lock(run_mutex_);
+        while (true) {
+            // 等着下一个请求的连接直接断开；正在处理请求的连接回完这个响应（Connection: close）后自己关闭
+            if (cut) {
+                cut_conns();
+            } else {
+                kick_idle_conns();
+            }
+            conns_lock_.lock();
+            size_t left = conns_.size();
+            conns_lock_.unlock();
+            if (left == 0) break;
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) {
+                if (cut) {
+                    spdlog::warn("{} connection(s) still busy after being cut, stopping anyway", left);
+                    return;
+                }
+                // 期限到了：剩下的连接（长连接的 h2、WebSocket、迟迟不结束的请求）直接断开，再等它们退出
+                spdlog::warn("Drain timeout, cutting {} connection(s)", left);
+                cut = true;
+                deadline = now + std::chrono::milliseconds(kCutGraceMs);
+                continue;
+            }
+            run_cv_.wait_until(lock, std::min(deadline, now + std::chrono::milliseconds(kDrainTickMs)));
+        }
+        spdlog::info("All connections drained");
+    }
+}
@@ -0,0 +1,946 @@
+#include "web/core/http2.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <sys/socket.h>
+
+#include "runtime/netpoller.h"
+#include "runtime/scheduler.h"
+#include "web/core/gee.h"
+#include "runtime/context/web_context.h"
+
+namespace gee {
+    namespace {
+        enum FrameType : uint8_t {
+            kData = 0x0,
+            kHeaders = 0x1,
+            kPriority = 0x2,
+            kRstStream = 0x3,
+            kSettings = 0x4,
+            kPushPromise = 0x5,
+            kPing = 0x6,
+            kGoaway = 0x7,
+            kWindowUpdate = 0x8,
+            kContinuation = 0x9,
+        };
+
+        constexpr uint8_t kEndStream = 0x1;
+        constexpr uint8_t kAck = 0x1;
+        constexpr uint8_t kEndHeaders = 0x4;
+        constexpr uint8_t kPadded = 0x8;
+        constexpr uint8_t kPriorityFlag = 0x20;
+
+        enum ErrorCode : uint32_t {
+            kNoError = 0x0,
+            kProtocolError = 0x1,
+            kInternalError = 0x2,
+            kFlowControlError = 0x3,
+            kStreamClosed = 0x5,
+            kFrameSizeError = 0x6,
+            kRefusedStream = 0x7,
+            kCancel = 0x8,
+            kCompressionError = 0x9,
+            kEnhanceYourCalm = 0xb,
+        };
+
+        constexpr size_t kFrameHeader = 9;
+        constexpr size_t kMaxFrame = 16384; // 不调大 SETTINGS_MAX_FRAME_SIZE，对端按默认值发
+        constexpr size_t kMaxBody = 10 * 1024 * 1024; // 与 HTTP/1 的普通 Body 上限一致
+        constexpr size_t kMaxHeaderBlock = 64 * 1024;
+        constexpr size_t kMaxHead = 64 * 1024; // HTTP/1 响应头转换时的上限
+        constexpr size_t kMaxPending = 1024 * 1024; // 写缓冲超过这么多，流协程等写协程腾出空间
+        constexpr int64_t kConnWindow = 16 * 1024 * 1024; // 连接级接收窗口
+        constexpr int64_t kMaxWindow = 0x7fffffff;
+
+        uint32_t get32(const char *p) {
+            const auto *u = reinterpret_cast<const uint8_t *>(p);
+            return (uint32_t(u[0]) << 24) | (uint32_t(u[1]) << 16) | (uint32_t(u[2]) << 8) | uint32_t(u[3]);
+        }
+
+        void put32(std::string &out, uint32_t v) {
+            char b[4] = {char(v >> 24), char(v >> 16), char(v >> 8), char(v)};
+            out.append(b, 4);
+        }
+
+        void put_setting(std::string &out, uint16_t id, uint32_t v) {
+            out.push_back(char(id >> 8));
+            out.push_back(char(id));
+            put32(out, v);
+        }
+
+        // 去掉 PADDED 标志带来的填充，长度不合法返回 false
+        bool strip_padding(uint8_t flags, std::string_view &payload) {
+            if (!(flags & kPadded)) return true;
+            if (payload.empty()) return false;
+            size_t pad = static_cast<uint8_t>(payload[0]);
+            payload.remove_prefix(1);
+            if (pad > payload.size()) return false;
+            payload.remove_suffix(pad);
+            return true;
+        }
+
+        void to_lower(std::string &s) {
+            for (char &c: s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+
+        // HTTP/1 的逐跳头在 HTTP/2 里不允许出现
+        bool hop_by_hop(std::string_view name) {
+            return name == "connection" || name == "keep-alive" || name == "proxy-connection"
+                   || name == "transfer-encoding" || name == "upgrade";
+        }
+
+        // HTTP2-Settings 是不带填充的 base64url
+        bool base64url_decode(std::string_view in, std::string &out) {
+            uint32_t acc = 0;
+            int bits = 0;
+            for (char c: in) {
+                int v;
+                if (c >= 'A' && c <= 'Z') v = c - 'A';
+                else if (c >= 'a' && c <= 'z') v = c - 'a' + 26;
+                else if (c >= '0' && c <= '9') v = c - '0' + 52;
+                else if (c == '-' || c == '+') v = 62;
+                else if (c == '_' || c == '/') v = 63;
+                else if (c == '=') break;
+                else return false;
+                acc = (acc << 6) | static_cast<uint32_t>(v);
+                bits += 6;
+                if (bits >= 8) {
+                    bits -= 8;
+                    out.push_back(static_cast<char>((acc >> bits) & 0xFF));
+                }
+            }
+            return true;
+        }
+    }
+
+    /**
+     * @brief 流的响应出口：OutputQueue 每次 flush 都经过这里
+     * 先攒齐 HTTP/1 响应头，转换成 HTTP/2 头部列表；同一次 flush 里的 Body 片段合并成尽量少的 DATA 帧。
+     * HEADERS 推迟到第一次真正发 Body 时才发，最后一段 Body 带上 END_STREAM，
+     * 没有 Body 的响应只有一个 HEADERS 帧
+     */
+    struct Http2Connection::ResponseWriter {
+        static constexpr size_t kBatchBytes = 64 * 1024;
+
+        Http2Connection &conn;
+        std::shared_ptr<Stream> st;
+        std::string head; // 还没收齐的 HTTP/1 响应头
+        std::string body; // 本次 flush 攒下的 Body
+        HeaderList fields;
+        int status = 0;
+        bool head_done = false;
+        bool headers_sent = false;
+        bool failed = false;
+
+        ResponseWriter(Http2Connection &c, std::shared_ptr<Stream> s) : conn(c), st(std::move(s)) {
+        }
+
+        bool take(OutputQueue &q) {
+            if (!drain(q)) return false;
+            if (!body.empty() && !send_body(body, false)) failed = true;
+            body.clear();
+            return !failed;
+        }
+
+        // 响应结束：剩下的数据带 END_STREAM 发出，不再单独发一个空 DATA 帧
+        void finish(OutputQueue &q) {
+            drain(q);
+            if (failed || !head_done) {
+                conn.reset_stream(st->id, kInternalError);
+            } else if (!headers_sent && body.empty()) {
+                conn.send_headers(*st, status, fields, true);
+            } else {
+                send_body(body, true);
+            }
+        }
+
+        bool drain(OutputQueue &q) {
+            if (failed) {
+                q.drain([](std::string_view) { return false; });
+                return false;
+            }
+            if (!q.drain([this](std::string_view data) { return feed(data); })) failed = true;
+            return !failed;
+        }
+
+        bool feed(std::string_view data) {
+            if (!head_done) {
+                head.append(data.data(), data.size());
+                while (!head_done) {
+                    size_t end = head.find("\r\n\r\n");
+                    if (end == std::string::npos) return head.size() <= kMaxHead;
+                    if (!parse_head(std::string_view(head.data(), end + 2))) return false;
+                    head.erase(0, end + 4);
+                }
+                body.swap(head);
+                head.clear();
+                return true;
+            }
+            // 大块（文件分段）直接发，小片段攒起来
+            if (body.empty() && data.size() >= kBatchBytes) return send_body(data, false);
+            body.append(data.data(), data.size());
+            if (body.size() < kBatchBytes) return true;
+            bool ok = send_body(body, false);
+            body.clear();
+            return ok;
+        }
+
+        // text 是状态行加所有 Header 行，每行以 CRLF 结尾
+        bool parse_head(std::string_view text) {
+            size_t eol = text.find("\r\n");
+            std::string_view line = text.substr(0, eol);
+            size_t sp = line.find(' ');
+            if (line.substr(0, 5) != "HTTP/" || sp == std::string_view::npos || line.size() < sp + 4) return false;
+            int code = 0;
+            auto [end, ec] = std::from_chars(line.data() + sp + 1, line.data() + sp + 4, code);
+            if (ec != std::errc() || end != line.data() + sp + 4) return false;
+            // 1xx 中间响应（100 Continue）在 HTTP/2 里没有意义，直接丢掉
+            if (code < 200) return true;
+
+            status = code;
+            head_done = true;
+            size_t pos = eol + 2;
+            while (pos < text.size()) {
+                size_t e = text.find("\r\n", pos);
+                if (e == std::string_view::npos) e = text.size();
+                std::string_view h = text.substr(pos, e - pos);
+                pos = e + 2;
+                size_t colon = h.find(':');
+                if (colon == std::string_view::npos) continue;
+                std::string name(h.substr(0, colon));
+                to_lower(name);
+                if (hop_by_hop(name)) continue;
+                std::string_view value = h.substr(colon + 1);
+                while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+                while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+                fields.emplace_back(std::move(name), std::string(value));
+            }
+            return true;
+        }
+
+        bool send_body(std::string_view data, bool end_stream) {
+            if (!headers_sent) {
+                if (!conn.send_headers(*st, status, fields, false)) return false;
+                headers_sent = true;
+            }
+            return conn.send_data(*st, data, end_stream);
+        }
+    };
+
+    bool Http2Connection::is_preface(std::string_view data) {
+        if (data.size() < 16) return false;
+        size_t n = std::min(data.size(), kPreface.size());
+        return data.substr(0, n) == kPreface.substr(0, n);
+    }
+
+    bool Http2Connection::wants_upgrade(const Request &req) {
+        if (req.version != "HTTP/1.1" || req.body_deferred_ || req.content_length > 0) return false;
+        return header_has_token(req.get_header(HeaderId::Upgrade), "h2c") && req.headers.contains("HTTP2-Settings");
+    }
+
+    Http2Connection::Http2Connection(Engine &engine, int fd, std::shared_ptr<detail::IdleGuard> guard)
+        : engine_(engine), fd_(fd), guard_(std::move(guard)), conn_recv_window_(kConnWindow) {
+    }
+
+    template<typename F>
+    void Http2Connection::wait(runtime::Goroutine::Ptr &slot, runtime::ParkReason reason, F ready) {
+        lock_.lock();
+        bool done = ready();
+        lock_.unlock();
+        if (done) return;
+        auto g = runtime::Goroutine::current();
+        runtime::Goroutine::park(reason, [this, g, &slot, &ready]() {
+            lock_.lock();
+            if (ready()) {
+                lock_.unlock();
+                runtime::Scheduler::get().push_ready(g, runtime::WakeSource::Channel);
+                return;
+            }
+            slot = g;
+            lock_.unlock();
+        });
+    }
+
+    void Http2Connection::wake(runtime::Goroutine::Ptr &slot) {
+        if (slot) runtime::Scheduler::get().push_ready(std::move(slot), runtime::WakeSource::Channel);
+        slot.reset();
+    }
+
+    void Http2Connection::wake_unlock(runtime::Goroutine::Ptr &slot) {
+        runtime::Goroutine::Ptr g = std::move(slot);
+        lock_.unlock();
+        if (g) runtime::Scheduler::get().push_ready(std::move(g), runtime::WakeSource::Channel);
+    }
+
+    void Http2Connection::wake_streams() {
+        for (auto &kv: streams_) wake(kv.second->waiter);
+    }
+
+    void Http2Connection::append_frame_header(size_t len, uint8_t type, uint8_t flags, uint32_t sid) {
+        char h[kFrameHeader] = {
+            char(len >> 16), char(len >> 8), char(len), char(type), char(flags),
+            char((sid >> 24) & 0x7F), char(sid >> 16), char(sid >> 8), char(sid)
+        };
+        out_.append(h, kFrameHeader);
+    }
+
+    void Http2Connection::serve(ReadBuffer &in) {
+        guard_->enter(); // 连接协程自己
+        start();
+        read_loop(in);
+        finish();
+    }
+
+    bool Http2Connection::serve_upgrade(WebContext &ctx) {
+        Request &req = ctx.req_;
+        std::string settings;
+        if (!base64url_decode(req.get_header("HTTP2-Settings"), settings) || settings.size() % 6 != 0
+            || !apply_settings(settings)) {
+            return false;
+        }
+
+        // 升级请求本身成为流 1，已经是半关闭（客户端不会再发 Body）
+        auto st = std::make_shared<Stream>();
+        st->id = 1;
+        st->recv_window = engine_.config().h2_stream_window;
+        st->send_window = peer_initial_window_;
+        st->headers.emplace_back(":method", std::string(req.method));
+        st->headers.emplace_back(":path", std::string(req.parser_.target().in(req.raw_data_.view())));
+        st->headers.emplace_back(":scheme", "http");
+        req.headers.for_each([&st](std::string_view name, std::string_view value) {
+            std::string lower(name);
+            to_lower(lower);
+            if (hop_by_hop(lower) || lower == "http2-settings") return;
+            st->headers.emplace_back(std::move(lower), std::string(value));
+        });
+
+        ctx.out_.push_static("HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n");
+        if (!ctx.flush()) return true;
+        req.raw_data_.consume(req.header_size);
+
+        last_stream_ = 1;
+        streams_[1] = st;
+        guard_->enter(); // 连接协程
+        guard_->enter(); // 流 1
+        start(); // 服务端的 SETTINGS 必须是 101 之后的第一个帧
+        dispatch(st);
+        read_loop(req.raw_data_);
+        finish();
+        return true;
+    }
+
+    void Http2Connection::start() {
+        const EngineConfig &cfg = engine_.config();
+        std::string settings;
+        put_setting(settings, 0x3, cfg.h2_max_streams); // MAX_CONCURRENT_STREAMS
+        put_setting(settings, 0x4, cfg.h2_stream_window); // INITIAL_WINDOW_SIZE
+        send_frame(kSettings, 0, 0, settings);
+        // 连接级窗口只能靠 WINDOW_UPDATE 调大
+        std::string inc;
+        put32(inc, static_cast<uint32_t>(kConnWindow - 65535));
+        send_frame(kWindowUpdate, 0, 0, inc);
+
+        runtime::go([this]() { write_loop(); });
+
+        // 排空与空闲超时不直接断开，改为先发 GOAWAY，让已经开始的流处理完
+        guard_->lock.lock();
+        guard_->on_drain = [this]() { go_away(); };
+        guard_->lock.unlock();
+    }
+
+    void Http2Connection::go_away() {
+        lock_.lock();
+        if (going_away_ || closing_) {
+            lock_.unlock();
+            return;
+        }
+        going_away_ = true;
+        // 编号不超过 last_stream_ 的流照常处理，之后的新流一律拒绝，客户端可以换连接重试
+        std::string payload;
+        put32(payload, last_stream_);
+        put32(payload, kNoError);
+        append_frame_header(payload.size(), kGoaway, 0, 0);
+        out_.append(payload);
+        wake(writer_waiter_);
+        stop_reading_if_done();
+        lock_.unlock();
+    }
+
+    void Http2Connection::stop_reading_if_done() {
+        if (!going_away_ || !streams_.empty() || read_shut_.load(std::memory_order_relaxed)) return;
+        // 只关读方向：挂在 netpoller 上的连接协程读到 EOF 退出，写协程照常把 GOAWAY 和剩余的帧写完
+        read_shut_.store(true, std::memory_order_relaxed);
+        ::shutdown(fd_, SHUT_RD);
+    }
+
+    bool Http2Connection::read_more(ReadBuffer &in) {
+        while (true) {
+            ssize_t n = in.read_from(fd_);
+            if (n > 0) return true;
+            if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                // 等数据期间不算忙：没有打开的流时，空闲超时和排空都能收回这个连接
+                guard_->leave();
+                auto g = runtime::Goroutine::current();
+                int fd = fd_;
+                runtime::Goroutine::park(runtime::ParkReason::NetRead, [fd, g]() {
+                    runtime::Netpoller::get().watch_read_web(fd, g);
+                });
+                guard_->enter();
+            } else if (n == 0 || errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    void Http2Connection::read_loop(ReadBuffer &in) {
+        while (in.size() < kPreface.size()) {
+            if (!read_more(in)) return;
+        }
+        if (in.view().substr(0, kPreface.size()) != kPreface) {
+            fail(kProtocolError);
+            return;
+        }
+        in.consume(kPreface.size());
+
+        while (true) {
+            while (in.size() < kFrameHeader) {
+                if (!read_more(in)) return;
+            }
+            // 读更多数据可能让缓冲区搬家，帧头先解出来
+            const auto *h = reinterpret_cast<const uint8_t *>(in.data());
+            size_t len = (size_t(h[0]) << 16) | (size_t(h[1]) << 8) | size_t(h[2]);
+            uint8_t type = h[3];
+            uint8_t flags = h[4];
+            uint32_t sid = get32(in.data() + 5) & 0x7FFFFFFF;
+            if (len > kMaxFrame) {
+                fail(kFrameSizeError);
+                return;
+            }
+            while (in.size() < kFrameHeader + len) {
+                if (!read_more(in)) return;
+            }
+            bool ok = handle_frame(type, flags, sid, std::string_view(in.data() + kFrameHeader, len));
+            in.consume(kFrameHeader + len);
+            // 发过 GOAWAY 且流都处理完了：缓冲区里剩下的帧不再读
+            if (!ok || read_shut_.load(std::memory_order_relaxed)) return;
+        }
+    }
+
+    void Http2Connection::finish() {
+        // 之后排空不会再调到本对象；本对象在调用方关闭 fd 之前销毁
+        guard_->lock.lock();
+        guard_->on_drain = nullptr;
+        guard_->lock.unlock();
+
+        if (error_ != kNoError) {
+            std::string payload;
+            put32(payload, last_stream_);
+            put32(payload, error_);
+            send_frame(kGoaway, 0, 0, payload);
+        }
+
+        // 读循环结束后不会再有 WINDOW_UPDATE，还在等窗口的流直接放弃
+        lock_.lock();
+        for (auto &kv: streams_) kv.second->reset = true;
+        wake_streams();
+        lock_.unlock();
+        wait(finish_waiter_, runtime::ParkReason::WaitGroup, [this] { return active_ == 0; });
+
+        // 流都结束之后写协程把剩余的帧写完再退出；连接由调用方关闭
+        lock_.lock();
+        closing_ = true;
+        wake(writer_waiter_);
+        lock_.unlock();
+        wait(finish_waiter_, runtime::ParkReason::WaitGroup, [this] { return writer_done_; });
+    }
+
+    bool Http2Connection::handle_frame(uint8_t type, uint8_t flags, uint32_t sid, std::string_view payload) {
+        // 一个 header block 的 CONTINUATION 之间不允许夹杂其他帧
+        if (cont_stream_ != 0 && (type != kContinuation || sid != cont_stream_)) return fail(kProtocolError);
+
+        switch (type) {
+            case kData:
+                return on_data(flags, sid, payload);
+            case kHeaders:
+                return on_headers(flags, sid, payload);
+            case kContinuation:
+                if (cont_stream_ == 0) return fail(kProtocolError);
+                cont_block_.append(payload.data(), payload.size());
+                if (cont_block_.size() > kMaxHeaderBlock) return fail(kEnhanceYourCalm);
+                if (flags & kEndHeaders) {
+                    uint32_t id = cont_stream_;
+                    cont_stream_ = 0;
+                    return on_header_block(id, cont_end_stream_);
+                }
+                return true;
+            case kPriority:
+                // 优先级不做调度，只校验格式
+                if (sid == 0) return fail(kProtocolError);
+                if (payload.size() != 5) reset_stream(sid, kFrameSizeError);
+                return true;
+            case kRstStream:
+                return on_rst_stream(sid, payload);
+            case kSettings:
+                return on_settings(flags, sid, payload);
+            case kPushPromise:
+                return fail(kProtocolError); // 客户端不能推送
+            case kPing:
+                if (sid != 0) return fail(kProtocolError);
+                if (payload.size() != 8) return fail(kFrameSizeError);
+                if (!(flags & kAck)) send_frame(kPing, kAck, 0, payload);
+                return true;
+            case kGoaway:
+                // 对端不再发起新流，已经在处理的流照常完成
+                return sid == 0 || fail(kProtocolError);
+            case kWindowUpdate:
+                return on_window_update(sid, payload);
+            default:
+                return true; // 未知帧类型必须忽略
+        }
+    }
+
+    bool Http2Connection::on_headers(uint8_t flags, uint32_t sid, std::string_view payload) {
+        if (sid == 0 || (sid & 1) == 0) return fail(kProtocolError);
+        if (!strip_padding(flags, payload)) return fail(kProtocolError);
+        if (flags & kPriorityFlag) {
+            if (payload.size() < 5) return fail(kFrameSizeError);
+            payload.remove_prefix(5);
+        }
+        cont_block_.assign(payload.data(), payload.size());
+        if (!(flags & kEndHeaders)) {
+            cont_stream_ = sid;
+            cont_end_stream_ = (flags & kEndStream) != 0;
+            return true;
+        }
+        return on_header_block(sid, (flags & kEndStream) != 0);
+    }
+
+    bool Http2Connection::on_header_block(uint32_t sid, bool end_stream) {
+        // 即使要拒绝这个流也必须解码，否则动态表会和对端不同步
+        HeaderList fields;
+        bool decoded = decoder_.decode(cont_block_, fields);
+        cont_block_.clear();
+        if (!decoded) return fail(kCompressionError);
+
+        if (sid <= last_stream_) {
+            // 已有流上的第二个 HEADERS 只能是结束请求的 trailer，内容忽略
+            lock_.lock();
+            auto it = streams_.find(sid);
+            std::shared_ptr<Stream> st = it == streams_.end() ? nullptr : it->second;
+            lock_.unlock();
+            if (!st) return on_closed_stream(sid);
+            if (st->dispatched) {
+                // 请求已经结束（半关闭）还收到 HEADERS：只是这个流的错误，不影响连接上的其他流
+                reset_stream(sid, kStreamClosed);
+                return true;
+            }
+            if (!end_stream) return fail(kProtocolError);
+            dispatch(st);
+            return true;
+        }
+        const EngineConfig &cfg = engine_.config();
+        lock_.lock();
+        // 与 go_away 在同一把锁下：GOAWAY 里的编号要么包含这个流，要么这里看到 going_away_ 拒绝它
+        last_stream_ = sid;
+        bool refuse = going_away_ || streams_.size() >= cfg.h2_max_streams;
+        lock_.unlock();
+        if (refuse) {
+            reset_stream(sid, kRefusedStream);
+            return true;
+        }
+
+        bool has_method = false;
+        bool has_path = false;
+        for (const auto &f: fields) {
+            if (f.first == ":method") has_method = true;
+            else if (f.first == ":path") has_path = !f.second.empty();
+        }
+        if (!has_method || !has_path) {
+            reset_stream(sid, kProtocolError);
+            return true;
+        }
+
+        auto st = std::make_shared<Stream>();
+        st->id = sid;
+        st->headers = std::move(fields);
+        st->recv_window = cfg.h2_stream_window;
+        lock_.lock();
+        st->send_window = peer_initial_window_;
+        streams_[sid] = st;
+        lock_.unlock();
+        guard_->enter();
+        if (end_stream) dispatch(st);
+        return true;
+    }
+
+    bool Http2Connection::on_data(uint8_t flags, uint32_t sid, std::string_view payload) {
+        if (sid == 0) return fail(kProtocolError);
+
+        // 流量控制按整个帧（含填充）计算；连接级窗口消耗过半就补满
+        auto len = static_cast<int64_t>(payload.size());
+        conn_recv_window_ -= len;
+        if (conn_recv_window_ < 0) return fail(kFlowControlError);
+        if (conn_recv_window_ <= kConnWindow / 2) {
+            std::string inc;
+            put32(inc, static_cast<uint32_t>(kConnWindow - conn_recv_window_));
+            send_frame(kWindowUpdate, 0, 0, inc);
+            conn_recv_window_ = kConnWindow;
+        }
+        if (!strip_padding(flags, payload)) return fail(kProtocolError);
+
+        lock_.lock();
+        auto it = streams_.find(sid);
+        std::shared_ptr<Stream> st = it == streams_.end() ? nullptr : it->second;
+        lock_.unlock();
+        if (!st) return sid <= last_stream_ ? on_closed_stream(sid) : fail(kProtocolError);
+        if (st->dispatched) {
+            reset_stream(sid, kStreamClosed);
+            return true;
+        }
+
+        st->recv_window -= len;
+        if (st->recv_window < 0) {
+            reset_stream(sid, kFlowControlError);
+            return true;
+        }
+        if (st->body.size() + payload.size() > kMaxBody) {
+            reset_stream(sid, kCancel);
+            return true;
+        }
+        st->body.append(payload.data(), payload.size());
+
+        if (flags & kEndStream) {
+            dispatch(st);
+        } else if (st->recv_window <= static_cast<int64_t>(engine_.config().h2_stream_window) / 2) {
+            std::string inc;
+            put32(inc, static_cast<uint32_t>(engine_.config().h2_stream_window - st->recv_window));
+            send_frame(kWindowUpdate, 0, sid, inc);
+            st->recv_window = engine_.config().h2_stream_window;
+        }
+        return true;
+    }
+
+    bool Http2Connection::on_settings(uint8_t flags, uint32_t sid, std::string_view payload) {
+        if (sid != 0) return fail(kProtocolError);
+        if (flags & kAck) return payload.empty() || fail(kFrameSizeError);
+        if (payload.size() % 6 != 0) return fail(kFrameSizeError);
+        if (!apply_settings(payload)) return false;
+        send_frame(kSettings, kAck, 0, {});
+        return true;
+    }
+
+    bool Http2Connection::apply_settings(std::string_view payload) {
+        for (size_t i = 0; i + 6 <= payload.size(); i += 6) {
+            uint16_t id = static_cast<uint16_t>((uint8_t(payload[i]) << 8) | uint8_t(payload[i + 1]));
+            uint32_t v = get32(payload.data() + i + 2);
+            switch (id) {
+                case 0x1: // HEADER_TABLE_SIZE
+                    lock_.lock();
+                    encoder_.set_max_table_size(v);
+                    lock_.unlock();
+                    break;
+                case 0x2: // ENABLE_PUSH，我们从不推送
+                    if (v > 1) return fail(kProtocolError);
+                    break;
+                case 0x4: { // INITIAL_WINDOW_SIZE：差值作用到所有已打开的流
+                    if (v > kMaxWindow) return fail(kFlowControlError);
+                    lock_.lock();
+                    int64_t delta = static_cast<int64_t>(v) - peer_initial_window_;
+                    peer_initial_window_ = v;
+                    for (auto &kv: streams_) kv.second->send_window += delta;
+                    wake_streams();
+                    lock_.unlock();
+                    break;
+                }
+                case 0x5: // MAX_FRAME_SIZE
+                    if (v < 16384 || v > 16777215) return fail(kProtocolError);
+                    lock_.lock();
+                    peer_max_frame_ = v;
+                    lock_.unlock();
+                    break;
+                default:
+                    break; // 未知参数必须忽略
+            }
+        }
+        return true;
+    }
+
+    bool Http2Connection::on_window_update(uint32_t sid, std::string_view payload) {
+        if (payload.size() != 4) return fail(kFrameSizeError);
+        uint32_t inc = get32(payload.data()) & 0x7FFFFFFF;
+        if (sid == 0) {
+            if (inc == 0) return fail(kProtocolError);
+            lock_.lock();
+            conn_send_window_ += inc;
+            bool overflow = conn_send_window_ > kMaxWindow;
+            wake_streams();
+            lock_.unlock();
+            return !overflow || fail(kFlowControlError);
+        }
+        if (inc == 0) {
+            reset_stream(sid, kProtocolError);
+            return true;
+        }
+        bool overflow = false;
+        lock_.lock();
+        auto it = streams_.find(sid);
+        if (it != streams_.end()) {
+            it->second->send_window += inc;
+            overflow = it->second->send_window > kMaxWindow;
+            wake(it->second->waiter);
+        }
+        lock_.unlock();
+        if (overflow) reset_stream(sid, kFlowControlError);
+        return true;
+    }
+
+    bool Http2Connection::on_rst_stream(uint32_t sid, std::string_view payload) {
+        if (sid == 0 || sid > last_stream_) return fail(kProtocolError);
+        if (payload.size() != 4) return fail(kFrameSizeError);
+        bool erased = false;
+        lock_.lock();
+        auto it = streams_.find(sid);
+        if (it != streams_.end()) {
+            if (!it->second->reset) remember_closed(sid, ClosedBy::ResetReceived);
+            // 已分发的流由自己的协程在结束时移除，Handler 之后的写入都会失败
+            it->second->reset = true;
+            wake(it->second->waiter);
+            if (!it->second->dispatched) {
+                streams_.erase(it);
+                stop_reading_if_done();
+                erased = true;
+            }
+        }
+        lock_.unlock();
+        if (erased) guard_->leave();
+        return true;
+    }
+
+    bool Http2Connection::on_closed_stream(uint32_t sid) {
+        lock_.lock();
+        ClosedBy how = ClosedBy::Unknown;
+        for (const ClosedStream &c: closed_) {
+            // 同一个流可能记了两次（对端重置后我们又回了 RST_STREAM），以我们发过的为准
+            if (c.id == sid && how != ClosedBy::ResetSent) how = c.how;
+        }
+        // 历史里没有、又比挤掉的编号都大：这个编号从来没有打开过，是对端把编号往回用了
+        bool never_opened = how == ClosedBy::Unknown && sid > closed_forgotten_;
+        lock_.unlock();
+
+        if (never_opened) return fail(kProtocolError); // §5.1.1
+        switch (how) {
+            case ClosedBy::ResetSent:
+                // 对端在收到我们的 RST_STREAM 之前发出的帧直接丢弃（§5.4.2）
+                return true;
+            case ClosedBy::ResetReceived:
+                // 对端自己重置了流还继续发：流错误（§5.1）
+                reset_stream(sid, kStreamClosed);
+                return true;
+            default:
+                // 两端都结束了的流又收到帧：连接错误（§5.1）
+                return fail(kStreamClosed);
+        }
+    }
+
+    void Http2Connection::dispatch(const std::shared_ptr<Stream> &st) {
+        lock_.lock();
+        st->dispatched = true;
+        ++active_;
+        lock_.unlock();
+        runtime::go([this, st]() { run_stream(st); });
+    }
+
+    void Http2Connection::run_stream(const std::shared_ptr<Stream> &st) {
+        {
+            // 请求视图指向流自己的 HeaderList 与 Body，协程结束前不会变
+            WebContext ctx(fd_);
+            Request &req = ctx.req_;
+            std::string_view target;
+            for (const auto &f: st->headers) {
+                std::string_view name = f.first;
+                if (name == ":method") {
+                    req.method = f.second;
+                } else if (name == ":path") {
+                    target = f.second;
+                } else if (name == ":authority") {
+                    req.headers.add("host", f.second);
+                } else if (name == "cookie") {
+                    if (!st->cookie.empty()) st->cookie.append("; ");
+                    st->cookie.append(f.second);
+                } else if (name.front() != ':') {
+                    req.headers.add(name, f.second);
+                }
+            }
+            if (!st->cookie.empty()) req.headers.add("cookie", st->cookie);
+            req.version = "HTTP/2.0";
+            size_t q = target.find('?');
+            req.path = target.substr(0, q);
+            if (q != std::string_view::npos) req.parse_query_string(target.substr(q + 1));
+            req.body = st->body;
+            req.content_length = st->body.size();
+            req.parse_body();
+
+            ResponseWriter writer(*this, st);
+            ctx.out_.redirect([&writer](OutputQueue &out) { return writer.take(out); });
+            // 流协程排队太久同样直接 503，连接上的其他流不受影响
+            if (engine_.over_queue_budget()) {
+                Engine::reject_overloaded(ctx);
+            } else {
+                engine_.serve_request(ctx, true);
+            }
+            writer.finish(ctx.out_);
+        }
+
+        // 唤醒 finish 之后本对象随时可能销毁，guard 先拷一份
+        std::shared_ptr<detail::IdleGuard> guard = guard_;
+        lock_.lock();
+        if (!st->reset) remember_closed(st->id, ClosedBy::Finished);
+        streams_.erase(st->id);
+        stop_reading_if_done();
+        if (--active_ == 0) {
+            wake_unlock(finish_waiter_);
+        } else {
+            lock_.unlock();
+        }
+        guard->leave();
+    }
+
+    void Http2Connection::send_frame(uint8_t type, uint8_t flags, uint32_t sid, std::string_view payload) {
+        lock_.lock();
+        append_frame_header(payload.size(), type, flags, sid);
+        out_.append(payload.data(), payload.size());
+        wake(writer_waiter_);
+        lock_.unlock();
+    }
+
+    void Http2Connection::reset_stream(uint32_t sid, uint32_t code) {
+        bool erased = false;
+        lock_.lock();
+        auto it = streams_.find(sid);
+        if (it != streams_.end()) {
+            if (it->second->reset) {
+                lock_.unlock();
+                return;
+            }
+            it->second->reset = true;
+            wake(it->second->waiter);
+            if (!it->second->dispatched) {
+                streams_.erase(it);
+                stop_reading_if_done();
+                erased = true;
+            }
+        }
+        remember_closed(sid, ClosedBy::ResetSent);
+        append_frame_header(4, kRstStream, 0, sid);
+        put32(out_, code);
+        wake(writer_waiter_);
+        lock_.unlock();
+        if (erased) guard_->leave();
+    }
+
+    void Http2Connection::remember_closed(uint32_t sid, ClosedBy how) {
+        ClosedStream &slot = closed_[closed_next_++ % kClosedHistory];
+        closed_forgotten_ = std::max(closed_forgotten_, slot.id);
+        slot.id = sid;
+        slot.how = how;
+    }
+
+    bool Http2Connection::send_headers(Stream &st, int status, const HeaderList &fields, bool end_stream) {
+        auto ready = [this, &st] { return out_.size() < kMaxPending || broken_ || st.reset; };
+        wait(st.waiter, runtime::ParkReason::NetWrite, ready);
+
+        lock_.lock();
+        if (broken_ || st.reset) {
+            lock_.unlock();
+            return false;
+        }
+        std::string block;
+        encoder_.encode_status(status, block);
+        for (const auto &f: fields) encoder_.encode(f.first, f.second, block);
+
+        // 超过对端最大帧长的 header block 拆成 HEADERS + CONTINUATION，中间不能插入其他帧
+        size_t pos = 0;
+        do {
+            size_t n = std::min(block.size() - pos, peer_max_frame_);
+            uint8_t flags = pos + n == block.size() ? kEndHeaders : 0;
+            if (pos == 0 && end_stream) flags |= kEndStream;
+            append_frame_header(n, pos == 0 ? kHeaders : kContinuation, flags, st.id);
+            out_.append(block, pos, n);
+            pos += n;
+        } while (pos < block.size());
+        wake(writer_waiter_);
+        lock_.unlock();
+        return true;
+    }
+
+    bool Http2Connection::send_data(Stream &st, std::string_view data, bool end_stream) {
+        if (data.empty() && !end_stream) return true;
+        // 空的结束帧不占窗口
+        auto ready = [this, &st, &data] {
+            if (broken_ || st.reset) return true;
+            return out_.size() < kMaxPending
+                   && (data.empty() || std::min(conn_send_window_, st.send_window) > 0);
+        };
+
+        while (true) {
+            wait(st.waiter, runtime::ParkReason::NetWrite, ready);
+            lock_.lock();
+            if (broken_ || st.reset) {
+                lock_.unlock();
+                return false;
+            }
+            // 一次尽量多发，直到窗口或写缓冲用完
+            while (out_.size() < kMaxPending) {
+                int64_t window = std::min(conn_send_window_, st.send_window);
+                if (!data.empty() && window <= 0) break;
+                size_t n = std::min({data.size(), peer_max_frame_, static_cast<size_t>(std::max<int64_t>(window, 0))});
+                bool last = end_stream && n == data.size();
+                append_frame_header(n, kData, last ? kEndStream : 0, st.id);
+                out_.append(data.data(), n);
+                conn_send_window_ -= static_cast<int64_t>(n);
+                st.send_window -= static_cast<int64_t>(n);
+                data.remove_prefix(n);
+                if (data.empty()) {
+                    wake(writer_waiter_);
+                    lock_.unlock();
+                    // 不带 END_STREAM 时到这里已经全部发完；带的话 last 一定为真
+                    return true;
+                }
+            }
+            wake(writer_waiter_);
+            lock_.unlock();
+        }
+    }
+
+    void Http2Connection::write_loop() {
+        OutputQueue q;
+        lock_.lock();
+        while (true) {
+            if (out_.empty() || broken_) {
+                out_.clear();
+                if (closing_) break;
+                lock_.unlock();
+                wait(writer_waiter_, runtime::ParkReason::Channel,
+                     [this] { return (!out_.empty() && !broken_) || closing_; });
+                lock_.lock();
+                continue;
+            }
+            // 所有流攒下的帧整批取走，一次写出
+            bool was_full = out_.size() >= kMaxPending;
+            q.push(std::move(out_));
+            out_.clear();
+            if (was_full) wake_streams();
+            lock_.unlock();
+            bool ok = q.flush(fd_);
+            lock_.lock();
+            if (!ok) {
+                broken_ = true;
+                wake_streams();
+            }
+        }
+        writer_done_ = true;
+        wake_unlock(finish_waiter_);
+    }
+}
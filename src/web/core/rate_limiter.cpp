@@ -0,0 +1,200 @@
+#include "web/core/rate_limiter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <string_view>
+#include <time.h>
+
+#include "runtime/context/web_context.h"
+#include "runtime/tracer.h"
+
+namespace gee {
+    namespace {
+        constexpr uint64_t kTokenMask = (1ull << 24) - 1;
+        constexpr uint64_t kOneToken = 256;
+        constexpr uint32_t kMaxBurst = static_cast<uint32_t>(kTokenMask / kOneToken);
+
+        // splitmix64 的收尾，让低位也分布均匀（表下标取低位）
+        uint64_t mix(uint64_t x) {
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ull;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebull;
+            x ^= x >> 31;
+            return x;
+        }
+
+        // 每个请求都要读一次时钟，steady_clock 在部分虚拟机上要几十 ns；
+        // 粗粒度时钟只读内核维护的时间戳，精度为一个 tick（1~4 ms），对限流足够
+        int64_t coarse_now_ns() {
+#if defined(CLOCK_MONOTONIC_COARSE)
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+            return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#elif defined(__APPLE__)
+            return static_cast<int64_t>(clock_gettime_nsec_np(CLOCK_UPTIME_RAW_APPROX));
+#else
+            return runtime::trace_now_ns();
+#endif
+        }
+    }
+
+    RateLimiter::RateLimiter(RateLimiterConfig config) : config_(std::move(config)) {
+        config_.rate = std::max(config_.rate, 0.001);
+        config_.burst = std::clamp<uint32_t>(config_.burst, 1, kMaxBurst);
+
+        size_t lines = 1;
+        while (lines * kWays < config_.max_keys) lines <<= 1;
+        lines_ = std::make_unique<Line[]>(lines);
+        line_mask_ = lines - 1;
+        epoch_ns_ = coarse_now_ns();
+
+        capacity_q8_ = static_cast<uint64_t>(config_.burst) * kOneToken;
+        refill_q24_per_ms_ = std::max<uint64_t>(
+            1, static_cast<uint64_t>(std::ceil(config_.rate * kOneToken / 1000 * 65536)));
+        full_ms_ = (capacity_q8_ << 16) / refill_q24_per_ms_ + 1;
+
+        interval_us_ = std::max<uint64_t>(1, static_cast<uint64_t>(1e6 / config_.rate));
+        tolerance_us_ = interval_us_ * (config_.burst - 1);
+
+        auto retry = static_cast<uint64_t>(std::ceil(1.0 / config_.rate));
+        retry_after_ = "Retry-After: " + std::to_string(std::max<uint64_t>(retry, 1)) + "\r\n";
+    }
+
+    uint64_t RateLimiter::now_us() const {
+        return static_cast<uint64_t>(coarse_now_ns() - epoch_ns_) / 1000;
+    }
+
+    uint64_t RateLimiter::fresh_state(uint64_t now_us) const {
+        if (config_.algorithm == RateLimitAlgorithm::GCRA) return now_us;
+        return ((now_us / 1000) << 24) | capacity_q8_;
+    }
+
+    bool RateLimiter::step(uint64_t state, uint64_t now_us, uint64_t &next) const {
+        if (config_.algorithm == RateLimitAlgorithm::GCRA) {
+            uint64_t tat = std::max(state, now_us);
+            if (tat - now_us > tolerance_us_) {
+                next = state;
+                return false;
+            }
+            next = tat + interval_us_;
+            return true;
+        }
+
+        uint64_t refilled = refill(state, now_us);
+        bool ok = (refilled & kTokenMask) >= kOneToken;
+        next = ok ? refilled - kOneToken : refilled;
+        return ok;
+    }
+
+    uint64_t RateLimiter::refill(uint64_t state, uint64_t now_us) const {
+        uint64_t now_ms = now_us / 1000;
+        uint64_t last = state >> 24;
+        if (now_ms <= last) return state;
+        uint64_t elapsed = now_ms - last;
+        uint64_t add = elapsed >= full_ms_ ? capacity_q8_ : (elapsed * refill_q24_per_ms_) >> 16;
+        // 不足 1/256 个令牌时不推进时间戳，慢速率下的零头不会丢
+        if (add == 0) return state;
+        uint64_t tokens = std::min(capacity_q8_, (state & kTokenMask) + add);
+        return (now_ms << 24) | tokens;
+    }
+
+    bool RateLimiter::idle(uint64_t state, uint64_t now_us, uint64_t &slack) const {
+        if (config_.algorithm == RateLimitAlgorithm::GCRA) {
+            slack = state <= now_us ? UINT64_MAX : UINT64_MAX - (state - now_us);
+            return state <= now_us;
+        }
+        slack = refill(state, now_us) & kTokenMask;
+        return slack >= capacity_q8_;
+    }
+
+    bool RateLimiter::take(Slot &slot, uint64_t now_us) {
+        uint64_t s = slot.state.load(std::memory_order_relaxed);
+        while (true) {
+            uint64_t next;
+            bool ok = step(s, now_us, next);
+            // 被拒绝且状态没变（持续超限的客户端）不写内存，不和其他线程抢这条缓存行
+            if (next == s) return ok;
+            if (slot.state.compare_exchange_weak(s, next, std::memory_order_relaxed)) return ok;
+        }
+    }
+
+    void RateLimiter::claim(Slot &slot, uint64_t seen, uint64_t now_us) {
+        // 只从换主人之前看到的状态 CAS 过去：换键与写初始状态之间已经有请求在这个槽上取过令牌时，
+        // 保留那次更新、在它的基础上继续，不会把它覆盖掉
+        slot.state.compare_exchange_strong(seen, fresh_state(now_us), std::memory_order_relaxed);
+    }
+
+    bool RateLimiter::allow(uint64_t key_hash, uint64_t now_us) {
+        if (key_hash == 0) key_hash = 1;
+        Line &line = lines_[key_hash & line_mask_];
+
+        Slot *victim = nullptr;
+        uint64_t victim_key = 0;
+        uint64_t victim_state = 0;
+        uint64_t victim_slack = 0;
+        bool victim_idle = false;
+        for (Slot &slot: line.ways) {
+            uint64_t k = slot.key.load(std::memory_order_acquire);
+            if (k == key_hash) return take(slot, now_us);
+            if (k == 0) {
+                // 空槽的状态从没被写过，一定还是 0
+                if (slot.key.compare_exchange_strong(k, key_hash, std::memory_order_acq_rel)) {
+                    claim(slot, 0, now_us);
+                    return take(slot, now_us);
+                }
+                if (k == key_hash) return take(slot, now_us);
+            }
+            // 状态要在换键之前读：claim 据此判断换键之后有没有别人动过这个槽
+            uint64_t s = slot.state.load(std::memory_order_acquire);
+            uint64_t slack;
+            bool is_idle = idle(s, now_us, slack);
+            if (!victim || slack > victim_slack) {
+                victim = &slot;
+                victim_key = k;
+                victim_state = s;
+                victim_slack = slack;
+                victim_idle = is_idle;
+            }
+        }
+
+        // 四个槽都被别的键占着：换掉最接近回满的那个
+        if (victim->key.compare_exchange_strong(victim_key, key_hash, std::memory_order_acq_rel)) {
+            if (!victim_idle) evictions_.fetch_add(1, std::memory_order_relaxed);
+            claim(*victim, victim_state, now_us);
+            return take(*victim, now_us);
+        }
+        // 同时有别的线程在换这个槽：放行，宁可偶尔多放一个也不阻塞
+        return true;
+    }
+
+    uint64_t RateLimiter::key_hash(WebContext *c) const {
+        uint64_t h = 0;
+        if (config_.key != RateLimitKey::Route) {
+            std::string_view k;
+            if (config_.key == RateLimitKey::Header) k = c->req_.get_header(config_.header);
+            if (k.empty()) k = c->ClientIP();
+            h = std::hash<std::string_view>{}(k);
+        }
+        // 执行链在路由上预先拼好、地址固定，直接当作路由的标识
+        if (config_.per_route || config_.key == RateLimitKey::Route) {
+            h ^= mix(reinterpret_cast<uintptr_t>(c->handlers_));
+        }
+        return mix(h);
+    }
+
+    void RateLimiter::reject(WebContext *c) const {
+        static constexpr std::string_view kBody = R"({"state":429,"message":"Too Many Requests","data":{}})";
+        c->res_.write_head(c->out_, 429, gee::kJsonContentType, kBody.size(), retry_after_, kBody);
+        c->out_.end_response();
+        c->res_.is_sent = true;
+    }
+
+    void RateLimiter::handle(WebContext *c) {
+        if (allow(key_hash(c), now_us())) return;
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        reject(c);
+        c->Abort();
+    }
+}
@@ -0,0 +1,299 @@
+#include "web/core/response_cache.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <strings.h>
+#include <spdlog/spdlog.h>
+
+#include "runtime/context/web_context.h"
+#include "runtime/scheduler.h"
+#include "runtime/tracer.h"
+
+namespace gee {
+    namespace {
+        // 每个条目除键和响应字节之外的估算开销（哈希节点、LRU 节点、Entry、控制块）
+        constexpr size_t kNodeOverhead = 160;
+
+        void append_u32(std::string &key, size_t v) {
+            uint32_t n = static_cast<uint32_t>(v);
+            key.append(reinterpret_cast<const char *>(&n), sizeof(n));
+        }
+
+        // 带长度前缀，任意字节的查询参数和 Header 值拼在一起也不会产生歧义
+        void append_field(std::string &key, std::string_view v) {
+            append_u32(key, v.size());
+            key.append(v);
+        }
+
+        bool starts_with_icase(std::string_view line, std::string_view prefix) {
+            return line.size() >= prefix.size() && strncasecmp(line.data(), prefix.data(), prefix.size()) == 0;
+        }
+
+        // 后台重新生成用的请求副本：视图指向 head，不依赖原连接
+        struct Revalidation {
+            std::string head;
+            WebContext ctx{-1};
+        };
+    }
+
+    ResponseCache::ResponseCache(ResponseCacheConfig config) : config_(std::move(config)) {
+        if (config_.shards == 0) config_.shards = 1;
+        shard_capacity_ = config_.max_bytes / config_.shards;
+        shards_ = std::vector<Shard>(config_.shards);
+    }
+
+    std::string ResponseCache::make_key(WebContext *c) const {
+        const Request &req = c->req_;
+        std::string key;
+        key.reserve(req.path.size() + 64);
+        append_field(key, req.path);
+
+        // 查询参数按名字排序，?a=1&b=2 与 ?b=2&a=1 命中同一条
+        std::vector<const std::pair<const std::string, std::string> *> query;
+        query.reserve(req.query_params_.size());
+        for (const auto &kv: req.query_params_) query.push_back(&kv);
+        std::sort(query.begin(), query.end(), [](const auto *a, const auto *b) { return *a < *b; });
+        append_u32(key, query.size());
+        for (const auto *kv: query) {
+            append_field(key, kv->first);
+            append_field(key, kv->second);
+        }
+
+        for (const auto &name: config_.vary) append_field(key, req.get_header(name));
+        // 压缩与否、用哪种压缩，缓存的字节都不同
+        key.push_back(static_cast<char>(c->res_.encoding));
+        return key;
+    }
+
+    ResponseCache::Shard &ResponseCache::shard_for(const std::string &key) {
+        return shards_[std::hash<std::string>{}(key) % shards_.size()];
+    }
+
+    void ResponseCache::handle(WebContext *c) {
+        if (c->req_.method != "GET") return;
+
+        std::string key = make_key(c);
+        Shard &shard = shard_for(key);
+        int64_t now = runtime::trace_now_ns();
+
+        shard.lock.lock();
+        auto it = shard.map.find(key);
+        if (it != shard.map.end()) {
+            Node &node = it->second;
+            EntryPtr e = node.entry;
+            if (now < e->fresh_until_ns) {
+                shard.lru.splice(shard.lru.begin(), shard.lru, node.lru);
+                shard.lock.unlock();
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                serve(c, e, now);
+                c->Abort();
+                return;
+            }
+            if (now < e->stale_until_ns) {
+                // 先把旧响应发出去；第一个看到过期的请求另起协程重新生成，自己照常返回
+                bool refresh = !node.refreshing;
+                node.refreshing = true;
+                shard.lru.splice(shard.lru.begin(), shard.lru, node.lru);
+                shard.lock.unlock();
+                stale_hits_.fetch_add(1, std::memory_order_relaxed);
+                serve(c, e, now);
+                if (refresh) revalidate(c, key);
+                c->Abort();
+                return;
+            }
+            erase(shard, it);
+        }
+
+        auto fit = shard.flights.find(key);
+        if (fit != shard.flights.end()) {
+            // 同一个键正在生成：挂起等结果，不重复执行 Handler
+            std::shared_ptr<Flight> flight = fit->second;
+            shard.lock.unlock();
+            auto self = runtime::Goroutine::current();
+            // 切出之后再登记，完成方看到 waiter 才唤醒
+            runtime::Goroutine::park(runtime::ParkReason::Channel, [&shard, &flight, &self]() {
+                shard.lock.lock();
+                if (flight->done) {
+                    shard.lock.unlock();
+                    runtime::Scheduler::get().push_ready(self, runtime::WakeSource::Channel);
+                    return;
+                }
+                flight->waiters.push_back(self);
+                shard.lock.unlock();
+            });
+            if (flight->result) {
+                coalesced_.fetch_add(1, std::memory_order_relaxed);
+                serve(c, flight->result, runtime::trace_now_ns());
+                c->Abort();
+            }
+            // 结果不可缓存：返回后由执行链继续跑自己的 Handler
+            return;
+        }
+
+        auto flight = std::make_shared<Flight>();
+        shard.flights.emplace(key, flight);
+        shard.lock.unlock();
+        misses_.fetch_add(1, std::memory_order_relaxed);
+
+        size_t first = c->out_.size();
+        size_t responses = c->out_.responses();
+        EntryPtr e;
+        try {
+            c->Next();
+            e = capture(c, first, responses);
+        } catch (...) {
+            finish_flight(shard, key, flight, nullptr);
+            throw;
+        }
+        finish_flight(shard, key, flight, std::move(e));
+    }
+
+    void ResponseCache::finish_flight(Shard &shard, const std::string &key, const std::shared_ptr<Flight> &flight,
+                                      EntryPtr e) {
+        std::vector<runtime::Goroutine::Ptr> wake;
+        shard.lock.lock();
+        if (e) store(shard, key, e);
+        shard.flights.erase(key);
+        flight->result = std::move(e);
+        flight->done = true;
+        wake.swap(flight->waiters);
+        shard.lock.unlock();
+        for (auto &g: wake) runtime::Scheduler::get().push_ready(std::move(g), runtime::WakeSource::Channel);
+    }
+
+    ResponseCache::EntryPtr ResponseCache::capture(WebContext *c, size_t first_chunk, size_t responses) const {
+        // 只要一次写完、还在队列里的普通 200 响应；JSON(SERVER_ERROR, ...) 的 HTTP 状态也是 200，要看业务状态
+        if (c->stream_ || !c->res_.is_sent || c->res_.state != 200) return nullptr;
+        if (c->out_.responses() != responses + 1 || c->out_.size() <= first_chunk) return nullptr;
+
+        std::string raw;
+        if (!c->out_.copy_since(first_chunk, raw) || raw.size() > config_.max_entry_bytes) return nullptr;
+        if (raw.compare(0, 13, "HTTP/1.1 200 ") != 0) return nullptr;
+        size_t head_end = raw.find("\r\n\r\n");
+        if (head_end == std::string::npos) return nullptr;
+
+        auto e = std::make_shared<Entry>();
+        e->wire.reserve(raw.size());
+        // Connection 与 Date 随请求变化，命中时重新补上
+        size_t pos = 0;
+        while (pos < head_end + 2) {
+            size_t eol = raw.find("\r\n", pos) + 2;
+            std::string_view line(raw.data() + pos, eol - pos);
+            if (starts_with_icase(line, "Set-Cookie:")) return nullptr;
+            if (!starts_with_icase(line, "Connection:") && !starts_with_icase(line, "Date:")) e->wire.append(line);
+            pos = eol;
+        }
+        e->head_len = e->wire.size();
+        e->wire.append(raw, head_end + 4, std::string::npos);
+
+        e->created_ns = runtime::trace_now_ns();
+        e->fresh_until_ns = e->created_ns + static_cast<int64_t>(config_.ttl_ms) * 1000000;
+        e->stale_until_ns = e->fresh_until_ns + static_cast<int64_t>(std::max(config_.stale_ms, 0)) * 1000000;
+        return e;
+    }
+
+    void ResponseCache::revalidate(WebContext *c, const std::string &key) {
+        // 原请求马上就要回到连接循环被 reset，副本里的视图全部指向自己的存储
+        auto r = std::make_shared<Revalidation>();
+        WebContext &bg = r->ctx;
+        bg.req_.clone_header(c->req_, r->head);
+        bg.params_ = c->params_;
+        bg.params_.rebase(c->req_.path.data(), c->req_.path.size(), bg.req_.path.data());
+        bg.handlers_ = c->handlers_;
+        bg.index_ = c->index_;
+        bg.peer_ip_ = std::string(c->ClientIP());
+        // 压缩方式是缓存键的一部分，沿用原请求协商的结果
+        bg.res_.keep_alive = c->res_.keep_alive;
+        bg.res_.encoding = c->res_.encoding;
+        bg.res_.compress_level = c->res_.compress_level;
+        bg.res_.compress_min = c->res_.compress_min;
+        bg.res_.vary_encoding = c->res_.vary_encoding;
+
+        runtime::go([this, key, r]() {
+            EntryPtr fresh = regenerate(&r->ctx);
+            Shard &shard = shard_for(key);
+            shard.lock.lock();
+            if (fresh) {
+                store(shard, key, std::move(fresh));
+            } else if (auto cur = shard.map.find(key); cur != shard.map.end()) {
+                cur->second.refreshing = false;
+            }
+            shard.lock.unlock();
+        });
+    }
+
+    ResponseCache::EntryPtr ResponseCache::regenerate(WebContext *c) const {
+        // 后台上下文没有连接：任何 flush 都直接失败，响应只留在队列里
+        c->out_.redirect([](OutputQueue &) { return false; });
+
+        EntryPtr e;
+        try {
+            c->Next();
+            e = capture(c, 0, 0);
+        } catch (const std::exception &ex) {
+            spdlog::warn("ResponseCache: revalidating {} failed: {}", c->req_.path, ex.what());
+        } catch (...) {
+            spdlog::warn("ResponseCache: revalidating {} failed", c->req_.path);
+        }
+        return e;
+    }
+
+    void ResponseCache::serve(WebContext *c, const EntryPtr &e, int64_t now) const {
+        char age[32] = "Age: ";
+        int64_t secs = std::max<int64_t>(0, (now - e->created_ns) / 1000000000);
+        auto [end, ec] = std::to_chars(age + 5, age + sizeof(age) - 2, secs);
+        *end++ = '\r';
+        *end++ = '\n';
+        c->res_.write_cached(c->out_, std::string_view(e->wire.data(), e->head_len),
+                             std::string_view(e->wire.data() + e->head_len, e->wire.size() - e->head_len),
+                             std::string_view(age, end - age), e);
+        c->res_.is_sent = true;
+    }
+
+    void ResponseCache::store(Shard &shard, const std::string &key, EntryPtr e) {
+        auto old = shard.map.find(key);
+        if (old != shard.map.end()) erase(shard, old);
+
+        size_t charge = key.size() + e->wire.size() + kNodeOverhead;
+        if (charge > shard_capacity_) return;
+        // 按 LRU 淘汰到放得下为止
+        while (shard.bytes + charge > shard_capacity_ && !shard.lru.empty()) {
+            erase(shard, shard.map.find(*shard.lru.back()));
+        }
+
+        auto [it, inserted] = shard.map.emplace(key, Node{});
+        Node &node = it->second;
+        node.entry = std::move(e);
+        node.charge = charge;
+        shard.lru.push_front(&it->first);
+        node.lru = shard.lru.begin();
+        shard.bytes += charge;
+    }
+
+    void ResponseCache::erase(Shard &shard, std::unordered_map<std::string, Node>::iterator it) {
+        shard.bytes -= it->second.charge;
+        shard.lru.erase(it->second.lru);
+        shard.map.erase(it);
+    }
+
+    void ResponseCache::clear() {
+        for (Shard &shard: shards_) {
+            shard.lock.lock();
+            shard.map.clear();
+            shard.lru.clear();
+            shard.bytes = 0;
+            shard.lock.unlock();
+        }
+    }
+
+    size_t ResponseCache::bytes() const {
+        size_t total = 0;
+        for (const Shard &shard: shards_) {
+            shard.lock.lock();
+            total += shard.bytes;
+            shard.lock.unlock();
+        }
+        return total;
+    }
+}
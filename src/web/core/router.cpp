@@ -1,76 +1,216 @@
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <stdexcept>
+
 #include "web/core/gee.h"
+#include "web/core/router.h"
 
 
 namespace gee {
+    namespace {
+        // 去掉重复的 '/' 和结尾的 '/'，保持原 Trie 按段切分时 "/user/" 与 "/user" 等价的行为
+        std::string normalize_pattern(const std::string &pattern) {
+            std::string out;
+            out.reserve(pattern.size() + 1);
+            out.push_back('/');
+            for (char c: pattern) {
+                if (c == '/' && out.back() == '/') continue;
+                out.push_back(c);
+            }
+            if (out.size() > 1 && out.back() == '/') out.pop_back();
+            return out;
+        }
 
-    void Engine::add_route(std::string method, std::string path, HandlerFunc handler,
-                           std::vector<HandlerFunc> group_middlewares) {
-        std::vector<std::string> parts = parse_pattern(path);
+        // 静态片段到下一个 ':' 或 '*' 为止
+        size_t static_len(std::string_view pat) {
+            size_t n = pat.find_first_of(":*");
+            return n == std::string_view::npos ? pat.size() : n;
+        }
+    }
 
-        if (roots_.find(method) == roots_.end()) {
-            roots_[method] = new Node();
+    struct Router::Node {
+        enum class Kind { Static, Param, CatchAll };
+
+        Kind kind = Kind::Static;
+        std::string prefix; // Static：压缩后的字节串；Param/CatchAll：参数名
+        // 静态子节点首字节各不相同，indices 与 children 一一对应，匹配时先扫一遍首字节
+        std::string indices;
+        std::vector<std::unique_ptr<Node> > children;
+        std::vector<std::unique_ptr<Node> > params;
+        std::unique_ptr<Node> catch_all;
+        const Route *route = nullptr;
+    };
+
+    // n 为静态节点，pat 的开头要先和 n->prefix 对齐，必要时分裂 n
+    void Router::insert_static(Node *n, std::string_view pat, const Route *route) {
+        size_t limit = std::min(n->prefix.size(), static_len(pat));
+        size_t common = 0;
+        while (common < limit && n->prefix[common] == pat[common]) ++common;
+
+        if (common < n->prefix.size()) {
+            auto tail = std::make_unique<Node>();
+            tail->prefix = n->prefix.substr(common);
+            tail->indices = std::move(n->indices);
+            tail->children = std::move(n->children);
+            tail->params = std::move(n->params);
+            tail->catch_all = std::move(n->catch_all);
+            tail->route = n->route;
+
+            n->prefix.resize(common);
+            n->indices.assign(1, tail->prefix[0]);
+            n->children.clear();
+            n->children.push_back(std::move(tail));
+            n->params.clear();
+            n->catch_all.reset();
+            n->route = nullptr;
         }
-        roots_[method]->insert(path, parts, 0);
+        insert_children(n, pat.substr(common), route);
+    }
 
-        std::vector<HandlerFunc> chain;
+    // 把 pat 挂到 n 的子节点上，pat 位于 n 之后
+    void Router::insert_children(Node *n, std::string_view pat, const Route *route) {
+        using Kind = Node::Kind;
+        if (pat.empty()) {
+            // 与原实现一致：重复注册时后者覆盖前者
+            if (n->route) spdlog::warn("Route overridden: {} - {}", route->method, route->pattern);
+            n->route = route;
+            return;
+        }
 
-        chain.insert(chain.end(), group_middlewares.begin(), group_middlewares.end());
-        chain.push_back(std::move(handler));
+        if (pat[0] == ':') {
+            size_t end = pat.find('/');
+            std::string_view name = pat.substr(1, end == std::string_view::npos ? std::string_view::npos : end - 1);
+            if (name.empty()) throw std::invalid_argument("empty param name in route: " + route->pattern);
+            Node *child = nullptr;
+            for (auto &p: n->params) {
+                if (p->prefix == name) child = p.get();
+            }
+            if (!child) {
+                n->params.push_back(std::make_unique<Node>());
+                child = n->params.back().get();
+                child->kind = Kind::Param;
+                child->prefix = std::string(name);
+            }
+            insert_children(child, end == std::string_view::npos ? std::string_view() : pat.substr(end), route);
+            return;
+        }
+
+        if (pat[0] == '*') {
+            // 与原 parse_pattern 一致：'*' 段之后的内容忽略
+            size_t end = pat.find('/');
+            std::string_view name = pat.substr(1, end == std::string_view::npos ? std::string_view::npos : end - 1);
+            if (!n->catch_all) {
+                n->catch_all = std::make_unique<Node>();
+                n->catch_all->kind = Kind::CatchAll;
+                n->catch_all->prefix = std::string(name);
+            } else if (n->catch_all->prefix != name) {
+                throw std::invalid_argument("conflicting catch-all name in route: " + route->pattern);
+            }
+            insert_children(n->catch_all.get(), {}, route);
+            return;
+        }
 
-        std::string key = method + "-" + path;
-        route_handlers_chain_[key] = std::move(chain);
-        spdlog::info("Route registered: {} - {}", method, path);
+        size_t i = n->indices.find(pat[0]);
+        if (i == std::string::npos) {
+            auto child = std::make_unique<Node>();
+            child->prefix = std::string(pat.substr(0, static_len(pat)));
+            n->indices.push_back(pat[0]);
+            n->children.push_back(std::move(child));
+            i = n->children.size() - 1;
+        }
+        insert_static(n->children[i].get(), pat, route);
     }
 
+    // 匹配 n 之后的部分；优先级：静态 > :param > *catchall，失败时回溯并撤销已记录的参数
+    const Route *Router::match_children(const Node *n, std::string_view path, Params &params) {
+        if (path.empty()) return n->route;
 
-    std::vector<std::string> Engine::parse_pattern(std::string_view pattern) {
-        std::vector<std::string> parts;
-        std::string current;
+        size_t i = n->indices.find(path[0]);
+        if (i != std::string::npos) {
+            const Node *child = n->children[i].get();
+            if (path.size() >= child->prefix.size() &&
+                path.compare(0, child->prefix.size(), child->prefix) == 0) {
+                if (const Route *r = match_children(child, path.substr(child->prefix.size()), params)) return r;
+            }
+        }
 
-        for (char c: pattern) {
-            if (c == '/') {
-                if (!current.empty()) {
-                    parts.push_back(current);
-                    // 核心逻辑：如果是通配符，直接跳出循环
-                    if (current[0] == '*') return parts;
-                    current.clear();
+        if (!n->params.empty()) {
+            size_t end = path.find('/');
+            std::string_view seg = path.substr(0, end);
+            if (!seg.empty()) {
+                size_t mark = params.size();
+                for (auto &p: n->params) {
+                    if (!params.push(p->prefix, seg)) break;
+                    if (const Route *r = match_children(p.get(), path.substr(seg.size()), params)) return r;
+                    params.truncate(mark);
                 }
-            } else {
-                current += c;
             }
         }
 
-        // 处理最后一个片段
-        if (!current.empty()) {
-            parts.push_back(current);
+        if (n->catch_all && n->catch_all->route) {
+            params.push(n->catch_all->prefix, path);
+            return n->catch_all->route;
         }
+        return nullptr;
+    }
 
-        return parts;
+    Router::Router() = default;
+
+    Router::~Router() = default;
+
+    Router::Tree &Router::tree_of(const std::string &method) {
+        for (auto &t: trees_) {
+            if (t.method == method) return t;
+        }
+        trees_.push_back(Tree{method, std::make_unique<Node>(), {}});
+        return trees_.back();
     }
 
-    std::pair<Node *, std::unordered_map<std::string, std::string> >
-    Engine::get_route(const std::string &method, const std::string &path) {
-        // 1. 解析请求路径
-        std::vector<std::string> searchParts = parse_pattern(path);
-        std::unordered_map<std::string, std::string> params;
+    const Route *Router::add(const std::string &method, const std::string &pattern, HandlersChain chain) {
+        auto route = std::make_unique<Route>();
+        route->method = method;
+        route->pattern = normalize_pattern(pattern);
+        route->chain = std::move(chain);
 
-        // 2. 检查对应方法的根节点是否存在
-        auto it = roots_.find(method);
-        if (it == roots_.end()) {
-            return {nullptr, {}};
+        Tree &tree = tree_of(method);
+        insert_static(tree.root.get(), route->pattern, route.get());
+        if (route->pattern.find_first_of(":*") == std::string::npos) {
+            tree.statics.insert_or_assign(route->pattern, route.get());
         }
+        routes_.push_back(std::move(route));
+        return routes_.back().get();
+    }
 
-        Node *root = it->second;
+    const Route *Router::find(std::string_view method, std::string_view path, Params &params) const {
+        params.clear();
+        for (auto &t: trees_) {
+            if (t.method != method) continue;
 
-        Node *n = root->search(searchParts, 0, params);
+            if (path.size() > 1 && path.back() == '/') path.remove_suffix(1);
+            // 静态路由占大多数，一次哈希直接命中
+            auto it = t.statics.find(path);
+            if (it != t.statics.end()) return it->second;
 
-        if (n != nullptr) {
-            // 4. 【大幅简化】：参数已经在 search 过程中填好了，直接返回
-            return {n, params};
+            const Node *root = t.root.get();
+            if (path.compare(0, root->prefix.size(), root->prefix) != 0) return nullptr;
+            return match_children(root, path.substr(root->prefix.size()), params);
         }
+        return nullptr;
+    }
+
+    void Engine::add_route(std::string method, std::string path, HandlerFunc handler,
+                           std::vector<HandlerFunc> group_middlewares) {
+        HandlersChain chain;
+        chain.reserve(group_middlewares.size() + 1);
+        chain.insert(chain.end(), group_middlewares.begin(), group_middlewares.end());
+        chain.push_back(std::move(handler));
+
+        const Route *route = router_.add(method, path, std::move(chain));
+        spdlog::info("Route registered: {} - {}", method, route->pattern);
+    }
 
-        return {nullptr, {}};
+    const Route *Engine::get_route(std::string_view method, std::string_view path, Params &params) const {
+        return router_.find(method, path, params);
     }
 }
@@ -0,0 +1,428 @@
+#include "web/core/static_files.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <array>
+#include <charconv>
+#include <cstdio>
+
+#include "runtime/blocking_pool.h"
+#include "runtime/context/web_context.h"
+
+namespace gee {
+    struct StaticFiles::Mapping {
+        void *addr = nullptr;
+        size_t len = 0;
+
+        ~Mapping() {
+            if (addr) ::munmap(addr, len);
+        }
+
+        std::string_view view(size_t off, size_t n) const {
+            return {static_cast<const char *>(addr) + off, n};
+        }
+    };
+
+    namespace {
+        // 大文件：响应入队后由 OutputQueue 持有，sendfile 写完才关闭
+        struct FileHandle {
+            int fd = -1;
+
+            ~FileHandle() {
+                if (fd >= 0) ::close(fd);
+            }
+        };
+
+        struct MimeType {
+            std::string_view ext;
+            std::string_view line;
+        };
+
+        // 预先渲染好的 Content-Type 行，响应时直接借用
+        constexpr std::array<MimeType, 24> kMimeTypes = {{
+            {"html", "Content-Type: text/html; charset=utf-8\r\n"},
+            {"htm", "Content-Type: text/html; charset=utf-8\r\n"},
+            {"css", "Content-Type: text/css; charset=utf-8\r\n"},
+            {"js", "Content-Type: application/javascript; charset=utf-8\r\n"},
+            {"mjs", "Content-Type: application/javascript; charset=utf-8\r\n"},
+            {"json", "Content-Type: application/json; charset=utf-8\r\n"},
+            {"map", "Content-Type: application/json; charset=utf-8\r\n"},
+            {"txt", "Content-Type: text/plain; charset=utf-8\r\n"},
+            {"xml", "Content-Type: application/xml; charset=utf-8\r\n"},
+            {"svg", "Content-Type: image/svg+xml\r\n"},
+            {"png", "Content-Type: image/png\r\n"},
+            {"jpg", "Content-Type: image/jpeg\r\n"},
+            {"jpeg", "Content-Type: image/jpeg\r\n"},
+            {"gif", "Content-Type: image/gif\r\n"},
+            {"webp", "Content-Type: image/webp\r\n"},
+            {"ico", "Content-Type: image/x-icon\r\n"},
+            {"woff", "Content-Type: font/woff\r\n"},
+            {"woff2", "Content-Type: font/woff2\r\n"},
+            {"ttf", "Content-Type: font/ttf\r\n"},
+            {"wasm", "Content-Type: application/wasm\r\n"},
+            {"pdf", "Content-Type: application/pdf\r\n"},
+            {"mp4", "Content-Type: video/mp4\r\n"},
+            {"webm", "Content-Type: video/webm\r\n"},
+            {"mp3", "Content-Type: audio/mpeg\r\n"},
+        }};
+        constexpr std::string_view kOctetStream = "Content-Type: application/octet-stream\r\n";
+
+        std::string_view mime_line(std::string_view path) {
+            size_t dot = path.rfind('.');
+            size_t slash = path.rfind('/');
+            if (dot == std::string_view::npos || (slash != std::string_view::npos && dot < slash)) return kOctetStream;
+            std::string_view ext = path.substr(dot + 1);
+            for (const auto &m: kMimeTypes) {
+                if (iequals_ascii(m.ext, ext)) return m.line;
+            }
+            return kOctetStream;
+        }
+
+        int hex_value(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        // 百分号解码并规范化相对路径；含 ".."、NUL 或非法转义时返回 false
+        bool clean_path(std::string_view raw, std::string &out) {
+            std::string decoded;
+            decoded.reserve(raw.size());
+            for (size_t i = 0; i < raw.size(); ++i) {
+                char ch = raw[i];
+                if (ch == '%') {
+                    if (i + 2 >= raw.size()) return false;
+                    int hi = hex_value(raw[i + 1]), lo = hex_value(raw[i + 2]);
+                    if (hi < 0 || lo < 0) return false;
+                    ch = static_cast<char>((hi << 4) | lo);
+                    i += 2;
+                }
+                if (ch == '\0' || ch == '\\') return false;
+                decoded.push_back(ch);
+            }
+
+            out.clear();
+            std::string_view rest(decoded);
+            while (!rest.empty()) {
+                size_t slash = rest.find('/');
+                std::string_view seg = rest.substr(0, slash);
+                rest = slash == std::string_view::npos ? std::string_view() : rest.substr(slash + 1);
+                if (seg.empty() || seg == ".") continue;
+                if (seg == "..") return false;
+                if (!out.empty()) out.push_back('/');
+                out.append(seg);
+            }
+            return true;
+        }
+
+        bool etag_matches(std::string_view header, std::string_view etag) {
+            // If-None-Match: "a", W/"b", *
+            while (!header.empty()) {
+                size_t comma = header.find(',');
+                std::string_view tag = header.substr(0, comma);
+                header = comma == std::string_view::npos ? std::string_view() : header.substr(comma + 1);
+                while (!tag.empty() && (tag.front() == ' ' || tag.front() == '\t')) tag.remove_prefix(1);
+                while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t')) tag.remove_suffix(1);
+                if (tag == "*") return true;
+                if (tag.size() > 2 && tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+                if (tag == etag) return true;
+            }
+            return false;
+        }
+
+        enum class RangeResult { None, Ok, Unsatisfiable };
+
+        // 只支持单段 "bytes=a-b" / "bytes=a-" / "bytes=-n"，多段按整文件返回
+        RangeResult parse_range(std::string_view h, size_t size, size_t &start, size_t &len) {
+            if (h.substr(0, 6) != "bytes=") return RangeResult::None;
+            h.remove_prefix(6);
+            if (h.find(',') != std::string_view::npos) return RangeResult::None;
+            size_t dash = h.find('-');
+            if (dash == std::string_view::npos) return RangeResult::None;
+
+            auto parse_num = [](std::string_view s, size_t &v) {
+                if (s.empty()) return false;
+                auto [p, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+                return ec == std::errc() && p == s.data() + s.size();
+            };
+            std::string_view a = h.substr(0, dash), b = h.substr(dash + 1);
+            size_t first = 0, last = 0;
+            if (a.empty()) {
+                // 最后 n 个字节
+                size_t n;
+                if (!parse_num(b, n)) return RangeResult::None;
+                if (n == 0 || size == 0) return RangeResult::Unsatisfiable;
+                first = n >= size ? 0 : size - n;
+                last = size - 1;
+            } else {
+                if (!parse_num(a, first)) return RangeResult::None;
+                if (b.empty()) {
+                    last = size ? size - 1 : 0;
+                } else {
+                    if (!parse_num(b, last) || last < first) return RangeResult::None;
+                    if (last >= size) last = size ? size - 1 : 0;
+                }
+                if (first >= size) return RangeResult::Unsatisfiable;
+            }
+            start = first;
+            len = last - first + 1;
+            return RangeResult::Ok;
+        }
+
+        void append_uint(std::string &out, unsigned long long v) {
+            char buf[24];
+            auto [p, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+            out.append(buf, p);
+        }
+
+        void not_found(WebContext *c) {
+            c->JSON(StateCode::NOT_FOUND, "404 Not Found", "{}");
+        }
+    }
+
+    StaticFiles::StaticFiles(std::string root, StaticConfig config)
+        : root_(std::move(root)), config_(std::move(config)) {
+        while (root_.size() > 1 && root_.back() == '/') root_.pop_back();
+    }
+
+    std::shared_ptr<const StaticFiles::CacheEntry> StaticFiles::lookup(const std::string &rel) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = cache_.find(rel);
+        if (it == cache_.end()) return nullptr;
+        auto age = std::chrono::steady_clock::now() - it->second->checked_at;
+        if (age > std::chrono::milliseconds(config_.revalidate_ms)) return nullptr; // 过期，交给调用方重新加载
+        lru_.splice(lru_.begin(), lru_, it->second->lru);
+        return it->second;
+    }
+
+    void StaticFiles::insert(const std::string &rel, std::shared_ptr<CacheEntry> entry) {
+        size_t bytes = static_cast<size_t>(entry->info.size);
+        if (bytes > config_.max_cache_bytes) return;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = cache_.find(rel);
+        if (it != cache_.end()) {
+            cached_bytes_ -= static_cast<size_t>(it->second->info.size);
+            lru_.erase(it->second->lru);
+            cache_.erase(it);
+        }
+        // 淘汰最久未用的项；正在发送中的映射由 OutputQueue 的引用保活，不会被提前 munmap
+        while (cached_bytes_ + bytes > config_.max_cache_bytes && !lru_.empty()) {
+            auto victim = cache_.find(lru_.back());
+            cached_bytes_ -= static_cast<size_t>(victim->second->info.size);
+            cache_.erase(victim);
+            lru_.pop_back();
+        }
+        lru_.push_front(rel);
+        entry->lru = lru_.begin();
+        cached_bytes_ += bytes;
+        cache_.emplace(rel, std::move(entry));
+    }
+
+    void StaticFiles::evict(const std::string &rel) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = cache_.find(rel);
+        if (it == cache_.end()) return;
+        cached_bytes_ -= static_cast<size_t>(it->second->info.size);
+        lru_.erase(it->second->lru);
+        cache_.erase(it);
+    }
+
+    std::shared_ptr<const std::string> StaticFiles::compressed(const CacheEntry &entry, Encoding enc, int level) {
+        auto &slot = enc == Encoding::Gzip ? entry.gzip : entry.deflate;
+        entry.zlock.lock();
+        auto cached = slot;
+        entry.zlock.unlock();
+        if (cached) return cached;
+
+        // 锁外压缩，并发请求最多重复压一次，先写入的胜出
+        auto z = std::make_shared<std::string>();
+        if (!compress_body(entry.map->view(0, entry.map->len), enc, level, *z)) return nullptr;
+        entry.zlock.lock();
+        if (!slot) slot = std::move(z);
+        cached = slot;
+        entry.zlock.unlock();
+        return cached;
+    }
+
+    void StaticFiles::serve(WebContext *c) {
+        std::string rel;
+        if (!clean_path(c->Param("filepath"), rel)) {
+            not_found(c);
+            return;
+        }
+
+        std::shared_ptr<const CacheEntry> entry = lookup(rel);
+        FileInfo info;
+        std::shared_ptr<FileHandle> file;
+        if (entry) {
+            info = entry->info;
+        } else {
+            // 缓存未命中或需要重新校验：open/fstat/mmap 全部放到 BlockingPool
+            bool found = false;
+            std::shared_ptr<CacheEntry> fresh;
+            std::string path = rel.empty() ? root_ : root_ + "/" + rel;
+            runtime::BlockingPool::get().run([&]() {
+                int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0) return;
+                struct stat st;
+                if (::fstat(fd, &st) == 0 && S_ISDIR(st.st_mode) && !config_.index.empty()) {
+                    ::close(fd);
+                    path += "/" + config_.index;
+                    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                    if (fd < 0 || ::fstat(fd, &st) != 0) {
+                        if (fd >= 0) ::close(fd);
+                        return;
+                    }
+                }
+                if (!S_ISREG(st.st_mode)) {
+                    ::close(fd);
+                    return;
+                }
+
+                info.size = st.st_size;
+                info.mtime = st.st_mtime;
+                char etag[48];
+                int n = snprintf(etag, sizeof(etag), "\"%llx-%llx\"",
+                                 static_cast<unsigned long long>(st.st_mtime),
+                                 static_cast<unsigned long long>(st.st_size));
+                info.etag.assign(etag, static_cast<size_t>(n));
+                info.last_modified = format_http_date(st.st_mtime);
+                info.type_line = mime_line(path);
+                found = true;
+
+                if (static_cast<size_t>(st.st_size) > config_.max_cached_file) {
+                    file = std::make_shared<FileHandle>();
+                    file->fd = fd;
+                    return;
+                }
+                fresh = std::make_shared<CacheEntry>();
+                fresh->info = info;
+                fresh->map = std::make_shared<Mapping>();
+                if (st.st_size > 0) {
+                    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+                    flags |= MAP_POPULATE; // 预先缺页，发送时不会在 Worker 上触发磁盘读
+#endif
+                    void *addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, flags, fd, 0);
+                    if (addr == MAP_FAILED) {
+                        fresh.reset();
+                        found = false;
+                    } else {
+                        fresh->map->addr = addr;
+                        fresh->map->len = static_cast<size_t>(st.st_size);
+                    }
+                }
+                ::close(fd);
+                if (fresh) fresh->checked_at = std::chrono::steady_clock::now();
+            });
+
+            if (!found) {
+                evict(rel);
+                not_found(c);
+                return;
+            }
+            if (fresh) {
+                insert(rel, fresh);
+                entry = fresh;
+            }
+        }
+
+        // --- 压缩：只对缓存中的文本类文件，且不是 Range 请求 ---
+        Response &res = c->res_;
+        std::string_view range = c->req_.get_header("Range");
+        bool compressible = entry && compressible_type(info.type_line);
+        std::shared_ptr<const std::string> zbody;
+        if (compressible && range.empty() && res.encoding != Encoding::Identity &&
+            static_cast<size_t>(info.size) >= res.compress_min) {
+            zbody = compressed(*entry, res.encoding, res.compress_level);
+            if (zbody && zbody->size() >= static_cast<size_t>(info.size)) zbody.reset();
+        }
+        // 压缩版本的 ETag 与原文件区分开，避免缓存把两种表示混用
+        std::string etag = info.etag;
+        if (zbody) etag.insert(etag.size() - 1, res.encoding == Encoding::Gzip ? "-gzip" : "-deflate");
+
+        // --- 条件请求 ---
+        std::string extra;
+        extra.reserve(160);
+        extra.append("ETag: ").append(etag).append("\r\n");
+        extra.append("Last-Modified: ").append(info.last_modified).append("\r\n");
+        if (config_.max_age_s > 0) {
+            extra.append("Cache-Control: max-age=");
+            append_uint(extra, static_cast<unsigned long long>(config_.max_age_s));
+            extra.append("\r\n");
+        }
+
+        if (zbody) {
+            extra.append(encoding_header(res.encoding));
+        } else if (compressible) {
+            extra.append("Vary: Accept-Encoding\r\n");
+        }
+
+        OutputQueue &out = c->out_;
+        std::string_view inm = c->req_.get_header("If-None-Match");
+        bool not_modified = !inm.empty()
+                                ? etag_matches(inm, etag)
+                                : c->req_.get_header("If-Modified-Since") == info.last_modified;
+        if (not_modified) {
+            res.write_head(out, 304, {}, Response::kNoLength, extra);
+            out.end_response();
+            res.is_sent = true;
+            return;
+        }
+
+        if (zbody) {
+            res.write_head(out, 200, info.type_line, zbody->size(), extra);
+            if (c->method() != "HEAD") out.push_shared(*zbody, zbody);
+            out.end_response();
+            res.is_sent = true;
+            return;
+        }
+
+        // --- Range ---
+        auto size = static_cast<size_t>(info.size);
+        size_t start = 0, len = size;
+        int code = 200;
+        extra.append("Accept-Ranges: bytes\r\n");
+        std::string_view if_range = c->req_.get_header("If-Range");
+        if (!range.empty() && (if_range.empty() || if_range == info.etag || if_range == info.last_modified)) {
+            RangeResult r = parse_range(range, size, start, len);
+            if (r == RangeResult::Unsatisfiable) {
+                extra.append("Content-Range: bytes */");
+                append_uint(extra, size);
+                extra.append("\r\n");
+                res.write_head(out, 416, {}, 0, extra);
+                out.end_response();
+                res.is_sent = true;
+                return;
+            }
+            if (r == RangeResult::Ok) {
+                code = 206;
+                extra.append("Content-Range: bytes ");
+                append_uint(extra, start);
+                extra.push_back('-');
+                append_uint(extra, start + len - 1);
+                extra.push_back('/');
+                append_uint(extra, size);
+                extra.append("\r\n");
+            } else {
+                start = 0;
+                len = size;
+            }
+        }
+
+        res.write_head(out, code, info.type_line, len, extra);
+        if (c->method() != "HEAD") {
+            if (entry) {
+                if (len > 0) out.push_shared(entry->map->view(start, len), entry->map);
+            } else {
+                out.push_file(file->fd, static_cast<off_t>(start), len, file);
+            }
+        }
+        out.end_response();
+        res.is_sent = true;
+    }
+}
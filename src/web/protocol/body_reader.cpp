@@ -0,0 +1,240 @@
+#include "web/protocol/body_reader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "web/core/router.h"
+#include "web/protocol/request.h"
+
+namespace gee {
+    namespace {
+        constexpr int kMaxSizeDigits = 15; // 分块长度最多 15 位十六进制，避免溢出
+        constexpr size_t kMaxChunkExt = 4096;
+        constexpr size_t kMaxTrailer = 8192;
+
+        int hex_value(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+    }
+
+    void BodyReader::begin() {
+        started_ = true;
+        if (!req_.body_deferred_) {
+            state_ = State::Buffered;
+        } else if (req_.parser_.chunked()) {
+            state_ = State::ChunkSize;
+            remaining_ = 0;
+        } else {
+            remaining_ = req_.content_length;
+            state_ = remaining_ > 0 ? State::Length : State::Done;
+        }
+    }
+
+    void BodyReader::reset() {
+        state_ = State::Buffered;
+        started_ = false;
+        remaining_ = consumed_ = 0;
+        size_digits_ = 0;
+        line_len_ = trailer_bytes_ = 0;
+    }
+
+    bool BodyReader::fill() {
+        // 读缓冲区满了会换 slab，Header 视图和路由参数要跟着平移
+        const char *old_base = req_.raw_data_.data();
+        ssize_t n = req_.web_read(fd_);
+        req_.rebase_views(old_base);
+        if (params_ && old_base != req_.raw_data_.data()) {
+            params_->rebase(old_base, req_.header_size, req_.raw_data_.data());
+        }
+        return n > 0;
+    }
+
+    ssize_t BodyReader::read(char *buf, size_t len) {
+        if (!started_) begin();
+        if (len == 0) return 0;
+
+        ReadBuffer &raw = req_.raw_data_;
+        const size_t base = req_.header_size;
+        while (true) {
+            switch (state_) {
+                case State::Buffered: {
+                    size_t n = std::min(len, req_.body.size() - consumed_);
+                    std::memcpy(buf, req_.body.data() + consumed_, n);
+                    consumed_ += n;
+                    return static_cast<ssize_t>(n);
+                }
+                case State::Done:
+                    return 0;
+                case State::Failed:
+                    return -1;
+                case State::Length: {
+                    size_t avail = raw.size() - base;
+                    if (avail == 0) {
+                        if (!fill()) {
+                            state_ = State::Failed;
+                            return -1;
+                        }
+                        continue;
+                    }
+                    size_t n = std::min({len, avail, remaining_});
+                    std::memcpy(buf, raw.data() + base, n);
+                    raw.erase(base, n);
+                    remaining_ -= n;
+                    consumed_ += n;
+                    if (remaining_ == 0) state_ = State::Done;
+                    return static_cast<ssize_t>(n);
+                }
+                default: {
+                    size_t n = decode_chunked(buf, len);
+                    if (n > 0) {
+                        consumed_ += n;
+                        return static_cast<ssize_t>(n);
+                    }
+                    if (state_ == State::Done) return 0;
+                    if (state_ == State::Failed) return -1;
+                    if (!fill()) {
+                        state_ = State::Failed;
+                        return -1;
+                    }
+                }
+            }
+        }
+    }
+
+    size_t BodyReader::decode_chunked(char *buf, size_t len) {
+        ReadBuffer &raw = req_.raw_data_;
+        const size_t base = req_.header_size;
+        std::string_view in = raw.view().substr(base);
+        size_t i = 0;
+        size_t out = 0;
+
+        // 长度行结束：0 表示最后一块，后面跟 trailer
+        auto end_size_line = [this]() {
+            if (size_digits_ == 0) {
+                state_ = State::Failed;
+                return;
+            }
+            size_digits_ = 0;
+            line_len_ = 0;
+            state_ = remaining_ == 0 ? State::Trailer : State::ChunkData;
+        };
+
+        // 调用方的 buf 写满就停在数据块中间，剩下的留给下一次 read
+        while (i < in.size() && state_ != State::Done && state_ != State::Failed
+               && !(state_ == State::ChunkData && out == len)) {
+            switch (state_) {
+                case State::ChunkSize: {
+                    char c = in[i];
+                    int v = hex_value(c);
+                    if (v >= 0) {
+                        if (++size_digits_ > kMaxSizeDigits) {
+                            state_ = State::Failed;
+                            break;
+                        }
+                        remaining_ = remaining_ * 16 + static_cast<size_t>(v);
+                        ++i;
+                    } else if (c == '\n') {
+                        ++i;
+                        end_size_line();
+                    } else if (c == ';' || c == ' ' || c == '\t' || c == '\r') {
+                        // 扩展参数和行尾的 CR 一律跳到 LF
+                        if (size_digits_ == 0) {
+                            state_ = State::Failed;
+                            break;
+                        }
+                        line_len_ = 0;
+                        state_ = State::ChunkExt;
+                    } else {
+                        state_ = State::Failed;
+                    }
+                    break;
+                }
+                case State::ChunkExt: {
+                    size_t nl = in.find('\n', i);
+                    size_t skipped = (nl == std::string_view::npos ? in.size() : nl) - i;
+                    line_len_ += skipped;
+                    if (line_len_ > kMaxChunkExt) {
+                        state_ = State::Failed;
+                        break;
+                    }
+                    i += skipped;
+                    if (nl != std::string_view::npos) {
+                        ++i;
+                        end_size_line();
+                    }
+                    break;
+                }
+                case State::ChunkData: {
+                    size_t n = std::min({remaining_, in.size() - i, len - out});
+                    std::memcpy(buf + out, in.data() + i, n);
+                    out += n;
+                    i += n;
+                    remaining_ -= n;
+                    if (remaining_ == 0) state_ = State::ChunkEnd;
+                    break;
+                }
+                case State::ChunkEnd: {
+                    char c = in[i++];
+                    if (c == '\n') {
+                        state_ = State::ChunkSize;
+                    } else if (c != '\r') {
+                        state_ = State::Failed;
+                    }
+                    break;
+                }
+                case State::Trailer: {
+                    // trailer 字段直接丢弃，只找结束的空行
+                    char c = in[i++];
+                    if (++trailer_bytes_ > kMaxTrailer) {
+                        state_ = State::Failed;
+                    } else if (c == '\n') {
+                        if (line_len_ == 0) state_ = State::Done;
+                        line_len_ = 0;
+                    } else if (c != '\r') {
+                        ++line_len_;
+                    }
+                    break;
+                }
+                default:
+                    state_ = State::Failed;
+                    break;
+            }
+        }
+        // 已解码的字节（含分块元数据）从缓冲区删掉，Body 之后的流水线数据前移到 Header 后面
+        raw.erase(base, i);
+        return out;
+    }
+
+    bool BodyReader::read_all(std::string &out, size_t limit) {
+        constexpr size_t kStep = 16 * 1024;
+        size_t start = out.size();
+        while (true) {
+            size_t old = out.size();
+            out.resize(old + kStep);
+            ssize_t n = read(&out[old], kStep);
+            out.resize(old + (n > 0 ? static_cast<size_t>(n) : 0));
+            if (n < 0) return false;
+            if (n == 0) return true;
+            if (out.size() - start > limit) return false;
+        }
+    }
+
+    bool BodyReader::drain(size_t limit) {
+        // 客户端还在等 100 Continue，Body 可能根本不会发来，直接关闭连接
+        if (!started_ && req_.body_deferred_ && !req_.get_header("Expect").empty()) return false;
+        if (!started_) begin();
+        if (state_ == State::Buffered) return true; // reset() 会连同 Header 一起丢弃
+        char scratch[4096];
+        size_t drained = 0;
+        while (true) {
+            ssize_t n = read(scratch, sizeof(scratch));
+            if (n < 0) return false;
+            if (n == 0) return true;
+            drained += static_cast<size_t>(n);
+            if (drained > limit) return false;
+        }
+    }
+}
@@ -0,0 +1,142 @@
+#include "web/protocol/compress.h"
+
+#include <charconv>
+
+#include "web/protocol/header_map.h"
+#include "runtime/scheduler.h"
+
+namespace gee {
+    namespace {
+        std::string_view trim(std::string_view s) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+            return s;
+        }
+
+        // "0.5" -> 500；非法值按 0 处理
+        int parse_q(std::string_view v) {
+            if (v.empty() || (v[0] != '0' && v[0] != '1')) return 0;
+            int q = (v[0] - '0') * 1000;
+            if (v.size() > 1) {
+                if (v[1] != '.') return 0;
+                int scale = 100;
+                for (size_t i = 2; i < v.size() && scale > 0; ++i, scale /= 10) {
+                    if (v[i] < '0' || v[i] > '9') return 0;
+                    q += (v[i] - '0') * scale;
+                }
+            }
+            return q > 1000 ? 1000 : q;
+        }
+    }
+
+    Encoding negotiate_encoding(std::string_view header) {
+        int gzip_q = -1, deflate_q = -1, star_q = -1;
+        while (!header.empty()) {
+            size_t comma = header.find(',');
+            std::string_view item = header.substr(0, comma);
+            header = comma == std::string_view::npos ? std::string_view() : header.substr(comma + 1);
+
+            size_t semi = item.find(';');
+            std::string_view coding = trim(item.substr(0, semi));
+            int q = 1000;
+            if (semi != std::string_view::npos) {
+                std::string_view param = trim(item.substr(semi + 1));
+                if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+                    q = parse_q(trim(param.substr(2)));
+                }
+            }
+            if (iequals_ascii(coding, "gzip") || iequals_ascii(coding, "x-gzip")) {
+                gzip_q = q;
+            } else if (iequals_ascii(coding, "deflate")) {
+                deflate_q = q;
+            } else if (coding == "*") {
+                star_q = q;
+            }
+        }
+        if (gzip_q < 0) gzip_q = star_q;
+        if (deflate_q < 0) deflate_q = star_q;
+        // 同等 q 值优先 gzip：部分客户端对 deflate 的 zlib 头处理不一致
+        if (gzip_q > 0 && gzip_q >= deflate_q) return Encoding::Gzip;
+        if (deflate_q > 0) return Encoding::Deflate;
+        return Encoding::Identity;
+    }
+
+    std::string_view encoding_header(Encoding enc) {
+        switch (enc) {
+            case Encoding::Gzip: return "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n";
+            case Encoding::Deflate: return "Content-Encoding: deflate\r\nVary: Accept-Encoding\r\n";
+            default: return {};
+        }
+    }
+
+    bool compressible_type(std::string_view type_line) {
+        for (std::string_view t: {"text/", "json", "javascript", "xml", "svg", "wasm"}) {
+            if (type_line.find(t) != std::string_view::npos) return true;
+        }
+        return false;
+    }
+
+    Deflater::Deflater(Encoding enc, int level) {
+        // HTTP 的 deflate 指 zlib 格式（RFC 1950），gzip 再加 16
+        int window_bits = enc == Encoding::Gzip ? 15 + 16 : 15;
+        if (level < 1 || level > 9) level = Z_DEFAULT_COMPRESSION;
+        ok_ = deflateInit2(&zs_, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+
+    Deflater::~Deflater() {
+        if (ok_) deflateEnd(&zs_);
+    }
+
+    bool Deflater::pump(int flush, std::string &out) {
+        while (true) {
+            size_t old = out.size();
+            // 压缩后的数据通常不大于输入，按输入量 + 少量余量扩容
+            size_t room = deflateBound(&zs_, zs_.avail_in) + 64;
+            out.resize(old + room);
+            zs_.next_out = reinterpret_cast<Bytef *>(&out[old]);
+            zs_.avail_out = static_cast<uInt>(room);
+            int rc = deflate(&zs_, flush);
+            out.resize(old + room - zs_.avail_out);
+            if (rc == Z_STREAM_ERROR) return false;
+            if (flush == Z_FINISH) {
+                if (rc == Z_STREAM_END) return true;
+            } else if (zs_.avail_in == 0 && zs_.avail_out != 0) {
+                return true;
+            }
+        }
+    }
+
+    bool Deflater::write(std::string_view in, std::string &out) {
+        if (!ok_) return false;
+        while (!in.empty()) {
+            size_t n = in.size() < kSlice ? in.size() : kSlice;
+            zs_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+            zs_.avail_in = static_cast<uInt>(n);
+            if (!pump(Z_NO_FLUSH, out)) return false;
+            in.remove_prefix(n);
+            // 每压一片让出一次，其他协程可以插进来
+            if (!in.empty()) runtime::yield_now();
+        }
+        return true;
+    }
+
+    bool Deflater::sync(std::string &out) {
+        if (!ok_) return false;
+        zs_.next_in = nullptr;
+        zs_.avail_in = 0;
+        return pump(Z_SYNC_FLUSH, out);
+    }
+
+    bool Deflater::finish(std::string &out) {
+        if (!ok_) return false;
+        zs_.next_in = nullptr;
+        zs_.avail_in = 0;
+        return pump(Z_FINISH, out);
+    }
+
+    bool compress_body(std::string_view in, Encoding enc, int level, std::string &out) {
+        Deflater d(enc, level);
+        out.reserve(in.size() / 4 + 64);
+        return d.write(in, out) && d.finish(out);
+    }
+}
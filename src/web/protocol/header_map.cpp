@@ -0,0 +1,85 @@
+#include "web/protocol/header_map.h"
+
+namespace gee {
+    HeaderId HeaderMap::id_of(std::string_view name) {
+        // 先按长度分桶，同长度内最多比较一两次
+        switch (name.size()) {
+            case 4:
+                if (iequals_ascii(name, "host")) return HeaderId::Host;
+                break;
+            case 7:
+                if (iequals_ascii(name, "upgrade")) return HeaderId::Upgrade;
+                break;
+            case 10:
+                if (iequals_ascii(name, "connection")) return HeaderId::Connection;
+                break;
+            case 12:
+                if (iequals_ascii(name, "content-type")) return HeaderId::ContentType;
+                break;
+            case 14:
+                if (iequals_ascii(name, "content-length")) return HeaderId::ContentLength;
+                break;
+            case 15:
+                if (iequals_ascii(name, "accept-encoding")) return HeaderId::AcceptEncoding;
+                break;
+            case 17:
+                if (iequals_ascii(name, "transfer-encoding")) return HeaderId::TransferEncoding;
+                break;
+            default:
+                break;
+        }
+        return HeaderId::Unknown;
+    }
+
+    bool header_has_token(std::string_view list, std::string_view token) {
+        size_t pos = 0;
+        while (pos <= list.size()) {
+            size_t comma = list.find(',', pos);
+            if (comma == std::string_view::npos) comma = list.size();
+            std::string_view item = list.substr(pos, comma - pos);
+            while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) item.remove_prefix(1);
+            while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) item.remove_suffix(1);
+            if (iequals_ascii(item, token)) return true;
+            pos = comma + 1;
+        }
+        return false;
+    }
+
+    void HeaderMap::add(std::string_view name, std::string_view value) {
+        if (size_ < kInline) {
+            inline_[size_] = {name, value};
+        } else {
+            overflow_.emplace_back(name, value);
+        }
+        ++size_;
+
+        HeaderId id = id_of(name);
+        if (id != HeaderId::Unknown && size_ <= UINT8_MAX) {
+            uint8_t &slot = known_[static_cast<size_t>(id)];
+            if (slot == 0) slot = static_cast<uint8_t>(size_);
+        }
+    }
+
+    std::string_view HeaderMap::get(std::string_view name) const {
+        HeaderId id = id_of(name);
+        if (id != HeaderId::Unknown) return get(id);
+        for (size_t i = 0; i < size_; ++i) {
+            const Entry &e = at(i);
+            if (iequals_ascii(e.first, name)) return e.second;
+        }
+        return {};
+    }
+
+    void HeaderMap::rebase(const char *old_base, size_t len, const char *new_base) {
+        auto move = [&](std::string_view &v) {
+            if (v.data() >= old_base && v.data() <= old_base + len) {
+                v = std::string_view(new_base + (v.data() - old_base), v.size());
+            }
+        };
+        for (size_t i = 0; i < size_; ++i) {
+            Entry &e = at(i);
+            move(e.first);
+            move(e.second);
+        }
+    }
+}
@@ -0,0 +1,416 @@
+#include "web/protocol/hpack.h"
+
+#include <algorithm>
+#include <array>
+
+namespace gee {
+    namespace {
+        struct StaticEntry {
+            std::string_view name;
+            std::string_view value;
+        };
+
+        // RFC 7541 附录 A
+        constexpr StaticEntry kStaticTable[HpackTable::kStaticCount] = {
+            {":authority", ""},
+            {":method", "GET"},
+            {":method", "POST"},
+            {":path", "/"},
+            {":path", "/index.html"},
+            {":scheme", "http"},
+            {":scheme", "https"},
+            {":status", "200"},
+            {":status", "204"},
+            {":status", "206"},
+            {":status", "304"},
+            {":status", "400"},
+            {":status", "404"},
+            {":status", "500"},
+            {"accept-charset", ""},
+            {"accept-encoding", "gzip, deflate"},
+            {"accept-language", ""},
+            {"accept-ranges", ""},
+            {"accept", ""},
+            {"access-control-allow-origin", ""},
+            {"age", ""},
+            {"allow", ""},
+            {"authorization", ""},
+            {"cache-control", ""},
+            {"content-disposition", ""},
+            {"content-encoding", ""},
+            {"content-language", ""},
+            {"content-length", ""},
+            {"content-location", ""},
+            {"content-range", ""},
+            {"content-type", ""},
+            {"cookie", ""},
+            {"date", ""},
+            {"etag", ""},
+            {"expect", ""},
+            {"expires", ""},
+            {"from", ""},
+            {"host", ""},
+            {"if-match", ""},
+            {"if-modified-since", ""},
+            {"if-none-match", ""},
+            {"if-range", ""},
+            {"if-unmodified-since", ""},
+            {"last-modified", ""},
+            {"link", ""},
+            {"location", ""},
+            {"max-forwards", ""},
+            {"proxy-authenticate", ""},
+            {"proxy-authorization", ""},
+            {"range", ""},
+            {"referer", ""},
+            {"refresh", ""},
+            {"retry-after", ""},
+            {"server", ""},
+            {"set-cookie", ""},
+            {"strict-transport-security", ""},
+            {"transfer-encoding", ""},
+            {"user-agent", ""},
+            {"vary", ""},
+            {"via", ""},
+            {"www-authenticate", ""},
+        };
+
+        constexpr size_t kEntryOverhead = 32;
+
+        // RFC 7541 附录 B：每个符号的 {码字（右对齐）, 位数}，256 是 EOS
+        struct HuffCode {
+            uint32_t code;
+            uint8_t bits;
+        };
+
+        constexpr HuffCode kHuffman[257] = {
+            {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28},
+            {0xfffffe4, 28}, {0xfffffe5, 28}, {0xfffffe6, 28}, {0xfffffe7, 28},
+            {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+            {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28},
+            {0xfffffed, 28}, {0xfffffee, 28}, {0xfffffef, 28}, {0xffffff0, 28},
+            {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+            {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28},
+            {0xffffff8, 28}, {0xffffff9, 28}, {0xffffffa, 28}, {0xffffffb, 28},
+            {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},
+            {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11},
+            {0x3fa, 10}, {0x3fb, 10}, {0xf9, 8}, {0x7fb, 11},
+            {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+            {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6},
+            {0x1a, 6}, {0x1b, 6}, {0x1c, 6}, {0x1d, 6},
+            {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},
+            {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10},
+            {0x1ffa, 13}, {0x21, 6}, {0x5d, 7}, {0x5e, 7},
+            {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+            {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7},
+            {0x67, 7}, {0x68, 7}, {0x69, 7}, {0x6a, 7},
+            {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+            {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7},
+            {0xfc, 8}, {0x73, 7}, {0xfd, 8}, {0x1ffb, 13},
+            {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+            {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5},
+            {0x24, 6}, {0x5, 5}, {0x25, 6}, {0x26, 6},
+            {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},
+            {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5},
+            {0x2b, 6}, {0x76, 7}, {0x2c, 6}, {0x8, 5},
+            {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+            {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15},
+            {0x7fc, 11}, {0x3ffd, 14}, {0x1ffd, 13}, {0xffffffc, 28},
+            {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},
+            {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23},
+            {0x3fffd6, 22}, {0x7fffda, 23}, {0x7fffdb, 23}, {0x7fffdc, 23},
+            {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+            {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23},
+            {0xffffee, 24}, {0x7fffe1, 23}, {0x7fffe2, 23}, {0x7fffe3, 23},
+            {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},
+            {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24},
+            {0x3fffda, 22}, {0x1fffdd, 21}, {0xfffe9, 20}, {0x3fffdb, 22},
+            {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+            {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24},
+            {0x1fffdf, 21}, {0x3fffdf, 22}, {0x7fffeb, 23}, {0x7fffec, 23},
+            {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},
+            {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23},
+            {0xfffea, 20}, {0x3fffe2, 22}, {0x3fffe3, 22}, {0x3fffe4, 22},
+            {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+            {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19},
+            {0x3fffe7, 22}, {0x7ffff2, 23}, {0x3fffe8, 22}, {0x1ffffec, 25},
+            {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},
+            {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25},
+            {0x7fff2, 19}, {0x1fffe3, 21}, {0x3ffffe6, 26}, {0x7ffffe0, 27},
+            {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+            {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26},
+            {0xffffffd, 28}, {0x7ffffe3, 27}, {0x7ffffe4, 27}, {0x7ffffe5, 27},
+            {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},
+            {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23},
+            {0x3fffea, 22}, {0x3fffeb, 22}, {0x1ffffee, 25}, {0x1ffffef, 25},
+            {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+            {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26},
+            {0x7ffffe7, 27}, {0x7ffffe8, 27}, {0x7ffffe9, 27}, {0x7ffffea, 27},
+            {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
+            {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26},
+            {0x3fffffff, 30},
+        };
+
+        /**
+         * 规范 Huffman 码：同一长度的码字按符号顺序连续分配。
+         * 对每个长度 L 记录第一个码字和个数，解码时取前 L 位与 [first, first + count) 比较即可，不需要建树
+         */
+        struct HuffDecodeTable {
+            uint32_t first[31] = {};
+            uint32_t count[31] = {};
+            uint16_t offset[31] = {};
+            uint16_t symbols[257] = {};
+
+            HuffDecodeTable() {
+                uint16_t n = 0;
+                for (int len = 1; len <= 30; ++len) {
+                    offset[len] = n;
+                    bool found = false;
+                    for (uint16_t s = 0; s < 257; ++s) {
+                        if (kHuffman[s].bits != len) continue;
+                        if (!found) first[len] = kHuffman[s].code;
+                        found = true;
+                        symbols[n++] = s;
+                        ++count[len];
+                    }
+                    if (!found && len > 1) first[len] = (first[len - 1] + count[len - 1]) << 1;
+                }
+            }
+        };
+
+        const HuffDecodeTable &huff_table() {
+            static const HuffDecodeTable table;
+            return table;
+        }
+
+        // 带 prefix 位前缀的整数（RFC 7541 §5.1）
+        bool decode_int(std::string_view in, size_t &pos, int prefix, uint64_t &out) {
+            if (pos >= in.size()) return false;
+            const uint64_t mask = (1u << prefix) - 1;
+            out = static_cast<uint8_t>(in[pos++]) & mask;
+            if (out < mask) return true;
+            int shift = 0;
+            while (pos < in.size()) {
+                uint8_t b = static_cast<uint8_t>(in[pos++]);
+                if (shift > 28) return false; // 超过 32 位的值都视为攻击
+                out += static_cast<uint64_t>(b & 0x7F) << shift;
+                shift += 7;
+                if ((b & 0x80) == 0) return true;
+            }
+            return false;
+        }
+
+        void encode_int(std::string &out, uint8_t flags, int prefix, uint64_t value) {
+            const uint64_t mask = (1u << prefix) - 1;
+            if (value < mask) {
+                out.push_back(static_cast<char>(flags | value));
+                return;
+            }
+            out.push_back(static_cast<char>(flags | mask));
+            value -= mask;
+            while (value >= 0x80) {
+                out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        bool decode_string(std::string_view in, size_t &pos, std::string &out) {
+            if (pos >= in.size()) return false;
+            bool huffman = (static_cast<uint8_t>(in[pos]) & 0x80) != 0;
+            uint64_t len;
+            if (!decode_int(in, pos, 7, len) || len > in.size() - pos) return false;
+            std::string_view raw = in.substr(pos, static_cast<size_t>(len));
+            pos += static_cast<size_t>(len);
+            out.clear();
+            if (!huffman) {
+                out.assign(raw.data(), raw.size());
+                return true;
+            }
+            return hpack_huffman_decode(raw, out);
+        }
+
+        void encode_string(std::string &out, std::string_view s) {
+            encode_int(out, 0x00, 7, s.size());
+            out.append(s);
+        }
+
+        // 取值稳定、值得放进动态表的响应头
+        bool worth_indexing(std::string_view name) {
+            return name == "content-type" || name == "content-encoding" || name == "vary"
+                   || name == "server" || name == "cache-control" || name == "accept-ranges"
+                   || name == "access-control-allow-origin";
+        }
+    }
+
+    bool hpack_huffman_decode(std::string_view in, std::string &out) {
+        const HuffDecodeTable &t = huff_table();
+        out.reserve(out.size() + in.size() * 8 / 5);
+        uint64_t acc = 0;
+        int nbits = 0;
+        size_t pos = 0;
+        while (true) {
+            while (nbits <= 56 && pos < in.size()) {
+                acc = (acc << 8) | static_cast<uint8_t>(in[pos++]);
+                nbits += 8;
+            }
+            if (nbits == 0) return true;
+            int max_len = std::min(nbits, 30);
+            int len = 5; // 最短的码字 5 位
+            for (; len <= max_len; ++len) {
+                uint32_t v = static_cast<uint32_t>((acc >> (nbits - len)) & ((1ULL << len) - 1));
+                if (v - t.first[len] < t.count[len]) {
+                    uint16_t sym = t.symbols[t.offset[len] + (v - t.first[len])];
+                    if (sym == 256) return false; // 字符串里不允许出现 EOS
+                    out.push_back(static_cast<char>(sym));
+                    nbits -= len;
+                    break;
+                }
+            }
+            if (len <= max_len) continue;
+            // 剩下的位凑不出完整符号：只能是不超过 7 位、全为 1 的填充
+            if (pos < in.size() || nbits > 7) return false;
+            return (acc & ((1ULL << nbits) - 1)) == ((1ULL << nbits) - 1);
+        }
+    }
+
+    bool HpackTable::get(size_t index, std::string_view &name, std::string_view &value) const {
+        if (index == 0) return false;
+        if (index <= kStaticCount) {
+            name = kStaticTable[index - 1].name;
+            value = kStaticTable[index - 1].value;
+            return true;
+        }
+        index -= kStaticCount + 1;
+        if (index >= entries_.size()) return false;
+        name = entries_[index].first;
+        value = entries_[index].second;
+        return true;
+    }
+
+    void HpackTable::add(std::string_view name, std::string_view value) {
+        size_t need = name.size() + value.size() + kEntryOverhead;
+        // 比整个表还大的条目：清空表，条目本身也不保留
+        while (!entries_.empty() && size_ + need > max_size_) {
+            const auto &last = entries_.back();
+            size_ -= last.first.size() + last.second.size() + kEntryOverhead;
+            entries_.pop_back();
+        }
+        if (need > max_size_) return;
+        entries_.emplace_front(std::string(name), std::string(value));
+        size_ += need;
+    }
+
+    void HpackTable::set_max_size(size_t n) {
+        max_size_ = n;
+        while (!entries_.empty() && size_ > max_size_) {
+            const auto &last = entries_.back();
+            size_ -= last.first.size() + last.second.size() + kEntryOverhead;
+            entries_.pop_back();
+        }
+    }
+
+    size_t HpackTable::find(std::string_view name, std::string_view value, bool &exact) const {
+        size_t name_match = 0;
+        exact = false;
+        for (size_t i = 0; i < kStaticCount; ++i) {
+            if (kStaticTable[i].name != name) continue;
+            if (kStaticTable[i].value == value) {
+                exact = true;
+                return i + 1;
+            }
+            if (!name_match) name_match = i + 1;
+        }
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            if (entries_[i].first != name) continue;
+            if (entries_[i].second == value) {
+                exact = true;
+                return kStaticCount + 1 + i;
+            }
+            if (!name_match) name_match = kStaticCount + 1 + i;
+        }
+        return name_match;
+    }
+
+    bool HpackDecoder::decode(std::string_view block, HeaderList &out) {
+        size_t pos = 0;
+        size_t list_bytes = 0;
+        bool seen_field = false;
+        std::string name_buf;
+        std::string value_buf;
+        while (pos < block.size()) {
+            uint8_t b = static_cast<uint8_t>(block[pos]);
+            std::string_view name;
+            std::string_view value;
+            uint64_t index;
+            if (b & 0x80) {
+                // 索引字段
+                if (!decode_int(block, pos, 7, index) || !table_.get(static_cast<size_t>(index), name, value)) {
+                    return false;
+                }
+                out.emplace_back(std::string(name), std::string(value));
+            } else if ((b & 0xE0) == 0x20) {
+                // 动态表大小更新只能出现在 block 开头
+                if (seen_field || !decode_int(block, pos, 5, index) || index > limit_) return false;
+                table_.set_max_size(static_cast<size_t>(index));
+                continue;
+            } else {
+                // 字面量：01 增量索引（6 位前缀）、0000 不索引、0001 永不索引（4 位前缀）
+                bool incremental = (b & 0xC0) == 0x40;
+                if (!decode_int(block, pos, incremental ? 6 : 4, index)) return false;
+                if (index == 0) {
+                    if (!decode_string(block, pos, name_buf)) return false;
+                } else {
+                    std::string_view idx_value;
+                    if (!table_.get(static_cast<size_t>(index), name, idx_value)) return false;
+                    name_buf.assign(name.data(), name.size());
+                }
+                if (!decode_string(block, pos, value_buf)) return false;
+                if (incremental) table_.add(name_buf, value_buf);
+                out.emplace_back(name_buf, value_buf);
+            }
+            seen_field = true;
+            list_bytes += out.back().first.size() + out.back().second.size() + kEntryOverhead;
+            if (list_bytes > max_list_bytes_) return false;
+        }
+        return true;
+    }
+
+    void HpackEncoder::set_max_table_size(size_t n) {
+        // 我们的动态表从不超过默认的 4096
+        table_.set_max_size(std::min<size_t>(n, 4096));
+        size_update_ = true;
+    }
+
+    void HpackEncoder::encode_status(int code, std::string &out) {
+        if (size_update_) {
+            encode_int(out, 0x20, 5, table_.max_size());
+            size_update_ = false;
+        }
+        char buf[4];
+        int c = std::clamp(code, 100, 999);
+        buf[0] = static_cast<char>('0' + c / 100);
+        buf[1] = static_cast<char>('0' + c / 10 % 10);
+        buf[2] = static_cast<char>('0' + c % 10);
+        encode(":status", std::string_view(buf, 3), out);
+    }
+
+    void HpackEncoder::encode(std::string_view name, std::string_view value, std::string &out) {
+        bool exact = false;
+        size_t index = table_.find(name, value, exact);
+        if (exact) {
+            encode_int(out, 0x80, 7, index);
+            return;
+        }
+        if (worth_indexing(name)) {
+            encode_int(out, 0x40, 6, index);
+            if (index == 0) encode_string(out, name);
+            encode_string(out, value);
+            table_.add(name, value);
+            return;
+        }
+        encode_int(out, 0x00, 4, index);
+        if (index == 0) encode_string(out, name);
+        encode_string(out, value);
+    }
+}
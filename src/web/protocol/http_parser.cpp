@@ -0,0 +1,200 @@
+#include "web/protocol/http_parser.h"
+
+#include <array>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace gee {
+    namespace {
+        // RFC 7230 tchar：方法名与 Header 名只能由这些字符组成
+        constexpr std::array<bool, 256> make_tchar_table() {
+            std::array<bool, 256> t{};
+            for (int c = '0'; c <= '9'; ++c) t[c] = true;
+            for (int c = 'a'; c <= 'z'; ++c) t[c] = true;
+            for (int c = 'A'; c <= 'Z'; ++c) t[c] = true;
+            for (char c: std::string_view("!#$%&'*+-.^_`|~")) t[static_cast<unsigned char>(c)] = true;
+            return t;
+        }
+
+        constexpr std::array<bool, 256> kTchar = make_tchar_table();
+
+        bool is_token(std::string_view s) {
+            if (s.empty()) return false;
+            for (char c: s) {
+                if (!kTchar[static_cast<unsigned char>(c)]) return false;
+            }
+            return true;
+        }
+
+        // lower 必须是小写
+        bool iequals(std::string_view s, std::string_view lower) {
+            if (s.size() != lower.size()) return false;
+            for (size_t i = 0; i < s.size(); ++i) {
+                char c = s[i];
+                if (c >= 'A' && c <= 'Z') c = static_cast<char>(c + 32);
+                if (c != lower[i]) return false;
+            }
+            return true;
+        }
+
+        std::string_view trim_ows(std::string_view s) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+            return s;
+        }
+    }
+
+    const char *find_ctl(const char *p, const char *end) {
+#if defined(__AVX2__)
+        const __m256i k1f_32 = _mm256_set1_epi8(0x1f);
+        const __m256i k7f_32 = _mm256_set1_epi8(0x7f);
+        while (end - p >= 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            // 无符号 v <= 0x1f 等价于 min(v, 0x1f) == v
+            __m256i ctl = _mm256_cmpeq_epi8(_mm256_min_epu8(v, k1f_32), v);
+            __m256i del = _mm256_cmpeq_epi8(v, k7f_32);
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(ctl, del)));
+            if (mask) return p + __builtin_ctz(mask);
+            p += 32;
+        }
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+        const __m128i k1f = _mm_set1_epi8(0x1f);
+        const __m128i k7f = _mm_set1_epi8(0x7f);
+        while (end - p >= 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            __m128i ctl = _mm_cmpeq_epi8(_mm_min_epu8(v, k1f), v);
+            __m128i del = _mm_cmpeq_epi8(v, k7f);
+            int mask = _mm_movemask_epi8(_mm_or_si128(ctl, del));
+            if (mask) return p + __builtin_ctz(static_cast<unsigned>(mask));
+            p += 16;
+        }
+#elif defined(__ARM_NEON)
+        const uint8x16_t k1f = vdupq_n_u8(0x1f);
+        const uint8x16_t k7f = vdupq_n_u8(0x7f);
+        while (end - p >= 16) {
+            uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+            uint8x16_t hit = vorrq_u8(vcleq_u8(v, k1f), vceqq_u8(v, k7f));
+            // 每个字节压成 4 bit，得到 64 位掩码
+            uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+            if (mask) return p + (__builtin_ctzll(mask) >> 2);
+            p += 16;
+        }
+#endif
+        for (; p < end; ++p) {
+            auto c = static_cast<unsigned char>(*p);
+            if (c < 0x20 || c == 0x7f) return p;
+        }
+        return end;
+    }
+
+    HttpParser::Status HttpParser::feed(std::string_view buf) {
+        if (state_ == State::Done) return Status::Done;
+        if (state_ == State::Error) return Status::Error;
+
+        const char *base = buf.data();
+        const char *end = base + buf.size();
+        while (true) {
+            // 一次扫描同时完成两件事：找行尾 + 拒绝非法控制字符
+            const char *p = find_ctl(base + scan_, end);
+            if (p == end) {
+                scan_ = buf.size();
+                return Status::Incomplete;
+            }
+            if (*p == '\t') {
+                // Header 值里允许出现 HTAB，请求行与 Header 名由各自的校验拒绝
+                scan_ = static_cast<size_t>(p - base) + 1;
+                continue;
+            }
+            if (*p != '\r') break; // 裸 \n 或其他控制字符
+            if (p + 1 == end) {
+                scan_ = static_cast<size_t>(p - base); // \r 之后的 \n 还没到
+                return Status::Incomplete;
+            }
+            if (p[1] != '\n') break;
+
+            size_t line_end = static_cast<size_t>(p - base);
+            auto line_base = static_cast<uint32_t>(line_start_);
+            std::string_view line(base + line_start_, line_end - line_start_);
+            line_start_ = scan_ = line_end + 2;
+
+            if (state_ == State::RequestLine) {
+                // RFC 7230 3.5：请求行之前的空行可以忽略（有些客户端在 POST Body 后多发一个 CRLF）
+                if (line.empty()) continue;
+                if (!parse_request_line(line, line_base)) break;
+                state_ = State::HeaderLine;
+            } else {
+                if (line.empty()) {
+                    header_size_ = scan_;
+                    state_ = State::Done;
+                    return Status::Done;
+                }
+                if (!parse_header_line(line, line_base)) break;
+            }
+        }
+        state_ = State::Error;
+        return Status::Error;
+    }
+
+    bool HttpParser::parse_request_line(std::string_view line, uint32_t base) {
+        // "GET /user?id=1 HTTP/1.1"
+        size_t m_end = line.find(' ');
+        if (m_end == std::string_view::npos) return false;
+        size_t p_end = line.find(' ', m_end + 1);
+        if (p_end == std::string_view::npos || p_end == m_end + 1) return false;
+
+        std::string_view method = line.substr(0, m_end);
+        std::string_view target = line.substr(m_end + 1, p_end - m_end - 1);
+        std::string_view version = line.substr(p_end + 1);
+        if (!is_token(method)) return false;
+        if (target.find('\t') != std::string_view::npos) return false;
+        if (version.size() != 8 || version.substr(0, 7) != "HTTP/1." || version[7] < '0' || version[7] > '9') {
+            return false;
+        }
+
+        method_ = {base, static_cast<uint32_t>(m_end)};
+        target_ = {base + static_cast<uint32_t>(m_end + 1), static_cast<uint32_t>(target.size())};
+        version_ = {base + static_cast<uint32_t>(p_end + 1), static_cast<uint32_t>(version.size())};
+        return true;
+    }
+
+    bool HttpParser::parse_header_line(std::string_view line, uint32_t base) {
+        // 折行 (obs-fold) 已被 RFC 7230 废弃，直接拒绝
+        if (line.front() == ' ' || line.front() == '\t') return false;
+        if (field_count_ >= kMaxFields) return false;
+
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) return false;
+        std::string_view name = line.substr(0, colon);
+        if (!is_token(name)) return false; // 也拒绝了冒号前的空白
+
+        std::string_view value = trim_ows(line.substr(colon + 1));
+        auto value_off = static_cast<uint32_t>(value.empty() ? line.size() : value.data() - line.data());
+        fields_[field_count_++] = {{base, static_cast<uint32_t>(colon)},
+                                   {base + value_off, static_cast<uint32_t>(value.size())}};
+
+        // 与消息边界有关的 Header 在这一遍里直接解析，大小写不敏感
+        if (iequals(name, "content-length")) {
+            if (value.empty()) return false;
+            size_t len = 0;
+            for (char c: value) {
+                if (c < '0' || c > '9') return false;
+                if (len > (SIZE_MAX - 9) / 10) return false;
+                len = len * 10 + static_cast<size_t>(c - '0');
+            }
+            // 重复且不一致的 Content-Length 是请求走私的典型手法
+            if (has_content_length_ && len != content_length_) return false;
+            content_length_ = len;
+            has_content_length_ = true;
+        } else if (iequals(name, "transfer-encoding")) {
+            size_t comma = value.rfind(',');
+            std::string_view last = trim_ows(comma == std::string_view::npos ? value : value.substr(comma + 1));
+            chunked_ = iequals(last, "chunked");
+        }
+        return true;
+    }
+}
@@ -0,0 +1,399 @@
+#include "web/protocol/json_reader.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "web/protocol/json_writer.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace gee {
+    namespace {
+        int hex_value(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        bool read_hex4(std::string_view s, size_t i, uint32_t &out) {
+            if (i + 4 > s.size()) return false;
+            out = 0;
+            for (size_t k = i; k < i + 4; ++k) {
+                int v = hex_value(s[k]);
+                if (v < 0) return false;
+                out = (out << 4) | static_cast<uint32_t>(v);
+            }
+            return true;
+        }
+
+        void append_utf8(std::string &out, uint32_t cp) {
+            if (cp < 0x80) {
+                out.push_back(static_cast<char>(cp));
+            } else if (cp < 0x800) {
+                out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else if (cp < 0x10000) {
+                out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else {
+                out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            }
+        }
+
+        bool is_digit(char c) { return c >= '0' && c <= '9'; }
+    }
+
+    JsonReader::Type JsonReader::peek() {
+        if (!ok()) return Type::Invalid;
+        skip_ws();
+        if (pos_ >= s_.size()) return Type::Invalid;
+        switch (s_[pos_]) {
+            case '{': return Type::Object;
+            case '[': return Type::Array;
+            case '"': return Type::String;
+            case 't':
+            case 'f': return Type::Bool;
+            case 'n': return Type::Null;
+            default: return (s_[pos_] == '-' || is_digit(s_[pos_])) ? Type::Number : Type::Invalid;
+        }
+    }
+
+    bool JsonReader::expect(char c) {
+        skip_ws();
+        if (pos_ < s_.size() && s_[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    bool JsonReader::push(bool object) {
+        if (depth_ >= kMaxDepth) return fail("nesting too deep");
+        uint64_t bit = 1ULL << depth_;
+        object_bits_ = object ? (object_bits_ | bit) : (object_bits_ & ~bit);
+        first_bits_ |= bit;
+        ++depth_;
+        return true;
+    }
+
+    bool JsonReader::begin_object() {
+        if (!ok()) return false;
+        if (!expect('{')) return fail("object expected");
+        return push(true);
+    }
+
+    bool JsonReader::begin_array() {
+        if (!ok()) return false;
+        if (!expect('[')) return fail("array expected");
+        return push(false);
+    }
+
+    bool JsonReader::next_item(char close) {
+        if (!ok()) return false;
+        if (depth_ == 0) return fail("not inside a container");
+        uint64_t bit = 1ULL << (depth_ - 1);
+        if (((object_bits_ & bit) != 0) != (close == '}')) return fail("container type mismatch");
+        skip_ws();
+        if (pos_ >= s_.size()) return fail("unexpected end of input");
+        if (s_[pos_] == close) {
+            ++pos_;
+            --depth_;
+            return false;
+        }
+        if (first_bits_ & bit) {
+            first_bits_ &= ~bit;
+        } else {
+            if (s_[pos_] != ',') return fail("',' expected");
+            ++pos_;
+            skip_ws();
+        }
+        return true;
+    }
+
+    bool JsonReader::next_key(std::string_view &key) {
+        if (!next_item('}')) return false;
+        if (pos_ >= s_.size() || s_[pos_] != '"') return fail("key expected");
+        std::string_view raw;
+        bool has_escape = false;
+        if (!scan_string(raw, has_escape)) return false;
+        if (has_escape) {
+            key_buf_.clear();
+            if (!unescape(raw, key_buf_)) return fail("bad escape in key");
+            key = key_buf_;
+        } else {
+            key = raw;
+        }
+        if (!expect(':')) return fail("':' expected");
+        return true;
+    }
+
+    bool JsonReader::next_element() {
+        return next_item(']');
+    }
+
+    bool JsonReader::scan_string(std::string_view &raw, bool &has_escape) {
+        const char *p = s_.data();
+        size_t n = s_.size();
+        size_t i = pos_ + 1;
+        while (true) {
+            size_t j = detail::find_escape(p, i, n);
+            if (j == n) return fail("unterminated string");
+            char c = p[j];
+            if (c == '"') {
+                raw = s_.substr(pos_ + 1, j - pos_ - 1);
+                pos_ = j + 1;
+                return true;
+            }
+            if (c != '\\') return fail("control character in string");
+            // 转义序列在 unescape 时再校验，这里只跳过被转义的字符
+            has_escape = true;
+            i = j + 2;
+            if (i > n) return fail("unterminated string");
+        }
+    }
+
+    bool JsonReader::read_raw(std::string_view &out) {
+        if (!ok()) return false;
+        skip_ws();
+        if (pos_ >= s_.size() || s_[pos_] != '"') return fail("string expected");
+        bool has_escape = false;
+        return scan_string(out, has_escape);
+    }
+
+    bool JsonReader::read(std::string &out) {
+        if (!ok()) return false;
+        skip_ws();
+        if (pos_ >= s_.size() || s_[pos_] != '"') return fail("string expected");
+        std::string_view raw;
+        bool has_escape = false;
+        if (!scan_string(raw, has_escape)) return false;
+        if (!has_escape) {
+            out.assign(raw.data(), raw.size());
+            return true;
+        }
+        out.clear();
+        return unescape(raw, out) || fail("bad escape in string");
+    }
+
+    bool JsonReader::unescape(std::string_view raw, std::string &out) {
+        out.reserve(out.size() + raw.size());
+        size_t i = 0;
+        while (i < raw.size()) {
+            const void *hit = std::memchr(raw.data() + i, '\\', raw.size() - i);
+            size_t j = hit ? static_cast<size_t>(static_cast<const char *>(hit) - raw.data()) : raw.size();
+            out.append(raw.data() + i, j - i);
+            if (j == raw.size()) break;
+            if (j + 1 >= raw.size()) return false;
+            char e = raw[j + 1];
+            i = j + 2;
+            switch (e) {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u': {
+                    uint32_t cp;
+                    if (!read_hex4(raw, i, cp)) return false;
+                    i += 4;
+                    if (cp >= 0xDC00 && cp <= 0xDFFF) return false; // 落单的低位代理
+                    if (cp >= 0xD800 && cp <= 0xDBFF) {
+                        // 高位代理后面必须紧跟 \uDC00-\uDFFF
+                        uint32_t lo;
+                        if (i + 2 > raw.size() || raw[i] != '\\' || raw[i + 1] != 'u'
+                            || !read_hex4(raw, i + 2, lo) || lo < 0xDC00 || lo > 0xDFFF) {
+                            return false;
+                        }
+                        i += 6;
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    }
+                    append_utf8(out, cp);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    bool JsonReader::read(bool &out) {
+        if (!ok()) return false;
+        skip_ws();
+        std::string_view rest = s_.substr(pos_);
+        if (rest.substr(0, 4) == "true") {
+            out = true;
+            pos_ += 4;
+            return true;
+        }
+        if (rest.substr(0, 5) == "false") {
+            out = false;
+            pos_ += 5;
+            return true;
+        }
+        return fail("bool expected");
+    }
+
+    bool JsonReader::read_null() {
+        if (!ok()) return false;
+        skip_ws();
+        if (s_.substr(pos_, 4) != "null") return fail("null expected");
+        pos_ += 4;
+        return true;
+    }
+
+    bool JsonReader::number(std::string_view &out) {
+        if (!ok()) return false;
+        skip_ws();
+        const size_t n = s_.size();
+        size_t i = pos_;
+        if (i < n && s_[i] == '-') ++i;
+        if (i < n && s_[i] == '0') {
+            ++i;
+        } else if (i < n && is_digit(s_[i])) {
+            while (i < n && is_digit(s_[i])) ++i;
+        } else {
+            return fail("number expected");
+        }
+        if (i < n && s_[i] == '.') {
+            ++i;
+            if (i >= n || !is_digit(s_[i])) return fail("digit expected after '.'");
+            while (i < n && is_digit(s_[i])) ++i;
+        }
+        if (i < n && (s_[i] == 'e' || s_[i] == 'E')) {
+            ++i;
+            if (i < n && (s_[i] == '+' || s_[i] == '-')) ++i;
+            if (i >= n || !is_digit(s_[i])) return fail("digit expected in exponent");
+            while (i < n && is_digit(s_[i])) ++i;
+        }
+        out = s_.substr(pos_, i - pos_);
+        pos_ = i;
+        return true;
+    }
+
+    bool JsonReader::read(double &out) {
+        std::string_view num;
+        if (!number(num)) return false;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        auto [end, ec] = std::from_chars(num.data(), num.data() + num.size(), out);
+        if (ec != std::errc() || end != num.data() + num.size()) return fail("number out of range");
+#else
+        // 标准库还没有浮点 from_chars（老版本 libc++）时拷到栈上用 strtod
+        char buf[64];
+        if (num.size() >= sizeof(buf)) return fail("number too long");
+        std::memcpy(buf, num.data(), num.size());
+        buf[num.size()] = '\0';
+        out = std::strtod(buf, nullptr);
+#endif
+        return true;
+    }
+
+    bool JsonReader::skip() {
+        switch (peek()) {
+            case Type::String: {
+                std::string_view raw;
+                return read_raw(raw);
+            }
+            case Type::Number: {
+                std::string_view num;
+                return number(num);
+            }
+            case Type::Bool: {
+                bool b;
+                return read(b);
+            }
+            case Type::Null:
+                return read_null();
+            case Type::Object:
+            case Type::Array: {
+                // 跳过的部分只做括号配对，字符串里的括号不算
+                int depth = 0;
+                while (pos_ < s_.size()) {
+                    char c = s_[pos_];
+                    if (c == '"') {
+                        std::string_view raw;
+                        bool has_escape = false;
+                        if (!scan_string(raw, has_escape)) return false;
+                        continue;
+                    }
+                    if (c == '{' || c == '[') {
+                        ++depth;
+                    } else if (c == '}' || c == ']') {
+                        if (--depth == 0) {
+                            ++pos_;
+                            return true;
+                        }
+                    }
+                    ++pos_;
+                }
+                return fail("unexpected end of input");
+            }
+            default:
+                return fail("value expected");
+        }
+    }
+
+    bool JsonReader::end() {
+        if (!ok()) return false;
+        skip_ws();
+        return pos_ == s_.size() || fail("trailing characters");
+    }
+
+    bool JsonReader::valid_utf8(std::string_view s) {
+        const auto *p = reinterpret_cast<const unsigned char *>(s.data());
+        const size_t n = s.size();
+        size_t i = 0;
+        while (i < n) {
+#if defined(__SSE2__)
+            while (i + 16 <= n) {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+                if (_mm_movemask_epi8(x) != 0) break; // 有字节最高位为 1
+                i += 16;
+            }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+            while (i + 16 <= n && vmaxvq_u8(vld1q_u8(p + i)) < 0x80) i += 16;
+#endif
+            if (i >= n) break;
+            unsigned char c = p[i];
+            if (c < 0x80) {
+                ++i;
+                continue;
+            }
+            // 多字节序列：排除过长编码、代理区与超过 U+10FFFF 的码点
+            size_t len;
+            unsigned char lo = 0x80, hi = 0xBF; // 第二个字节的合法范围
+            if (c >= 0xC2 && c <= 0xDF) {
+                len = 2;
+            } else if (c >= 0xE0 && c <= 0xEF) {
+                len = 3;
+                if (c == 0xE0) lo = 0xA0;
+                if (c == 0xED) hi = 0x9F;
+            } else if (c >= 0xF0 && c <= 0xF4) {
+                len = 4;
+                if (c == 0xF0) lo = 0x90;
+                if (c == 0xF4) hi = 0x8F;
+            } else {
+                return false;
+            }
+            if (i + len > n) return false;
+            if (p[i + 1] < lo || p[i + 1] > hi) return false;
+            for (size_t k = 2; k < len; ++k) {
+                if ((p[i + k] & 0xC0) != 0x80) return false;
+            }
+            i += len;
+        }
+        return true;
+    }
+}
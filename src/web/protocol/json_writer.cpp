@@ -0,0 +1,166 @@
+#include "web/protocol/json_writer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace gee {
+    namespace {
+        // 0 表示原样输出，'u' 表示 \u00XX，其余是 \ 后面的字符
+        constexpr char kEscape[256] = {
+            'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+            'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+            0, 0, '"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '\\', 0, 0, 0,
+        };
+    }
+
+    namespace detail {
+        // 8 个字节里有没有 < 0x20、'"' 或 '\\'
+        static inline bool word_needs_escape(uint64_t w) {
+            constexpr uint64_t kOnes = 0x0101010101010101ULL;
+            constexpr uint64_t kHigh = 0x8080808080808080ULL;
+            uint64_t q = w ^ (kOnes * '"');
+            uint64_t b = w ^ (kOnes * '\\');
+            uint64_t hit = ((w - kOnes * 0x20) & ~w) | ((q - kOnes) & ~q) | ((b - kOnes) & ~b);
+            return (hit & kHigh) != 0;
+        }
+
+        // 返回 [i, n) 中第一个需要转义的位置，没有则返回 n
+        size_t find_escape(const char *s, size_t i, size_t n) {
+#if defined(__SSE2__)
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i slash = _mm_set1_epi8('\\');
+            const __m128i ctrl = _mm_set1_epi8(0x1F);
+            auto scan = [&](size_t at) {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + at));
+                // 无符号 x <= 0x1F 等价于 max(x, 0x1F) == 0x1F
+                __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, slash)),
+                                         _mm_cmpeq_epi8(_mm_max_epu8(x, ctrl), ctrl));
+                return static_cast<unsigned>(_mm_movemask_epi8(m));
+            };
+            if (n - i >= 16) {
+                for (; i + 16 <= n; i += 16) {
+                    unsigned mask = scan(i);
+                    if (mask != 0) return i + static_cast<size_t>(__builtin_ctz(mask));
+                }
+                if (i == n) return n;
+                // 剩余不足 16 字节：与前一批重叠着再读一次，重叠部分已确认无需转义
+                unsigned mask = scan(n - 16);
+                return mask ? n - 16 + static_cast<size_t>(__builtin_ctz(mask)) : n;
+            }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+            const uint8x16_t quote = vdupq_n_u8('"');
+            const uint8x16_t slash = vdupq_n_u8('\\');
+            const uint8x16_t space = vdupq_n_u8(0x20);
+            auto hit = [&](size_t at) {
+                uint8x16_t x = vld1q_u8(reinterpret_cast<const uint8_t *>(s + at));
+                uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(x, quote), vceqq_u8(x, slash)), vcltq_u8(x, space));
+                return vmaxvq_u8(m) != 0;
+            };
+            if (n - i >= 16) {
+                for (; i + 16 <= n; i += 16) {
+                    if (hit(i)) break; // 命中的这一批交给下面逐字节找
+                }
+                if (i == n || (i + 16 > n && !hit(n - 16))) return n;
+            }
+#endif
+            // 短字符串按 8 字节一组快速排除，最后一组与前面重叠
+            if (n - i >= 8) {
+                uint64_t w;
+                for (; i + 8 <= n; i += 8) {
+                    std::memcpy(&w, s + i, 8);
+                    if (word_needs_escape(w)) break;
+                }
+                if (i == n) return n;
+                if (i + 8 > n) {
+                    std::memcpy(&w, s + n - 8, 8);
+                    if (!word_needs_escape(w)) return n;
+                }
+            }
+            for (; i < n; ++i) {
+                if (kEscape[static_cast<unsigned char>(s[i])]) return i;
+            }
+            return n;
+        }
+    }
+
+    // 从 s[i] 开始转义到结尾（不含引号）
+    static void escape_from(std::string &out, const char *p, size_t i, size_t n) {
+        static const char kHex[] = "0123456789abcdef";
+        while (i < n) {
+            size_t j = detail::find_escape(p, i, n);
+            out.append(p + i, j - i);
+            if (j == n) break;
+            unsigned char c = static_cast<unsigned char>(p[j]);
+            char e = kEscape[c];
+            if (e == 'u') {
+                char u[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF]};
+                out.append(u, sizeof(u));
+            } else {
+                char esc[2] = {'\\', e};
+                out.append(esc, sizeof(esc));
+            }
+            i = j + 1;
+        }
+    }
+
+    void JsonWriter::escape(std::string &out, std::string_view s) {
+        out.push_back('"');
+        escape_from(out, s.data(), 0, s.size());
+        out.push_back('"');
+    }
+
+    void JsonWriter::put_string(std::string_view s, char suffix) {
+        const char *p = s.data();
+        size_t n = s.size();
+        size_t j = detail::find_escape(p, 0, n);
+        if (j == n && n <= 60) {
+            // 最常见的情况：短字符串无需转义，连同逗号、引号、冒号在栈上拼好一次追加
+            char buf[64];
+            char *w = buf;
+            if (need_comma_) *w++ = ',';
+            *w++ = '"';
+            std::memcpy(w, p, n);
+            w += n;
+            *w++ = '"';
+            if (suffix) *w++ = suffix;
+            out_.append(buf, static_cast<size_t>(w - buf));
+            return;
+        }
+        sep();
+        out_.push_back('"');
+        out_.append(p, j);
+        escape_from(out_, p, j, n);
+        out_.push_back('"');
+        if (suffix) out_.push_back(suffix);
+    }
+
+    JsonWriter &JsonWriter::value(double d) {
+        sep();
+        need_comma_ = true;
+        if (!std::isfinite(d)) {
+            out_.append("null");
+            return *this;
+        }
+        char buf[32];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        // 最短的可往返表示
+        auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), d);
+        out_.append(buf, end);
+#else
+        // 标准库还没有浮点 to_chars（老版本 libc++）时退回 %.17g
+        int len = std::snprintf(buf, sizeof(buf), "%.17g", d);
+        out_.append(buf, static_cast<size_t>(len));
+#endif
+        return *this;
+    }
+}
@@ -0,0 +1,173 @@
+#include "web/protocol/output_queue.h"
+
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <climits>
+#include <cerrno>
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
+#include "runtime/netpoller.h"
+
+namespace gee {
+#ifdef IOV_MAX
+    static constexpr size_t kMaxIov = IOV_MAX;
+#else
+    static constexpr size_t kMaxIov = 1024;
+#endif
+
+    // 内核发送缓冲区满了，挂起并在切出之后注册可写事件
+    static void wait_writable(int fd) {
+        auto g = runtime::Goroutine::current();
+        runtime::Goroutine::park(runtime::ParkReason::NetWrite, [fd, g]() {
+            runtime::Netpoller::get().watch(fd, runtime::IOEvent::Write, g);
+        });
+    }
+
+    bool OutputQueue::send_file(int fd, const Chunk &c, size_t offset) {
+        while (offset < c.ext_len) {
+            size_t want = c.ext_len - offset;
+            off_t pos = c.file_off + static_cast<off_t>(offset);
+            ssize_t n;
+#if defined(__linux__)
+            n = ::sendfile(fd, c.file_fd, &pos, want);
+#elif defined(__APPLE__)
+            // macOS 的 sendfile 参数顺序相反，EAGAIN 时 len 里仍是已写出的字节数
+            off_t len = static_cast<off_t>(want);
+            int r = ::sendfile(c.file_fd, fd, pos, &len, nullptr, 0);
+            n = len > 0 ? static_cast<ssize_t>(len) : r;
+#else
+            // 没有 sendfile 的平台退回 pread + write
+            char buf[64 * 1024];
+            ssize_t got = ::pread(c.file_fd, buf, std::min(want, sizeof(buf)), pos);
+            if (got <= 0) return false;
+            n = ::write(fd, buf, static_cast<size_t>(got));
+            if (n > 0 && n < got) {
+                offset += static_cast<size_t>(n);
+                continue;
+            }
+#endif
+            if (n > 0) {
+                offset += static_cast<size_t>(n);
+            } else if (n == 0) {
+                return false; // 文件被截断
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                wait_writable(fd);
+            } else if (errno != EINTR) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool OutputQueue::flush(int fd) {
+        if (sink_) return sink_(*this);
+
+        size_t idx = 0; // 当前未写完的第一块
+        size_t offset = 0; // 该块内已写出的字节数
+        bool ok = true;
+
+        while (idx < chunks_.size()) {
+            if (chunks_[idx].is_file()) {
+                if (!send_file(fd, chunks_[idx], offset)) {
+                    ok = false;
+                    break;
+                }
+                ++idx;
+                offset = 0;
+                continue;
+            }
+
+            // 攒到下一个文件区间为止
+            iovec iov[64];
+            int cnt = 0;
+            size_t limit = std::min<size_t>(kMaxIov, 64);
+            for (size_t i = idx; i < chunks_.size() && static_cast<size_t>(cnt) < limit; ++i) {
+                if (chunks_[i].is_file()) break;
+                size_t skip = (i == idx) ? offset : 0;
+                if (chunks_[i].size() == skip) continue;
+                iov[cnt].iov_base = const_cast<char *>(chunks_[i].data()) + skip;
+                iov[cnt].iov_len = chunks_[i].size() - skip;
+                ++cnt;
+            }
+            if (cnt == 0) {
+                ++idx;
+                offset = 0;
+                continue;
+            }
+
+            ssize_t n = ::writev(fd, iov, cnt);
+            if (n > 0) {
+                // 按实际写出的字节数推进 (idx, offset)
+                size_t left = static_cast<size_t>(n);
+                while (left > 0 && idx < chunks_.size()) {
+                    size_t remain = chunks_[idx].size() - offset;
+                    if (left >= remain) {
+                        left -= remain;
+                        ++idx;
+                        offset = 0;
+                    } else {
+                        offset += left;
+                        left = 0;
+                    }
+                }
+            } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                wait_writable(fd);
+            } else if (n == -1 && errno == EINTR) {
+                continue;
+            } else {
+                ok = false; // 真正的 Socket 错误或对端关闭
+                break;
+            }
+        }
+
+        chunks_.clear();
+        bytes_ = 0;
+        responses_ = 0;
+        return ok;
+    }
+
+    bool OutputQueue::copy_since(size_t first, std::string &dst) const {
+        size_t total = 0;
+        for (size_t i = first; i < chunks_.size(); ++i) {
+            if (chunks_[i].is_file()) return false;
+            total += chunks_[i].size();
+        }
+        dst.reserve(dst.size() + total);
+        for (size_t i = first; i < chunks_.size(); ++i) dst.append(chunks_[i].data(), chunks_[i].size());
+        return true;
+    }
+
+    bool OutputQueue::drain(const std::function<bool(std::string_view)> &fn) {
+        bool ok = true;
+        std::string buf;
+        for (const Chunk &c: chunks_) {
+            if (!c.is_file()) {
+                ok = fn(std::string_view(c.data(), c.size()));
+            } else {
+                buf.resize(std::min<size_t>(c.ext_len, 64 * 1024));
+                size_t done = 0;
+                while (ok && done < c.ext_len) {
+                    size_t want = std::min(buf.size(), c.ext_len - done);
+                    ssize_t n = ::pread(c.file_fd, &buf[0], want, c.file_off + static_cast<off_t>(done));
+                    if (n <= 0) {
+                        ok = false;
+                        break;
+                    }
+                    done += static_cast<size_t>(n);
+                    ok = fn(std::string_view(buf.data(), static_cast<size_t>(n)));
+                }
+            }
+            if (!ok) break;
+        }
+
+        chunks_.clear();
+        bytes_ = 0;
+        responses_ = 0;
+        return ok;
+    }
+}
@@ -0,0 +1,121 @@
+#include "web/protocol/read_buffer.h"
+
+#include <cstring>
+#include <new>
+#include <unistd.h>
+
+namespace gee {
+    // 16K 覆盖绝大多数请求；大于 16M 的直接向系统申请，用完即还
+    const size_t SlabPool::kClassSize[kClassCount] = {
+        16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024, 16 * 1024 * 1024
+    };
+    const size_t SlabPool::kClassKeep[kClassCount] = {256, 32, 8, 2, 0, 0};
+
+    SlabPool &SlabPool::local() {
+        static thread_local SlabPool pool;
+        return pool;
+    }
+
+    int SlabPool::class_of(size_t cap) {
+        for (int i = 0; i < kClassCount; ++i) {
+            if (cap <= kClassSize[i]) return i;
+        }
+        return -1;
+    }
+
+    Slab *SlabPool::acquire(size_t min_cap) {
+        int cls = class_of(min_cap);
+        if (cls >= 0 && free_[cls]) {
+            Slab *s = free_[cls];
+            free_[cls] = s->next;
+            --count_[cls];
+            return s;
+        }
+        size_t cap = cls >= 0 ? kClassSize[cls] : min_cap;
+        auto *s = static_cast<Slab *>(::operator new(sizeof(Slab) + cap));
+        s->cap = cap;
+        s->next = nullptr;
+        return s;
+    }
+
+    void SlabPool::release(Slab *slab) {
+        if (!slab) return;
+        int cls = class_of(slab->cap);
+        if (cls >= 0 && kClassSize[cls] == slab->cap && count_[cls] < kClassKeep[cls]) {
+            slab->next = free_[cls];
+            free_[cls] = slab;
+            ++count_[cls];
+            return;
+        }
+        ::operator delete(slab);
+    }
+
+    SlabPool::~SlabPool() {
+        for (auto &head: free_) {
+            while (head) {
+                Slab *next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    }
+
+    void ReadBuffer::reserve(size_t n) {
+        if (slab_ && slab_->cap - rpos_ >= n) return;
+
+        size_t len = size();
+        if (slab_ && slab_->cap >= n) {
+            // 容量够，只是前面有已消费的空洞：把剩余的少量字节挪到开头
+            std::memmove(slab_->data(), slab_->data() + rpos_, len);
+        } else {
+            Slab *bigger = SlabPool::local().acquire(n);
+            if (len > 0) std::memcpy(bigger->data(), slab_->data() + rpos_, len);
+            SlabPool::local().release(slab_);
+            slab_ = bigger;
+        }
+        rpos_ = 0;
+        wpos_ = len;
+    }
+
+    ssize_t ReadBuffer::read_from(int fd) {
+        if (!slab_) {
+            slab_ = SlabPool::local().acquire(0);
+            rpos_ = wpos_ = 0;
+        }
+        if (wpos_ == slab_->cap) {
+            // 写满了：前面的空洞够大就就地压缩，否则换到大一级的 slab
+            reserve(rpos_ >= slab_->cap / 2 ? slab_->cap : slab_->cap * 2);
+        }
+        ssize_t n = ::read(fd, slab_->data() + wpos_, slab_->cap - wpos_);
+        if (n > 0) wpos_ += static_cast<size_t>(n);
+        return n;
+    }
+
+    void ReadBuffer::consume(size_t n) {
+        if (n >= size()) {
+            release();
+            return;
+        }
+        rpos_ += n;
+    }
+
+    void ReadBuffer::erase(size_t off, size_t n) {
+        if (off >= size() || n == 0) return;
+        size_t tail = size() - off;
+        if (n >= tail) {
+            wpos_ = rpos_ + off;
+            return;
+        }
+        char *p = slab_->data() + rpos_ + off;
+        std::memmove(p, p + n, tail - n);
+        wpos_ -= n;
+    }
+
+    void ReadBuffer::release() {
+        if (slab_) {
+            SlabPool::local().release(slab_);
+            slab_ = nullptr;
+        }
+        rpos_ = wpos_ = 0;
+    }
+}
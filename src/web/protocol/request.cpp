@@ -1,6 +1,7 @@
 #pragma once
 #include "web/protocol/request.h"
 #include <charconv>
+#include <strings.h>
 #include <iostream>
 #include "web/protocol/MultipartProcessor.h"
 #include "../../../include/pool/io_task_pool.h"
@@ -8,25 +9,36 @@
 
 namespace gee {
     bool Request::parse(int client_fd) {
+        return read_header(client_fd) && read_body(client_fd);
+    }
+
+    bool Request::read_header(int client_fd) {
         const size_t MAX_HEADER_SIZE = 8192;
-        // 普通请求的限制，文件上传可以单独放开
-        const size_t MAX_NORMAL_BODY_SIZE = 10 * 1024 * 1024;
 
-        //   Header
+        //   Header：解析器记住上次扫描到的位置，每次读到新数据只处理新增的字节
         while (true) {
-            size_t header_end_pos = find_header_end();
-            if (header_end_pos != std::string_view::npos) {
-                this->header_size = header_end_pos + 4;
-                break;
-            }
+            auto status = parser_.feed(raw_data_.view());
+            if (status == HttpParser::Status::Done) break;
+            if (status == HttpParser::Status::Error) return false;
             if (raw_data_.size() > MAX_HEADER_SIZE) return false;
-            if (web_read(client_fd, this->raw_data_) <= 0) return false;
+            if (web_read(client_fd) <= 0) return false;
         }
 
-        if (!do_parse_header(this->header_size)) return false;
+        apply_header();
+        return true;
+    }
+
+    bool Request::read_body(int client_fd) {
+        // 普通请求的限制，文件上传可以单独放开
+        const size_t MAX_NORMAL_BODY_SIZE = 10 * 1024 * 1024;
+
+        std::string_view ct = get_header(HeaderId::ContentType);
 
-        this->content_length = peek_content_length();
-        std::string_view ct = get_header("Content-Type");
+        // 分块编码的请求体交给 BodyReader 边读边解码；Handler 没读完的部分由连接循环丢弃
+        if (parser_.chunked()) {
+            body_deferred_ = true;
+            return true;
+        }
 
         //文件的处理
         if (ct.find("multipart/form-data") != std::string_view::npos) {
@@ -34,14 +46,20 @@ namespace gee {
         } else {
             // 表单，json的处理
             if (this->content_length > 0) {
-                if (this->content_length > MAX_NORMAL_BODY_SIZE) return false;
+                // 超过缓冲上限的 Body 不再拒绝，改为流式读取
+                if (this->content_length > MAX_NORMAL_BODY_SIZE) {
+                    body_deferred_ = true;
+                    return true;
+                }
 
-                // 只有普通请求才预分配内存
+                // 只有普通请求才预分配：整个报文放不下时搬到大一级的 slab，之后的读不再搬移
+                const char *old_base = raw_data_.data();
                 this->raw_data_.reserve(this->header_size + this->content_length);
+                rebase_views(old_base);
 
                 // 继续原有的 while 循环读完 Body...
                 while (raw_data_.size() < this->header_size + this->content_length) {
-                    if (web_read(client_fd, this->raw_data_) <= 0) return false;
+                    if (web_read(client_fd) <= 0) return false;
                 }
                 this->body = std::string_view(raw_data_.data() + this->header_size, this->content_length);
                 parse_body();
@@ -50,36 +68,74 @@ namespace gee {
         return true;
     }
 
+    bool Request::keep_alive() const {
+        std::string_view conn = get_header(HeaderId::Connection);
+
+        if (version == "HTTP/1.0") return header_has_token(conn, "keep-alive");
+        return !header_has_token(conn, "close");
+    }
+
+    bool Request::buffered_request_ready() {
+        // 用的就是下一个请求自己的解析器：这里解析过的部分 read_header 不会再扫一遍
+        if (parser_.feed(raw_data_.view()) != HttpParser::Status::Done) return false;
+        // 分块编码或 multipart 这类需要流式读取的请求，交给 read_body 慢慢读
+        if (parser_.chunked()) return false;
+        return raw_data_.size() >= parser_.header_size() + parser_.content_length();
+    }
+
+    void Request::reset() {
+        // 只丢弃本次请求占用的字节，流水线客户端提前发来的数据留在缓冲区；
+        // 流式读取的 Body 读出时已经从缓冲区删掉了
+        raw_data_.consume(header_size + (body_deferred_ ? 0 : content_length));
+        parser_.reset();
+        body_deferred_ = false;
+
+        method = {};
+        path = {};
+        version = {};
+        body = {};
+        headers.clear();
+        content_length = 0;
+        header_size = 0;
+        post_form_.clear();
+        query_params_.clear();
+        uploaded_files_.clear();
+        json_body_.clear();
+    }
+
     bool Request::handle_multipart_streaming(int client_fd) {
-        std::string_view ct = get_header("Content-Type");
+        // 流式读取不保证停在报文边界，处理完就关闭连接
+        reusable_ = false;
+        std::string_view ct = get_header(HeaderId::ContentType);
         std::string boundary = extract_boundary(ct);
         if (boundary.empty()) return false;
 
         MultipartProcessor processor(boundary, "./uploads/", &gee::IOTaskPool::instance());
 
         // 2. 处理初始残留数据
-        std::string_view initial_body(raw_data_.data() + header_size, raw_data_.size() - header_size);
+        std::string_view initial_body = raw_data_.view().substr(header_size);
         if (!initial_body.empty()) {
             processor.feed(initial_body);
         }
 
         size_t total_received = initial_body.size();
-        std::vector<char> stream_buffer;
-        stream_buffer.reserve(128 * 1024); // 适当加大缓冲区，减少 web_read 次数
+        // Header 之后的数据都交给了 processor，只保留 Header（method/path 还指向这里），
+        // 后续直接读进同一个 slab 的 Header 之后
+        raw_data_.truncate(header_size);
 
         while (total_received < content_length) {
             // A. 协程在 web_read 这里会 yield，让出 CPU
-            ssize_t n = web_read(client_fd, stream_buffer);
+            ssize_t n = web_read(client_fd);
             if (n <= 0) break;
 
             // B. feed 内部不再执行 current_file_.write()
             // 而是执行 io_pool.addTask(...)
-            if (!processor.feed(std::string_view(stream_buffer.data(), stream_buffer.size()))) {
+            if (!processor.feed(raw_data_.view().substr(header_size))) {
                 return false;
             }
 
-            total_received += stream_buffer.size();
-            stream_buffer.clear();
+            total_received += static_cast<size_t>(n);
+            raw_data_.truncate(header_size);
         }
 
         // 告知处理器：数据流结束了，可能需要执行最后的 fsync
@@ -113,23 +169,14 @@ namespace gee {
     }
 
 
-    std::string_view Request::get_header(const std::string &key) const {
-        auto it = headers.find(key);
-        if (it != headers.end()) {
-            return it->second;
-        }
-        return ""; // 或者返回 std::string_view()
-    }
-
     void Request::parse_body() {
         if (method != "POST" && method != "PUT" && method != "PATCH") return;
         if (body.empty()) return;
 
-        auto it = headers.find("Content-Type");
-        if (it == headers.end()) {
+        std::string_view content_type = get_header(HeaderId::ContentType);
+        if (content_type.empty()) {
             return;
         }
-        std::string_view content_type = it->second;
 
         //  处理传统表单 (application/x-www-form-urlencoded)
         std::cout << content_type << std::endl;
@@ -191,51 +238,52 @@ namespace gee {
         return res;
     }
 
-    size_t Request::peek_content_length() {
-        // 将已读到的 Header 数据转为 string_view 方便查找
-        std::string_view header_view(raw_data_.data(), raw_data_.size());
-
-        // 查找 "Content-Length:" 关键字 (忽略大小写)
-        // 注意：实际开发中 Content-Length 可能大小写混合，这里简单演示
-        static const std::string target = "Content-Length:";
-        size_t pos = 0;
-
-        // 简单的查找逻辑
-        // 提示：生产环境建议用更严谨的忽略大小写匹配
-        pos = header_view.find(target);
-        if (pos == std::string_view::npos) {
-            // 再试一下小写版本
-            pos = header_view.find("content-length:");
-        }
-
-        if (pos != std::string_view::npos) {
-            size_t val_start = pos + target.size();
-            // 找到数字的起始位置（跳过空格）
-            while (val_start < header_view.size() && header_view[val_start] == ' ') {
-                val_start++;
-            }
-
-            // 找到数字的结束位置 (\r)
-            size_t val_end = header_view.find("\r", val_start);
-            if (val_end != std::string_view::npos) {
-                std::string_view val_sv = header_view.substr(val_start, val_end - val_start);
+    void Request::rebase_views(const char *old_base) {
+        rebase_views(old_base, raw_data_.data());
+    }
 
-                // 使用 charconv 快速转数字，或者直接用 atoi
-                size_t length = 0;
-                auto [ptr, ec] = std::from_chars(val_sv.data(), val_sv.data() + val_sv.size(), length);
-                if (ec == std::errc()) {
-                    return length;
-                }
+    void Request::rebase_views(const char *old_base, const char *new_base) {
+        if (old_base == new_base) return;
+        auto rebase = [&](std::string_view &v) {
+            if (v.data() >= old_base && v.data() <= old_base + header_size) {
+                v = std::string_view(new_base + (v.data() - old_base), v.size());
             }
-        }
-        return 0; // 没找到或解析失败，默认为 0
+        };
+        rebase(method);
+        rebase(path);
+        rebase(version);
+        headers.rebase(old_base, header_size, new_base);
     }
 
+    void Request::detach_header(std::string &storage) {
+        storage.assign(raw_data_.data(), header_size);
+        rebase_views(raw_data_.data(), storage.data());
+        raw_data_.consume(header_size);
+        header_size = 0;
+    }
 
-    // 辅助：查找 \r\n\r\n
-    size_t Request::find_header_end() {
-        std::string_view sv(raw_data_.data(), raw_data_.size());
-        return sv.find("\r\n\r\n");
+    void Request::clone_header(const Request &src, std::string &storage) {
+        size_t total = src.method.size() + src.path.size() + src.version.size();
+        src.headers.for_each([&](std::string_view name, std::string_view value) {
+            total += name.size() + value.size();
+        });
+        // 一次预留够，追加时不会搬家，已经生成的视图一直有效
+        storage.clear();
+        storage.reserve(total);
+        auto keep = [&storage](std::string_view v) {
+            size_t at = storage.size();
+            storage.append(v);
+            return std::string_view(storage.data() + at, v.size());
+        };
+        method = keep(src.method);
+        path = keep(src.path);
+        version = keep(src.version);
+        headers.clear();
+        src.headers.for_each([&](std::string_view name, std::string_view value) {
+            std::string_view n = keep(name);
+            headers.add(n, keep(value));
+        });
+        query_params_ = src.query_params_;
     }
 
     void Request::parse_query_string(std::string_view query) {
@@ -260,23 +308,16 @@ namespace gee {
         }
     }
 
-    bool Request::do_parse_header(size_t total_header_size) {
-        this->header_size = total_header_size;
-        std::string_view full_data(raw_data_.data(), total_header_size);
-
-        // --- 1. 解析请求行 (e.g., "GET /user?id=1 HTTP/1.1") ---
-        size_t line_end = full_data.find("\r\n");
-        if (line_end == std::string_view::npos) return false;
-        std::string_view request_line = full_data.substr(0, line_end);
+    void Request::apply_header() {
+        std::string_view data = raw_data_.view();
+        this->header_size = parser_.header_size();
+        this->content_length = parser_.content_length();
 
-        size_t m_end = request_line.find(' ');
-        size_t p_end = request_line.find(' ', m_end + 1);
-        if (m_end == std::string_view::npos || p_end == std::string_view::npos) return false;
-
-        this->method = request_line.substr(0, m_end);
+        this->method = parser_.method().in(data);
+        this->version = parser_.version().in(data);
 
         // 关键逻辑：切分 Path 和 Query String
-        std::string_view full_path = request_line.substr(m_end + 1, p_end - m_end - 1);
+        std::string_view full_path = parser_.target().in(data);
         size_t question_mark = full_path.find('?');
         if (question_mark != std::string_view::npos) {
             this->path = full_path.substr(0, question_mark); // 纯净路径给 Trie 树
@@ -286,54 +327,25 @@ namespace gee {
             this->path = full_path;
         }
 
-        // --- 2. 逐行解析 Header Fields ---
-        size_t pos = line_end + 2;
-        while (pos < total_header_size) {
-            size_t next_line = full_data.find("\r\n", pos);
-            if (next_line == std::string_view::npos) break;
-
-            std::string_view line = full_data.substr(pos, next_line - pos);
-            if (line.empty()) break; // 遇到空行说明 Header 结束
-
-            size_t colon = line.find(':');
-            if (colon != std::string_view::npos) {
-                std::string_view key_view = line.substr(0, colon);
-                std::string_view value_view = line.substr(colon + 1);
-                auto trim = [](std::string_view s) {
-                    size_t first = s.find_first_not_of(" \t\r\n");
-                    if (first == std::string_view::npos) return std::string_view();
-                    size_t last = s.find_last_not_of(" \t\r\n");
-                    return s.substr(first, (last - first + 1));
-                };
-
-                std::string key = std::string(trim(key_view));
-                std::string value = std::string(trim(value_view));
-
-                this->headers[key] = value;
-                if (strcasecmp(key.c_str(), "Content-Length") == 0) {
-                    std::from_chars(value.data(), value.data() + value.size(), this->content_length);
-                }
-            }
-            pos = next_line + 2;
+        for (size_t i = 0; i < parser_.field_count(); ++i) {
+            const auto &field = parser_.field(i);
+            this->headers.add(field.name.in(data), field.value.in(data));
         }
-
-        return true;
     }
 
-    ssize_t Request::web_read(int fd, std::vector<char> &buffer) {
-        char temp[4096];
-        ssize_t n = ::read(fd, temp, sizeof(temp));
+    ssize_t Request::web_read(int fd) {
+        ssize_t n = raw_data_.read_from(fd);
         if (n > 0) {
-            buffer.insert(buffer.end(), temp, temp + n);
             return n;
         } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-            // 关键点：数据还没到，挂起协程
+            // 关键点：数据还没到，挂起协程；切出之后再注册，防止事件先到、被另一个 Worker 在切出前 resume
             auto g = runtime::Goroutine::current();
-            runtime::Netpoller::get().watch_read_web(fd, g);
-            runtime::Goroutine::yield();
+            runtime::Goroutine::park(runtime::ParkReason::NetRead, [fd, g]() {
+                runtime::Netpoller::get().watch_read_web(fd, g);
+            });
 
             // 被唤醒后，递归调一次自己，去读新到的数据
-            return web_read(fd, buffer);
+            return web_read(fd);
         }
         return n; // 0 或 -1 (错误)
     }
@@ -0,0 +1,161 @@
+#include "web/protocol/response.h"
+
+#include <charconv>
+#include <ctime>
+
+#include "web/protocol/json_writer.h"
+
+namespace gee {
+    namespace {
+        constexpr std::string_view kKeepAlive = "Connection: keep-alive\r\n";
+        constexpr std::string_view kClose = "Connection: close\r\n";
+        constexpr std::string_view kJsonSuffix = "}";
+        constexpr std::string_view kVaryEncoding = "Vary: Accept-Encoding\r\n";
+
+        // 常用状态行预先渲染好，其余按需拼接
+        std::string_view status_line(int code) {
+            switch (code) {
+                case 200: return "HTTP/1.1 200 OK\r\n";
+                case 204: return "HTTP/1.1 204 No Content\r\n";
+                case 206: return "HTTP/1.1 206 Partial Content\r\n";
+                case 301: return "HTTP/1.1 301 Moved Permanently\r\n";
+                case 302: return "HTTP/1.1 302 Found\r\n";
+                case 304: return "HTTP/1.1 304 Not Modified\r\n";
+                case 400: return "HTTP/1.1 400 Bad Request\r\n";
+                case 401: return "HTTP/1.1 401 Unauthorized\r\n";
+                case 403: return "HTTP/1.1 403 Forbidden\r\n";
+                case 404: return "HTTP/1.1 404 Not Found\r\n";
+                case 405: return "HTTP/1.1 405 Method Not Allowed\r\n";
+                case 408: return "HTTP/1.1 408 Request Timeout\r\n";
+                case 413: return "HTTP/1.1 413 Payload Too Large\r\n";
+                case 416: return "HTTP/1.1 416 Range Not Satisfiable\r\n";
+                case 426: return "HTTP/1.1 426 Upgrade Required\r\n";
+                case 429: return "HTTP/1.1 429 Too Many Requests\r\n";
+                case 500: return "HTTP/1.1 500 Internal Server Error\r\n";
+                case 503: return "HTTP/1.1 503 Service Unavailable\r\n";
+                default: return {};
+            }
+        }
+
+        void append_int(std::string &out, size_t v) {
+            char buf[24];
+            auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+            out.append(buf, end);
+        }
+    }
+
+    std::string_view http_date_header() {
+        thread_local time_t cached_sec = 0;
+        thread_local char buf[64];
+        thread_local size_t len = 0;
+
+        time_t now = ::time(nullptr);
+        if (now != cached_sec) {
+            struct tm tm;
+            gmtime_r(&now, &tm);
+            len = strftime(buf, sizeof(buf), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &tm);
+            cached_sec = now;
+        }
+        return {buf, len};
+    }
+
+    std::string format_http_date(time_t t) {
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        char buf[40];
+        size_t len = strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+        return std::string(buf, len);
+    }
+
+    void Response::write_head(OutputQueue &out, int http_code, std::string_view type_line,
+                              size_t content_length, std::string_view extra, std::string_view body_prefix) const {
+        // 状态行：不在预渲染表里的状态码单独拼一块
+        std::string_view line = status_line(http_code);
+        if (!line.empty()) {
+            out.push_static(line);
+        } else {
+            std::string custom("HTTP/1.1 ");
+            append_int(custom, static_cast<size_t>(http_code));
+            custom.append(" OK\r\n");
+            out.push(std::move(custom));
+        }
+        if (!type_line.empty()) out.push_static(type_line);
+        out.push_static(keep_alive ? kKeepAlive : kClose);
+
+        // 动态部分（Content-Length、Date、额外 Header、body 前缀）拼进一小块，减少 iovec 数量
+        std::string_view date = http_date_header();
+        std::string head;
+        head.reserve(24 + date.size() + extra.size() + 2 + body_prefix.size());
+        if (content_length != kNoLength) {
+            head.append("Content-Length: ");
+            append_int(head, content_length);
+            head.append("\r\n");
+        }
+        head.append(date).append(extra).append("\r\n").append(body_prefix);
+        out.push(std::move(head));
+    }
+
+    void Response::write_cached(OutputQueue &out, std::string_view head, std::string_view body,
+                                std::string_view extra, std::shared_ptr<const void> owner) const {
+        out.push_shared(head, owner);
+        out.push_static(keep_alive ? kKeepAlive : kClose);
+        std::string_view date = http_date_header();
+        std::string tail;
+        tail.reserve(date.size() + extra.size() + 2);
+        tail.append(date).append(extra).append("\r\n");
+        out.push(std::move(tail));
+        out.push_shared(body, std::move(owner));
+        out.end_response();
+    }
+
+    void Response::append_envelope_prefix(std::string &out, bool with_data) const {
+        out.reserve(out.size() + message.size() + 48);
+        out.append("{\"state\":");
+        char buf[16];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), state);
+        out.append(buf, end);
+        out.append(",\"message\":");
+        JsonWriter::escape(out, message);
+        if (with_data) out.append(",\"data\":");
+    }
+
+    bool Response::write_compressed(OutputQueue &out, int http_code, std::string_view type_line,
+                                    std::initializer_list<std::string_view> parts, size_t total) {
+        if (encoding == Encoding::Identity || total < compress_min) return false;
+
+        Deflater d(encoding, compress_level);
+        std::string z;
+        z.reserve(total / 4 + 64);
+        for (std::string_view p: parts) {
+            if (!d.write(p, z)) return false;
+        }
+        // 压不小就按原样发送
+        if (!d.finish(z) || z.size() >= total) return false;
+
+        write_head(out, http_code, type_line, z.size(), encoding_header(encoding));
+        out.push(std::move(z));
+        out.end_response();
+        return true;
+    }
+
+    void Response::write_to(OutputQueue &out, int http_code, std::string_view text) {
+        std::string_view vary = vary_encoding ? kVaryEncoding : std::string_view();
+        if (!text.empty()) {
+            if (write_compressed(out, http_code, kTextContentType, {text}, text.size())) return;
+            write_head(out, http_code, kTextContentType, text.size(), vary, text);
+            out.end_response();
+            return;
+        }
+
+        // JSON 外壳：{"state":200,"message":"...","data":<body>}，前缀与 Header 同块，body 移交不拷贝
+        std::string prefix;
+        append_envelope_prefix(prefix, !body_buffer.empty());
+
+        size_t content_len = prefix.size() + body_buffer.size() + kJsonSuffix.size();
+        if (write_compressed(out, http_code, kJsonContentType, {prefix, body_buffer, kJsonSuffix}, content_len)) return;
+        write_head(out, http_code, kJsonContentType, content_len, vary, prefix);
+        out.push(std::move(body_buffer));
+        out.push_static(kJsonSuffix);
+        out.end_response();
+    }
+}
@@ -0,0 +1,110 @@
+#include "web/protocol/response_stream.h"
+
+#include <cstdio>
+
+namespace gee {
+    ResponseStream::ResponseStream(OutputQueue &out, int fd, Response &res, int http_code,
+                                   std::string_view type_line, bool chunked, bool head_only, size_t flush_bytes)
+        : out_(out), fd_(fd), flush_bytes_(flush_bytes), chunked_(chunked), head_only_(head_only) {
+        // 不分块时只能靠关闭连接结束 body
+        if (!chunked_) res.keep_alive = false;
+
+        std::string extra;
+        if (chunked_) extra.append("Transfer-Encoding: chunked\r\n");
+        if (res.encoding != Encoding::Identity) {
+            z_ = std::make_unique<Deflater>(res.encoding, res.compress_level);
+            if (z_->ok()) {
+                extra.append(encoding_header(res.encoding));
+            } else {
+                z_.reset();
+            }
+        }
+        if (!z_ && res.vary_encoding && compressible_type(type_line)) extra.append("Vary: Accept-Encoding\r\n");
+        res.write_head(out_, http_code, type_line, Response::kNoLength, extra);
+        res.is_sent = true;
+        buf_.reserve(flush_bytes_ + flush_bytes_ / 4);
+    }
+
+    bool ResponseStream::emit(bool final) {
+        std::string payload;
+        if (z_) {
+            bool zok = z_->write(buf_, payload) && (final ? z_->finish(payload) : z_->sync(payload));
+            if (!zok) ok_ = false;
+            buf_.clear();
+        } else {
+            payload.swap(buf_);
+            buf_.reserve(flush_bytes_ + flush_bytes_ / 4);
+        }
+
+        if (!head_only_ && !payload.empty()) {
+            if (chunked_) {
+                push_chunk_head(payload.size());
+                out_.push(std::move(payload));
+                out_.push_static("\r\n");
+            } else {
+                out_.push(std::move(payload));
+            }
+        }
+        if (final) {
+            if (chunked_ && !head_only_) out_.push_static("0\r\n\r\n");
+            out_.end_response();
+            // 结束块留给连接循环，和后续流水线响应一起写
+            return ok_;
+        }
+        if (!out_.flush(fd_)) ok_ = false;
+        return ok_;
+    }
+
+    void ResponseStream::push_chunk_head(size_t n) {
+        char size_line[24];
+        int len = snprintf(size_line, sizeof(size_line), "%zx\r\n", n);
+        out_.push(std::string(size_line, static_cast<size_t>(len)));
+    }
+
+    void ResponseStream::write_shared(std::shared_ptr<const std::string> data) {
+        if (ended_ || !ok_ || data->empty()) return;
+        if (z_ || !buf_.empty()) {
+            buf_.append(*data);
+            return;
+        }
+        if (head_only_) return;
+        if (chunked_) push_chunk_head(data->size());
+        std::string_view view(*data);
+        out_.push_shared(view, std::move(data));
+        if (chunked_) out_.push_static("\r\n");
+    }
+
+    bool ResponseStream::flush() {
+        if (ended_ || !ok_) return false;
+        return emit(false);
+    }
+
+    bool ResponseStream::end() {
+        if (ended_) return ok_;
+        ended_ = true;
+        if (!ok_) return false;
+        return emit(true);
+    }
+
+    std::string sse_format(std::string_view data, std::string_view event, std::string_view id) {
+        std::string out;
+        out.reserve(data.size() + event.size() + id.size() + 24);
+        if (!id.empty()) {
+            out.append("id: ").append(id).push_back('\n');
+        }
+        if (!event.empty()) {
+            out.append("event: ").append(event).push_back('\n');
+        }
+        size_t pos = 0;
+        while (true) {
+            size_t nl = data.find('\n', pos);
+            std::string_view line = data.substr(pos, nl == std::string_view::npos ? std::string_view::npos : nl - pos);
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            out.append("data: ").append(line).push_back('\n');
+            if (nl == std::string_view::npos) break;
+            pos = nl + 1;
+        }
+        out.push_back('\n');
+        return out;
+    }
+}
@@ -0,0 +1,339 @@
+#include "web/protocol/websocket.h"
+
+#include <sys/socket.h>
+#include <cstring>
+
+#include "web/protocol/json_reader.h"
+#include "web/protocol/output_queue.h"
+#include "web/protocol/request.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace gee {
+    namespace {
+        constexpr std::string_view kGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+        // 小于这个长度的载荷和帧头拼成一块发送，大的按 iovec 借用调用方内存
+        constexpr size_t kInlinePayload = 1024;
+
+        uint32_t rol(uint32_t v, int n) { return (v << n) | (v >> (32 - n)); }
+
+        // 握手只用到一次，朴素实现即可
+        void sha1(std::string_view in, uint8_t out[20]) {
+            uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+            std::string msg(in);
+            uint64_t bits = static_cast<uint64_t>(in.size()) * 8;
+            msg.push_back(static_cast<char>(0x80));
+            while (msg.size() % 64 != 56) msg.push_back(0);
+            for (int i = 7; i >= 0; --i) msg.push_back(static_cast<char>(bits >> (i * 8)));
+
+            for (size_t off = 0; off < msg.size(); off += 64) {
+                uint32_t w[80];
+                const auto *p = reinterpret_cast<const uint8_t *>(msg.data() + off);
+                for (int i = 0; i < 16; ++i) {
+                    w[i] = (uint32_t(p[i * 4]) << 24) | (uint32_t(p[i * 4 + 1]) << 16)
+                           | (uint32_t(p[i * 4 + 2]) << 8) | uint32_t(p[i * 4 + 3]);
+                }
+                for (int i = 16; i < 80; ++i) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+                uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+                for (int i = 0; i < 80; ++i) {
+                    uint32_t f, k;
+                    if (i < 20) {
+                        f = (b & c) | (~b & d);
+                        k = 0x5A827999;
+                    } else if (i < 40) {
+                        f = b ^ c ^ d;
+                        k = 0x6ED9EBA1;
+                    } else if (i < 60) {
+                        f = (b & c) | (b & d) | (c & d);
+                        k = 0x8F1BBCDC;
+                    } else {
+                        f = b ^ c ^ d;
+                        k = 0xCA62C1D6;
+                    }
+                    uint32_t t = rol(a, 5) + f + e + k + w[i];
+                    e = d;
+                    d = c;
+                    c = rol(b, 30);
+                    b = a;
+                    a = t;
+                }
+                h[0] += a;
+                h[1] += b;
+                h[2] += c;
+                h[3] += d;
+                h[4] += e;
+            }
+            for (int i = 0; i < 5; ++i) {
+                out[i * 4] = static_cast<uint8_t>(h[i] >> 24);
+                out[i * 4 + 1] = static_cast<uint8_t>(h[i] >> 16);
+                out[i * 4 + 2] = static_cast<uint8_t>(h[i] >> 8);
+                out[i * 4 + 3] = static_cast<uint8_t>(h[i]);
+            }
+        }
+
+        std::string base64(const uint8_t *p, size_t n) {
+            static const char kTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            std::string out;
+            out.reserve((n + 2) / 3 * 4);
+            for (size_t i = 0; i < n; i += 3) {
+                uint32_t v = uint32_t(p[i]) << 16;
+                if (i + 1 < n) v |= uint32_t(p[i + 1]) << 8;
+                if (i + 2 < n) v |= p[i + 2];
+                out.push_back(kTable[(v >> 18) & 63]);
+                out.push_back(kTable[(v >> 12) & 63]);
+                out.push_back(i + 1 < n ? kTable[(v >> 6) & 63] : '=');
+                out.push_back(i + 2 < n ? kTable[v & 63] : '=');
+            }
+            return out;
+        }
+
+        // 对端可以发送的关闭状态码（RFC 6455 §7.4）
+        bool valid_close_code(uint16_t code) {
+            return (code >= 1000 && code <= 1003) || (code >= 1007 && code <= 1011) || (code >= 3000 && code <= 4999);
+        }
+    }
+
+    namespace detail {
+        void ws_unmask(char *data, size_t n, const uint8_t mask[4]) {
+            size_t i = 0;
+            // 批量宽度都是 4 的倍数，掩码在每一批里的相位不变
+            uint32_t m32;
+            std::memcpy(&m32, mask, 4);
+#if defined(__SSE2__)
+            const __m128i m = _mm_set1_epi32(static_cast<int>(m32));
+            for (; i + 64 <= n; i += 64) {
+                auto *p = reinterpret_cast<__m128i *>(data + i);
+                _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), m));
+                _mm_storeu_si128(p + 1, _mm_xor_si128(_mm_loadu_si128(p + 1), m));
+                _mm_storeu_si128(p + 2, _mm_xor_si128(_mm_loadu_si128(p + 2), m));
+                _mm_storeu_si128(p + 3, _mm_xor_si128(_mm_loadu_si128(p + 3), m));
+            }
+            for (; i + 16 <= n; i += 16) {
+                auto *p = reinterpret_cast<__m128i *>(data + i);
+                _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), m));
+            }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+            const uint8x16_t m = vreinterpretq_u8_u32(vdupq_n_u32(m32));
+            for (; i + 16 <= n; i += 16) {
+                auto *p = reinterpret_cast<uint8_t *>(data + i);
+                vst1q_u8(p, veorq_u8(vld1q_u8(p), m));
+            }
+#endif
+            uint64_t m64 = (static_cast<uint64_t>(m32) << 32) | m32;
+            for (; i + 8 <= n; i += 8) {
+                uint64_t w;
+                std::memcpy(&w, data + i, 8);
+                w ^= m64;
+                std::memcpy(data + i, &w, 8);
+            }
+            for (; i < n; ++i) data[i] = static_cast<char>(data[i] ^ mask[i & 3]);
+        }
+    }
+
+    bool WebSocket::is_upgrade_request(const Request &req) {
+        if (req.method != "GET" || req.version != "HTTP/1.1") return false;
+        if (!header_has_token(req.get_header(HeaderId::Upgrade), "websocket")) return false;
+        if (!header_has_token(req.get_header(HeaderId::Connection), "upgrade")) return false;
+        return req.get_header("Sec-WebSocket-Version") == "13" && !req.get_header("Sec-WebSocket-Key").empty();
+    }
+
+    std::string WebSocket::accept_key(std::string_view client_key) {
+        std::string src(client_key);
+        src.append(kGuid);
+        uint8_t digest[20];
+        sha1(src, digest);
+        return base64(digest, sizeof(digest));
+    }
+
+    bool WebSocket::fill() {
+        return req_.web_read(fd_) > 0;
+    }
+
+    bool WebSocket::read_frame_header(Frame &f) {
+        ReadBuffer &in = req_.raw_data_;
+        while (in.size() < 2) {
+            if (!fill()) return false;
+        }
+        auto b0 = static_cast<uint8_t>(in.data()[0]);
+        auto b1 = static_cast<uint8_t>(in.data()[1]);
+        // 没有协商扩展，RSV 位必须为 0；客户端的帧必须带掩码
+        if ((b0 & 0x70) || !(b1 & 0x80)) return fail(1002);
+        size_t ext = (b1 & 0x7F) == 126 ? 2 : (b1 & 0x7F) == 127 ? 8 : 0;
+        size_t need = 2 + ext + 4;
+        while (in.size() < need) {
+            if (!fill()) return false;
+        }
+        const auto *p = reinterpret_cast<const uint8_t *>(in.data());
+        f.fin = (b0 & 0x80) != 0;
+        f.opcode = static_cast<WSOpcode>(b0 & 0x0F);
+        f.len = b1 & 0x7F;
+        if (ext) {
+            f.len = 0;
+            for (size_t i = 0; i < ext; ++i) f.len = (f.len << 8) | p[2 + i];
+            if (f.len >> 63) return fail(1002);
+        }
+        std::memcpy(f.mask, p + 2 + ext, 4);
+        in.consume(need);
+        return true;
+    }
+
+    bool WebSocket::read_payload(const Frame &f, std::string &dst) {
+        ReadBuffer &in = req_.raw_data_;
+        size_t start = dst.size();
+        auto len = static_cast<size_t>(f.len);
+        dst.resize(start + len);
+        size_t got = 0;
+        while (got < len) {
+            if (in.empty() && !fill()) return false;
+            size_t n = std::min(in.size(), len - got);
+            std::memcpy(&dst[start + got], in.data(), n);
+            in.consume(n); // 读空时 slab 还给池子，空闲连接不占缓冲区
+            got += n;
+        }
+        detail::ws_unmask(&dst[start], len, f.mask);
+        return true;
+    }
+
+    bool WebSocket::read_message(WSMessage &msg) {
+        if (closed_) return false;
+        msg.data.clear();
+        bool in_message = false;
+        std::string control;
+
+        while (true) {
+            Frame f;
+            if (!read_frame_header(f)) {
+                closed_ = true;
+                if (close_code_ == 1005) close_code_ = 1006; // 没有 Close 帧就断开
+                return false;
+            }
+
+            if (static_cast<uint8_t>(f.opcode) & 0x8) {
+                // 控制帧可以夹在分片之间，不能分片，载荷不超过 125
+                if (!f.fin || f.len > 125) return fail(1002);
+                control.clear();
+                if (!read_payload(f, control)) {
+                    closed_ = true;
+                    close_code_ = 1006;
+                    return false;
+                }
+                switch (f.opcode) {
+                    case WSOpcode::Ping:
+                        send_frame(WSOpcode::Pong, control);
+                        continue;
+                    case WSOpcode::Pong:
+                        continue;
+                    case WSOpcode::Close: {
+                        uint16_t code = 1005;
+                        if (control.size() == 1) return fail(1002);
+                        if (control.size() >= 2) {
+                            code = static_cast<uint16_t>((uint8_t(control[0]) << 8) | uint8_t(control[1]));
+                            if (!valid_close_code(code)) return fail(1002);
+                            if (!JsonReader::valid_utf8(std::string_view(control).substr(2))) return fail(1007);
+                        }
+                        closed_ = true;
+                        close_code_ = code;
+                        // 原样回一个 Close 完成关闭握手
+                        close(code == 1005 ? 1000 : code);
+                        return false;
+                    }
+                    default:
+                        return fail(1002);
+                }
+            }
+
+            if (f.opcode == WSOpcode::Continuation) {
+                if (!in_message) return fail(1002);
+            } else if (f.opcode == WSOpcode::Text || f.opcode == WSOpcode::Binary) {
+                if (in_message) return fail(1002);
+                in_message = true;
+                msg.type = f.opcode;
+            } else {
+                return fail(1002);
+            }
+
+            if (f.len > config_.max_message - msg.data.size()) return fail(1009);
+            if (!read_payload(f, msg.data)) {
+                closed_ = true;
+                close_code_ = 1006;
+                return false;
+            }
+            if (f.fin) {
+                if (msg.is_text() && !JsonReader::valid_utf8(msg.data)) return fail(1007);
+                return true;
+            }
+        }
+    }
+
+    bool WebSocket::write_message(std::string_view data, WSOpcode type) {
+        return send_frame(type, data);
+    }
+
+    bool WebSocket::ping(std::string_view payload) {
+        if (payload.size() > 125) return false;
+        return send_frame(WSOpcode::Ping, payload);
+    }
+
+    void WebSocket::close(uint16_t code, std::string_view reason) {
+        std::string payload;
+        payload.push_back(static_cast<char>(code >> 8));
+        payload.push_back(static_cast<char>(code));
+        payload.append(reason.substr(0, 123));
+        send_frame(WSOpcode::Close, payload);
+    }
+
+    bool WebSocket::fail(uint16_t code) {
+        closed_ = true;
+        close_code_ = code;
+        close(code);
+        return false;
+    }
+
+    bool WebSocket::send_frame(WSOpcode op, std::string_view payload) {
+        // 服务端的帧不加掩码
+        char head[10];
+        size_t hl = 2;
+        head[0] = static_cast<char>(0x80 | static_cast<uint8_t>(op));
+        size_t n = payload.size();
+        if (n < 126) {
+            head[1] = static_cast<char>(n);
+        } else if (n <= 0xFFFF) {
+            head[1] = 126;
+            head[2] = static_cast<char>(n >> 8);
+            head[3] = static_cast<char>(n);
+            hl = 4;
+        } else {
+            head[1] = 127;
+            for (int i = 0; i < 8; ++i) head[2 + i] = static_cast<char>(static_cast<uint64_t>(n) >> (56 - 8 * i));
+            hl = 10;
+        }
+
+        write_mu_.lock();
+        if (close_sent_) {
+            write_mu_.unlock();
+            return false;
+        }
+        if (op == WSOpcode::Close) close_sent_ = true;
+        if (n <= kInlinePayload) {
+            std::string frame;
+            frame.reserve(hl + n);
+            frame.append(head, hl);
+            frame.append(payload.data(), n);
+            out_.push(std::move(frame));
+        } else {
+            // 大载荷不拷贝，writev 直接从调用方内存发出；flush 返回前 payload 一直有效
+            out_.push(std::string(head, hl));
+            out_.push_static(payload);
+        }
+        bool ok = out_.flush(fd_);
+        // 关闭握手：不再写，对端读到 EOF；读方向仍可收到对端的 Close
+        if (op == WSOpcode::Close) ::shutdown(fd_, SHUT_WR);
+        write_mu_.unlock();
+        return ok;
+    }
+}